@@ -0,0 +1,86 @@
+#include "adaptive_limit.h"
+
+#include <algorithm>
+
+namespace crequests {
+
+
+    namespace {
+
+        const double INITIAL_LIMIT = 8;
+        const double MIN_LIMIT = 1;
+        const double MAX_LIMIT = 1000;
+
+        /*
+          Latency up to this number of times of the idle one is flat.
+        */
+        const double TOLERANCE = 2;
+
+        const double BACKOFF_RATIO = 0.75;
+        const double MIN_GRADIENT = 0.5;
+
+        /*
+          Part of the new value in the smoothed limit after a slow request.
+        */
+        const double SMOOTHING = 0.2;
+
+        /*
+          The idle latency grows by this factor per request, so an old
+          minimum does not hold the limit down forever.
+        */
+        const double MIN_LATENCY_DRIFT = 1.001;
+
+    } /* anonymous namespace */
+
+
+    adaptive_limit_t::adaptive_limit_t()
+        : m_limit(INITIAL_LIMIT),
+          m_min_latency(0)
+    {
+
+    }
+
+    size_t adaptive_limit_t::limit() const {
+        return static_cast<size_t>(m_limit);
+    }
+
+    double adaptive_limit_t::min_latency() const {
+        return m_min_latency;
+    }
+
+    void adaptive_limit_t::sample(const milliseconds_t& latency,
+                                  const size_t inflight,
+                                  const bool dropped,
+                                  const size_t max_limit) {
+        const double upper = max_limit > 0
+            ? std::max(MIN_LIMIT, static_cast<double>(max_limit))
+            : MAX_LIMIT;
+
+        if (dropped) {
+            m_limit = std::max(MIN_LIMIT, m_limit * BACKOFF_RATIO);
+            m_limit = std::min(m_limit, upper);
+            return;
+        }
+
+        const double rtt = std::max(1.0, static_cast<double>(latency.count()));
+        if (m_min_latency <= 0 or rtt < m_min_latency)
+            m_min_latency = rtt;
+        else
+            m_min_latency *= MIN_LATENCY_DRIFT;
+
+        const double gradient = std::max(
+            MIN_GRADIENT, std::min(1.0, TOLERANCE * m_min_latency / rtt));
+
+        if (gradient < 1) {
+            const double target = m_limit * gradient;
+            m_limit = (1 - SMOOTHING) * m_limit + SMOOTHING * target;
+        }
+        else if (static_cast<double>(inflight) * 2 >= m_limit) {
+            m_limit += 1;
+        }
+
+        m_limit = std::max(MIN_LIMIT, std::min(m_limit, upper));
+    }
+
+
+} /* namespace crequests */
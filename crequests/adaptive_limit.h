@@ -0,0 +1,53 @@
+#ifndef ADAPTIVE_LIMIT_H
+#define ADAPTIVE_LIMIT_H
+
+#include "types.h"
+
+namespace crequests {
+
+
+    /*
+      Concurrency limit of one host which follows the latency of its
+      requests. The lowest latency seen is taken as the latency of an idle
+      host (it slowly drifts up to follow a moved baseline). While requests
+      are not slower than twice of it the limit grows by one per request,
+      when the host is busy enough to use the limit. Slower requests shrink
+      the limit by the gradient between the two latencies, and dropped ones
+      (timeouts, connection errors, 5xx) cut it by a quarter at once.
+      Not thread safe.
+    */
+    class adaptive_limit_t {
+    public:
+        adaptive_limit_t();
+
+    public:
+        /*
+          The current limit, at least 1.
+        */
+        size_t limit() const;
+
+        /*
+          Counts the request which is done. inflight is the number of
+          requests of the host which were running with it, max_limit
+          bounds the limit from above (0 means the default bound).
+        */
+        void sample(const milliseconds_t& latency,
+                    const size_t inflight,
+                    const bool dropped,
+                    const size_t max_limit);
+
+        /*
+          The latency of the idle host in milliseconds, 0 until
+          the first good request.
+        */
+        double min_latency() const;
+
+    private:
+        double m_limit;
+        double m_min_latency;
+    };
+
+
+} /* namespace crequests */
+
+#endif /* ADAPTIVE_LIMIT_H */
@@ -3,6 +3,7 @@
 
 #include "response.h"
 #include "asyncresponse.h"
+#include "completion_queue.h"
 #include "service.h"
 #include "session.h"
 
@@ -103,6 +104,131 @@ namespace crequests {
         set_option(session, std::forward<Args>(args)...);
         return session.AsyncHead();
     }
+
+    /*
+      Completion queue versions of the asynchronous functions.
+      The response is pushed into the queue with the given tag.
+    */
+
+    template <class ServiceT, class... Args>
+    void AsyncGet(ServiceT&& service,
+                  completion_queue_t queue,
+                  tag_t tag,
+                  Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        session.AsyncGet(queue, tag);
+    }
+
+    template <class ServiceT, class... Args>
+    void AsyncPost(ServiceT&& service,
+                   completion_queue_t queue,
+                   tag_t tag,
+                   Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        session.AsyncPost(queue, tag);
+    }
+
+    template <class ServiceT, class... Args>
+    void AsyncPut(ServiceT&& service,
+                  completion_queue_t queue,
+                  tag_t tag,
+                  Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        session.AsyncPut(queue, tag);
+    }
+
+    template <class ServiceT, class... Args>
+    void AsyncPatch(ServiceT&& service,
+                    completion_queue_t queue,
+                    tag_t tag,
+                    Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        session.AsyncPatch(queue, tag);
+    }
+
+    template <class ServiceT, class... Args>
+    void AsyncDelete(ServiceT&& service,
+                     completion_queue_t queue,
+                     tag_t tag,
+                     Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        session.AsyncDelete(queue, tag);
+    }
+
+    template <class ServiceT, class... Args>
+    void AsyncHead(ServiceT&& service,
+                   completion_queue_t queue,
+                   tag_t tag,
+                   Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        session.AsyncHead(queue, tag);
+    }
+
+    /*
+      Fire and forget versions of the asynchronous functions.
+      The response is moved into the completion handler and
+      no future is allocated for it.
+    */
+
+    template <class ServiceT, class... Args>
+    void AsyncGet(ServiceT&& service,
+                  completion_handler_t completion,
+                  Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        session.AsyncGet(completion);
+    }
+
+    template <class ServiceT, class... Args>
+    void AsyncPost(ServiceT&& service,
+                   completion_handler_t completion,
+                   Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        session.AsyncPost(completion);
+    }
+
+    template <class ServiceT, class... Args>
+    void AsyncPut(ServiceT&& service,
+                  completion_handler_t completion,
+                  Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        session.AsyncPut(completion);
+    }
+
+    template <class ServiceT, class... Args>
+    void AsyncPatch(ServiceT&& service,
+                    completion_handler_t completion,
+                    Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        session.AsyncPatch(completion);
+    }
+
+    template <class ServiceT, class... Args>
+    void AsyncDelete(ServiceT&& service,
+                     completion_handler_t completion,
+                     Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        session.AsyncDelete(completion);
+    }
+
+    template <class ServiceT, class... Args>
+    void AsyncHead(ServiceT&& service,
+                   completion_handler_t completion,
+                   Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        session.AsyncHead(completion);
+    }
     
 } /* namespace crequests */
 
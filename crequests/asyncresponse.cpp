@@ -17,8 +17,25 @@ namespace crequests {
 
         }
 
+        asyncrequest_impl_t(const future_t<response_t>& future,
+                            const std::function<void()>& on_drop)
+            : m_future{future},
+              m_on_drop{on_drop}
+        {
+
+        }
+
+        ~asyncrequest_impl_t()
+        {
+            const auto ready =
+                m_future.wait_for(seconds_t{0}) == std::future_status::ready;
+            if (m_on_drop and not ready)
+                m_on_drop();
+        }
+
     public:
         future_t<response_t> m_future;
+        std::function<void()> m_on_drop {};
     };    
 
     asyncresponse_t::asyncresponse_t(const future_t<response_t>& future)
@@ -32,6 +49,13 @@ namespace crequests {
         
     }
     
+    asyncresponse_t::asyncresponse_t(const future_t<response_t>& future,
+                                     const std::function<void()>& on_drop)
+        : m_pimpl{std::make_shared<asyncrequest_impl_t>(future, on_drop)}
+    {
+
+    }
+
     asyncresponse_t::asyncresponse_t(const asyncresponse_t& response)
         : m_pimpl{response.m_pimpl}
     {
@@ -11,6 +11,14 @@ namespace crequests {
     public:
         asyncresponse_t(const future_t<response_t>& future);
         asyncresponse_t(future_t<response_t>&& future);
+
+        /*
+          The drop callback is called when the last copy of the object
+          is destroyed and the response is not ready yet. It is used to
+          cancel requests which nobody waits for.
+        */
+        asyncresponse_t(const future_t<response_t>& future,
+                        const std::function<void()>& on_drop);
         asyncresponse_t(const asyncresponse_t& response);
         asyncresponse_t(asyncresponse_t&& response);
         asyncresponse_t& operator=(const asyncresponse_t& response);
@@ -0,0 +1,281 @@
+#include "batch.h"
+#include "boost_asio.h"
+#include "connection.h"
+#include "service.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace crequests {
+
+
+    /************************************************************
+     * batch_impl_t section.
+     ************************************************************/
+
+
+    class batch_impl_t : public std::enable_shared_from_this<batch_impl_t> {
+    public:
+        explicit batch_impl_t(const size_t size);
+        ~batch_impl_t();
+
+    public:
+        void start(service_t& service, const vector_t<request_t>& requests);
+        void push(const size_t index, response_t&& response);
+        vector_t<response_t> wait_all();
+        optional_t<completion_t> wait_any();
+        void cancel();
+        size_t size() const;
+        size_t done() const;
+
+    private:
+        mutable std::mutex mutex {};
+        std::condition_variable condition {};
+        vector_t<connection_t> connections {};
+        vector_t<bool> cancel_on_drop {};
+        vector_t<optional_t<response_t> > responses;
+        std::deque<size_t> completed {};
+        size_t m_done {0};
+        size_t taken {0};
+    };
+
+    batch_impl_t::batch_impl_t(const size_t size)
+        : responses(size)
+    {
+
+    }
+
+    batch_impl_t::~batch_impl_t()
+    {
+        for (size_t i = 0; i < connections.size(); ++i)
+            if (cancel_on_drop[i])
+                connections[i].cancel();
+    }
+
+    void batch_impl_t::start(service_t& service,
+                             const vector_t<request_t>& requests) {
+        const std::weak_ptr<batch_impl_t> weak = shared_from_this();
+
+        connections.reserve(requests.size());
+        cancel_on_drop.reserve(requests.size());
+        for (size_t i = 0; i < requests.size(); ++i) {
+            auto request = requests[i];
+            request.prepare();
+
+            /*
+              The batch owns its connections, so they refer back to it
+              weakly. Nobody waits for the responses of a dropped batch.
+            */
+            const auto completion = [weak, i](response_t&& response) {
+                if (const auto self = weak.lock())
+                    self->push(i, std::move(response));
+            };
+            connections.emplace_back(service, request, completion);
+            cancel_on_drop.push_back(request.cancel_on_drop());
+        }
+
+        /*
+          The whole batch is started by a single job of the service thread.
+        */
+        const auto self = shared_from_this();
+        service.get_service().post([self]() {
+            for (auto& connection : self->connections)
+                connection.start();
+        });
+    }
+
+    void batch_impl_t::push(const size_t index, response_t&& response) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            responses[index] = std::move(response);
+            completed.push_back(index);
+            m_done++;
+        }
+        condition.notify_all();
+    }
+
+    vector_t<response_t> batch_impl_t::wait_all() {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this]() {
+            return m_done == responses.size();
+        });
+
+        vector_t<response_t> result;
+        result.reserve(responses.size());
+        for (const auto& response : responses)
+            result.push_back(*response);
+
+        return result;
+    }
+
+    optional_t<completion_t> batch_impl_t::wait_any() {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (taken == responses.size())
+            return boost::none;
+
+        condition.wait(lock, [this]() {
+            return not completed.empty();
+        });
+
+        const auto index = completed.front();
+        completed.pop_front();
+        taken++;
+
+        return completion_t{tag_t{index}, response_t{*responses[index]}};
+    }
+
+    void batch_impl_t::cancel() {
+        for (const auto& connection : connections)
+            connection.cancel();
+    }
+
+    size_t batch_impl_t::size() const {
+        return responses.size();
+    }
+
+    size_t batch_impl_t::done() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return m_done;
+    }
+
+
+    /************************************************************
+     * batch_t section.
+     ************************************************************/
+
+
+    batch_t::batch_t(service_t& service, const vector_t<request_t>& requests)
+        : pimpl{std::make_shared<batch_impl_t>(requests.size())}
+    {
+        pimpl->start(service, requests);
+    }
+
+    batch_t::batch_t(const batch_t& batch)
+        : pimpl{batch.pimpl}
+    {
+
+    }
+
+    batch_t::batch_t(batch_t&& batch)
+        : pimpl{std::move(batch.pimpl)}
+    {
+        batch.pimpl = nullptr;
+    }
+
+    batch_t& batch_t::operator=(const batch_t& batch) {
+        if (this != &batch) {
+            pimpl = batch.pimpl;
+        }
+
+        return *this;
+    }
+
+    batch_t& batch_t::operator=(batch_t&& batch) {
+        if (this != &batch) {
+            pimpl = std::move(batch.pimpl);
+            batch.pimpl = nullptr;
+        }
+
+        return *this;
+    }
+
+    batch_t::~batch_t() {
+
+    }
+
+
+    /****************************************************************************
+     * Other functions.
+     ***************************************************************************/
+
+
+    vector_t<response_t> batch_t::wait_all() const {
+        return pimpl->wait_all();
+    }
+
+    optional_t<completion_t> batch_t::wait_any() const {
+        return pimpl->wait_any();
+    }
+
+    batch_t::range_t batch_t::as_completed() const {
+        return range_t{*this};
+    }
+
+    void batch_t::cancel() const {
+        pimpl->cancel();
+    }
+
+    size_t batch_t::size() const {
+        return pimpl->size();
+    }
+
+    size_t batch_t::done() const {
+        return pimpl->done();
+    }
+
+
+    /************************************************************
+     * batch_t::iterator_t section.
+     ************************************************************/
+
+
+    batch_t::iterator_t::iterator_t()
+    {
+
+    }
+
+    batch_t::iterator_t::iterator_t(const batch_t& batch)
+        : m_pimpl{batch.pimpl}
+    {
+        ++(*this);
+    }
+
+    completion_t& batch_t::iterator_t::operator*() {
+        return *m_completion;
+    }
+
+    completion_t* batch_t::iterator_t::operator->() {
+        return m_completion.get_ptr();
+    }
+
+    batch_t::iterator_t& batch_t::iterator_t::operator++() {
+        m_completion = m_pimpl->wait_any();
+        if (not m_completion)
+            m_pimpl = nullptr;
+
+        return *this;
+    }
+
+    bool batch_t::iterator_t::operator==(const iterator_t& it) const {
+        return m_pimpl == it.m_pimpl and
+            static_cast<bool>(m_completion) == static_cast<bool>(it.m_completion) and
+            (not m_completion or m_completion->tag() == it.m_completion->tag());
+    }
+
+    bool batch_t::iterator_t::operator!=(const iterator_t& it) const {
+        return not (*this == it);
+    }
+
+
+    /************************************************************
+     * batch_t::range_t section.
+     ************************************************************/
+
+
+    batch_t::range_t::range_t(const batch_t& batch)
+        : m_batch{batch}
+    {
+
+    }
+
+    batch_t::iterator_t batch_t::range_t::begin() const {
+        return iterator_t{m_batch};
+    }
+
+    batch_t::iterator_t batch_t::range_t::end() const {
+        return iterator_t{};
+    }
+
+
+} /* namespace crequests */
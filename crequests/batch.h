@@ -0,0 +1,116 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "completion_queue.h"
+#include "request.h"
+#include "response.h"
+#include "types.h"
+
+#include <cstddef>
+#include <iterator>
+
+namespace crequests {
+
+    class service_t;
+
+
+    /*
+      A group of requests sent at once by service_t::send_batch.
+      Results can be taken all together in the order of submission,
+      one by one in the order of completion or by iterating over
+      as_completed(). The tag of a completion is the index of its request.
+      Copies of the batch object share the same requests.
+    */
+    class batch_t {
+    public:
+        class iterator_t;
+        class range_t;
+
+    public:
+        batch_t(service_t& service, const vector_t<request_t>& requests);
+        batch_t(const batch_t& batch);
+        batch_t(batch_t&& batch);
+        batch_t& operator=(const batch_t& batch);
+        batch_t& operator=(batch_t&& batch);
+        ~batch_t();
+
+    public:
+        /*
+          Blocks until all requests are done and returns their responses
+          in the order of submission.
+        */
+        vector_t<response_t> wait_all() const;
+
+        /*
+          Blocks until some request is done which was not taken yet by
+          wait_any() and takes it. Returns nothing when all of them are
+          already taken.
+        */
+        optional_t<completion_t> wait_any() const;
+
+        /*
+          Range of completions in the order they are done. Iteration
+          blocks while the next one is not ready and takes them as
+          wait_any() does.
+        */
+        range_t as_completed() const;
+
+        /*
+          Aborts all requests which are not done yet. They are ended up
+          with the CANCELLED error.
+        */
+        void cancel() const;
+
+        /*
+          Number of requests in the batch and number of done ones.
+        */
+        size_t size() const;
+        size_t done() const;
+
+    private:
+        friend class batch_impl_t;
+        shared_ptr_t<class batch_impl_t> pimpl;
+    };
+
+
+    class batch_t::iterator_t {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = completion_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = completion_t*;
+        using reference = completion_t&;
+
+    public:
+        iterator_t();
+        explicit iterator_t(const batch_t& batch);
+
+    public:
+        completion_t& operator*();
+        completion_t* operator->();
+        iterator_t& operator++();
+        bool operator==(const iterator_t& it) const;
+        bool operator!=(const iterator_t& it) const;
+
+    private:
+        shared_ptr_t<class batch_impl_t> m_pimpl {};
+        optional_t<completion_t> m_completion {};
+    };
+
+
+    class batch_t::range_t {
+    public:
+        explicit range_t(const batch_t& batch);
+
+    public:
+        iterator_t begin() const;
+        iterator_t end() const;
+
+    private:
+        batch_t m_batch;
+    };
+
+
+} /* namespace crequests */
+
+#endif /* BATCH_H */
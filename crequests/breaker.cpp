@@ -0,0 +1,314 @@
+#include "breaker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace crequests {
+
+
+    namespace {
+
+        /*
+          Circuits of this number of hosts are kept, the one of the least
+          recently used host is forgotten first.
+        */
+        const size_t MAX_HOSTS = 1024;
+
+    } /* anonymous namespace */
+
+
+    /************************************************************
+     * breaker_impl_t section.
+     ************************************************************/
+
+
+    class breaker_impl_t {
+    public:
+        void failures(const size_t value);
+        void error_rate(const size_t value);
+        void window(const size_t value);
+        void open_time(const size_t value);
+        void probes(const size_t value);
+        bool enabled() const;
+        bool allow(const string_t& host, breaker_t::ticket_t& ticket);
+        void report(const string_t& host,
+                    const breaker_t::ticket_t ticket,
+                    const breaker_t::outcome_t outcome);
+        breaker_t::state_t state(const string_t& host) const;
+
+    private:
+        using lru_t = std::list<string_t>;
+
+        struct host_t {
+            breaker_t::state_t state {breaker_t::state_t::CLOSED};
+            size_t consecutive {0};
+            vector_t<bool> window {};
+            size_t next {0};
+            size_t failed {0};
+            time_point_t opened_at {};
+            size_t probes {0};
+            size_t passed {0};
+            breaker_t::ticket_t generation {0};
+            lru_t::iterator lru_it {};
+        };
+
+        using hosts_t = std::unordered_map<string_t, host_t>;
+
+    private:
+        void update_enabled();
+        host_t& touch(const string_t& host);
+        void touch(hosts_t::iterator it);
+        void record(host_t& host, const bool failure);
+        bool should_open(const host_t& host) const;
+        void open(host_t& host);
+        void close(host_t& host);
+
+    private:
+        mutable std::mutex mutex {};
+        std::atomic<bool> m_enabled {false};
+        size_t m_failures {0};
+        size_t m_error_rate {0};
+        size_t m_window {20};
+        size_t m_open_time {5000};
+        size_t m_probes {1};
+        breaker_t::ticket_t m_generation {0};
+        hosts_t hosts {};
+        lru_t lru {};
+    };
+
+    void breaker_impl_t::failures(const size_t value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        m_failures = value;
+        update_enabled();
+    }
+
+    void breaker_impl_t::error_rate(const size_t value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        m_error_rate = value;
+        update_enabled();
+    }
+
+    void breaker_impl_t::window(const size_t value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        m_window = std::max<size_t>(value, 1);
+        for (auto& host : hosts) {
+            host.second.window.clear();
+            host.second.next = 0;
+            host.second.failed = 0;
+        }
+    }
+
+    void breaker_impl_t::open_time(const size_t value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        m_open_time = value;
+    }
+
+    void breaker_impl_t::probes(const size_t value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        m_probes = std::max<size_t>(value, 1);
+    }
+
+    void breaker_impl_t::update_enabled() {
+        m_enabled = m_failures > 0 or m_error_rate > 0;
+    }
+
+    bool breaker_impl_t::enabled() const {
+        return m_enabled;
+    }
+
+    bool breaker_impl_t::allow(const string_t& host, breaker_t::ticket_t& ticket) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = hosts.find(host);
+        if (it == hosts.end()) {
+            ticket = 0;
+            return true;
+        }
+
+        touch(it);
+        auto& state = it->second;
+        switch (state.state) {
+        case breaker_t::state_t::CLOSED:
+            ticket = state.generation;
+            return true;
+
+        case breaker_t::state_t::OPEN:
+            if (steady_clock_t::now() - state.opened_at < milliseconds_t(m_open_time))
+                return false;
+            state.state = breaker_t::state_t::HALF_OPEN;
+            state.probes = 0;
+            state.passed = 0;
+            state.generation = ++m_generation;
+            /* fall through */
+
+        case breaker_t::state_t::HALF_OPEN:
+            if (state.probes + state.passed >= m_probes)
+                return false;
+            state.probes++;
+            ticket = state.generation;
+            return true;
+        }
+
+        return true;
+    }
+
+    void breaker_impl_t::report(const string_t& host,
+                                const breaker_t::ticket_t ticket,
+                                const breaker_t::outcome_t outcome) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        /*
+          Requests which were let through before the circuit changed its
+          state do not count anymore: a request of the closed circuit
+          is not a probe and a probe of an earlier half open round has
+          no slot to give back.
+        */
+        const auto it = hosts.find(host);
+        if (it != hosts.end() ? ticket != it->second.generation : ticket != 0)
+            return;
+
+        auto& state = touch(host);
+        if (state.state == breaker_t::state_t::HALF_OPEN) {
+            if (state.probes > 0)
+                state.probes--;
+
+            if (outcome == breaker_t::outcome_t::FAILURE)
+                open(state);
+            else if (outcome == breaker_t::outcome_t::SUCCESS and ++state.passed >= m_probes)
+                close(state);
+            return;
+        }
+
+        if (state.state == breaker_t::state_t::OPEN or
+            outcome == breaker_t::outcome_t::NEUTRAL)
+            return;
+
+        record(state, outcome == breaker_t::outcome_t::FAILURE);
+        if (should_open(state))
+            open(state);
+    }
+
+    breaker_impl_t::host_t& breaker_impl_t::touch(const string_t& host) {
+        const auto it = hosts.find(host);
+        if (it != hosts.end()) {
+            touch(it);
+            return it->second;
+        }
+
+        if (hosts.size() >= MAX_HOSTS) {
+            hosts.erase(lru.front());
+            lru.pop_front();
+        }
+
+        auto& state = hosts[host];
+        state.lru_it = lru.insert(lru.end(), host);
+        return state;
+    }
+
+    void breaker_impl_t::touch(hosts_t::iterator it) {
+        lru.splice(lru.end(), lru, it->second.lru_it);
+    }
+
+    void breaker_impl_t::record(host_t& host, const bool failure) {
+        host.consecutive = failure ? host.consecutive + 1 : 0;
+
+        if (host.window.size() < m_window) {
+            host.window.push_back(failure);
+        }
+        else {
+            if (host.window[host.next])
+                host.failed--;
+            host.window[host.next] = failure;
+        }
+        host.next = (host.next + 1) % m_window;
+
+        if (failure)
+            host.failed++;
+    }
+
+    bool breaker_impl_t::should_open(const host_t& host) const {
+        if (m_failures > 0 and host.consecutive >= m_failures)
+            return true;
+
+        return m_error_rate > 0 and
+            host.window.size() >= m_window and
+            host.failed * 100 >= m_error_rate * host.window.size();
+    }
+
+    void breaker_impl_t::open(host_t& host) {
+        host.state = breaker_t::state_t::OPEN;
+        host.opened_at = steady_clock_t::now();
+        host.probes = 0;
+        host.passed = 0;
+        host.generation = ++m_generation;
+    }
+
+    void breaker_impl_t::close(host_t& host) {
+        const auto lru_it = host.lru_it;
+        host = host_t{};
+        host.lru_it = lru_it;
+        host.generation = ++m_generation;
+    }
+
+    breaker_t::state_t breaker_impl_t::state(const string_t& host) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = hosts.find(host);
+        return it == hosts.end() ? breaker_t::state_t::CLOSED : it->second.state;
+    }
+
+
+    /************************************************************
+     * breaker_t section.
+     ************************************************************/
+
+
+    breaker_t::breaker_t()
+        : pimpl{std::make_shared<breaker_impl_t>()}
+    {
+
+    }
+
+    breaker_t::~breaker_t() {
+
+    }
+
+    void breaker_t::set_option(const breaker_failures_t& breaker_failures) {
+        pimpl->failures(breaker_failures.value());
+    }
+
+    void breaker_t::set_option(const breaker_error_rate_t& breaker_error_rate) {
+        pimpl->error_rate(breaker_error_rate.value());
+    }
+
+    void breaker_t::set_option(const breaker_window_t& breaker_window) {
+        pimpl->window(breaker_window.value());
+    }
+
+    void breaker_t::set_option(const breaker_open_time_t& breaker_open_time) {
+        pimpl->open_time(breaker_open_time.value());
+    }
+
+    void breaker_t::set_option(const breaker_probes_t& breaker_probes) {
+        pimpl->probes(breaker_probes.value());
+    }
+
+    bool breaker_t::enabled() const {
+        return pimpl->enabled();
+    }
+
+    bool breaker_t::allow(const string_t& host, ticket_t& ticket) {
+        return pimpl->allow(host, ticket);
+    }
+
+    void breaker_t::report(const string_t& host, const ticket_t ticket, const outcome_t outcome) {
+        pimpl->report(host, ticket, outcome);
+    }
+
+    breaker_t::state_t breaker_t::state(const string_t& host) const {
+        return pimpl->state(host);
+    }
+
+
+} /* namespace crequests */
@@ -0,0 +1,90 @@
+#ifndef BREAKER_H
+#define BREAKER_H
+
+#include "macros.h"
+#include "types.h"
+
+namespace crequests {
+
+
+    /*
+      Service options of the circuit breaker. A host circuit opens after
+      breaker_failures consecutive failures or when breaker_error_rate
+      percent of the last breaker_window requests failed (0 turns each
+      rule off, both are off by default). It stays open for breaker_open_time
+      milliseconds and then lets breaker_probes requests through: when all
+      of them succeed the circuit is closed, a failed one opens it again.
+    */
+    declare_number(breaker_failures, size_t)
+    declare_number(breaker_error_rate, size_t)
+    declare_number(breaker_window, size_t)
+    declare_number(breaker_open_time, size_t)
+    declare_number(breaker_probes, size_t)
+
+
+    /*
+      Circuit breakers of the hosts of a service. Requests to a host
+      with an open circuit fail at once with the CIRCUIT_OPEN error instead
+      of waiting for a connect error or a timeout. Can be used from any thread.
+    */
+    class breaker_t {
+    public:
+        enum class state_t {
+            CLOSED,
+            OPEN,
+            HALF_OPEN
+        };
+
+        enum class outcome_t {
+            SUCCESS,
+            FAILURE,
+
+            /*
+              The request tells nothing about the host (it was cancelled,
+              for example), only its probe is given back.
+            */
+            NEUTRAL
+        };
+
+        /*
+          The state of the circuit a request was allowed in.
+        */
+        using ticket_t = size_t;
+
+    public:
+        breaker_t();
+        breaker_t(const breaker_t& breaker) = delete;
+        breaker_t& operator=(const breaker_t& breaker) = delete;
+        ~breaker_t();
+
+    public:
+        void set_option(const breaker_failures_t& breaker_failures);
+        void set_option(const breaker_error_rate_t& breaker_error_rate);
+        void set_option(const breaker_window_t& breaker_window);
+        void set_option(const breaker_open_time_t& breaker_open_time);
+        void set_option(const breaker_probes_t& breaker_probes);
+
+        /*
+          Returns false when no rule is set, so there is nothing to check.
+        */
+        bool enabled() const;
+
+        /*
+          Returns false if a request to the host must fail at once.
+          Every allowed request has to be reported with its ticket when
+          it is done, reports of the earlier states of the circuit are ignored.
+        */
+        bool allow(const string_t& host, ticket_t& ticket);
+        void report(const string_t& host, const ticket_t ticket, const outcome_t outcome);
+
+        state_t state(const string_t& host) const;
+
+    private:
+        friend class breaker_impl_t;
+        shared_ptr_t<class breaker_impl_t> pimpl;
+    };
+
+
+} /* namespace crequests */
+
+#endif /* BREAKER_H */
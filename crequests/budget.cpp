@@ -0,0 +1,93 @@
+#include "budget.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace crequests {
+
+
+    namespace {
+
+        const double MAX_CREDITS = 10;
+
+    } /* anonymous namespace */
+
+
+    /************************************************************
+     * budget_impl_t section.
+     ************************************************************/
+
+
+    class budget_impl_t {
+    public:
+        explicit budget_impl_t(const size_t percent);
+
+    public:
+        void percent(const size_t percent);
+        void deposit();
+        bool withdraw();
+
+    private:
+        std::mutex mutex {};
+        double ratio;
+        double credits;
+    };
+
+    budget_impl_t::budget_impl_t(const size_t percent_)
+        : ratio(static_cast<double>(percent_) / 100),
+          credits(percent_ > 0 ? MAX_CREDITS : 0)
+    {
+
+    }
+
+    void budget_impl_t::percent(const size_t percent_) {
+        std::lock_guard<std::mutex> lock(mutex);
+        ratio = static_cast<double>(percent_) / 100;
+        if (ratio <= 0)
+            credits = 0;
+    }
+
+    void budget_impl_t::deposit() {
+        std::lock_guard<std::mutex> lock(mutex);
+        credits = std::min(MAX_CREDITS, credits + ratio);
+    }
+
+    bool budget_impl_t::withdraw() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (credits < 1)
+            return false;
+
+        credits -= 1;
+        return true;
+    }
+
+
+    /************************************************************
+     * budget_t section.
+     ************************************************************/
+
+
+    budget_t::budget_t(const size_t percent_)
+        : pimpl{std::make_shared<budget_impl_t>(percent_)}
+    {
+
+    }
+
+    budget_t::~budget_t() {
+
+    }
+
+    void budget_t::percent(const size_t percent_) {
+        pimpl->percent(percent_);
+    }
+
+    void budget_t::deposit() {
+        pimpl->deposit();
+    }
+
+    bool budget_t::withdraw() {
+        return pimpl->withdraw();
+    }
+
+
+} /* namespace crequests */
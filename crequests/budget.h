@@ -0,0 +1,36 @@
+#ifndef BUDGET_H
+#define BUDGET_H
+
+#include "types.h"
+
+namespace crequests {
+
+
+    /*
+      Budget of extra work (hedged copies, retries) which is earned by
+      the regular one: every request deposits the given percent of a
+      credit and every extra attempt withdraws a whole one. Up to ten
+      credits are kept, so a short burst is allowed after a calm period.
+      Can be used from any thread.
+    */
+    class budget_t {
+    public:
+        explicit budget_t(const size_t percent);
+        budget_t(const budget_t& budget) = delete;
+        budget_t& operator=(const budget_t& budget) = delete;
+        ~budget_t();
+
+    public:
+        void percent(const size_t percent);
+        void deposit();
+        bool withdraw();
+
+    private:
+        friend class budget_impl_t;
+        shared_ptr_t<class budget_impl_t> pimpl;
+    };
+
+
+} /* namespace crequests */
+
+#endif /* BUDGET_H */
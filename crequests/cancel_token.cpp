@@ -0,0 +1,147 @@
+#include "cancel_token.h"
+
+#include <map>
+#include <mutex>
+
+namespace crequests {
+
+
+    /************************************************************
+     * cancel_token_impl_t section.
+     ************************************************************/
+
+
+    class cancel_token_impl_t {
+    public:
+        void cancel();
+        bool is_cancelled() const;
+        size_t subscribe(const cancel_token_t::callback_t& callback);
+        void unsubscribe(const size_t id);
+
+    private:
+        mutable std::mutex mutex {};
+        std::map<size_t, cancel_token_t::callback_t> callbacks {};
+        size_t last_id {0};
+        bool cancelled {false};
+    };
+
+    void cancel_token_impl_t::cancel() {
+        std::map<size_t, cancel_token_t::callback_t> to_call;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (cancelled)
+                return;
+            cancelled = true;
+            to_call.swap(callbacks);
+        }
+
+        for (const auto& callback : to_call)
+            callback.second();
+    }
+
+    bool cancel_token_impl_t::is_cancelled() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return cancelled;
+    }
+
+    size_t cancel_token_impl_t::subscribe(const cancel_token_t::callback_t& callback) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (not cancelled) {
+                callbacks.emplace(++last_id, callback);
+                return last_id;
+            }
+        }
+
+        callback();
+        return 0;
+    }
+
+    void cancel_token_impl_t::unsubscribe(const size_t id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        callbacks.erase(id);
+    }
+
+
+    /************************************************************
+     * cancel_token_t section.
+     ************************************************************/
+
+
+    cancel_token_t::cancel_token_t()
+        : pimpl{std::make_shared<cancel_token_impl_t>()}
+    {
+
+    }
+
+    cancel_token_t::cancel_token_t(std::nullptr_t)
+        : pimpl{nullptr}
+    {
+
+    }
+
+    cancel_token_t::cancel_token_t(const cancel_token_t& token)
+        : pimpl{token.pimpl}
+    {
+
+    }
+
+    cancel_token_t::cancel_token_t(cancel_token_t&& token)
+        : pimpl{std::move(token.pimpl)}
+    {
+        token.pimpl = nullptr;
+    }
+
+    cancel_token_t& cancel_token_t::operator=(const cancel_token_t& token) {
+        if (this != &token) {
+            pimpl = token.pimpl;
+        }
+
+        return *this;
+    }
+
+    cancel_token_t& cancel_token_t::operator=(cancel_token_t&& token) {
+        if (this != &token) {
+            pimpl = std::move(token.pimpl);
+            token.pimpl = nullptr;
+        }
+
+        return *this;
+    }
+
+    cancel_token_t::~cancel_token_t() {
+
+    }
+
+
+    /****************************************************************************
+     * Other functions.
+     ***************************************************************************/
+
+
+    void cancel_token_t::cancel() const {
+        if (pimpl)
+            pimpl->cancel();
+    }
+
+    bool cancel_token_t::is_cancelled() const {
+        return pimpl and pimpl->is_cancelled();
+    }
+
+    bool cancel_token_t::empty() const {
+        return not pimpl;
+    }
+
+    size_t cancel_token_t::subscribe(const callback_t& callback) const {
+        if (not pimpl)
+            return 0;
+        return pimpl->subscribe(callback);
+    }
+
+    void cancel_token_t::unsubscribe(const size_t id) const {
+        if (pimpl and id)
+            pimpl->unsubscribe(id);
+    }
+
+
+} /* namespace crequests */
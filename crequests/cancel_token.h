@@ -0,0 +1,57 @@
+#ifndef CANCEL_TOKEN_H
+#define CANCEL_TOKEN_H
+
+#include "types.h"
+
+#include <cstddef>
+#include <functional>
+
+namespace crequests {
+
+
+    /*
+      A token which aborts requests it is given to (by the request option).
+      It can be cancelled from any thread once and forever, and the same
+      token can be shared by many requests. Copies of the token object
+      share the same state. A token constructed from nullptr is empty
+      and can never be cancelled, this is the default one of a request.
+    */
+    class cancel_token_t {
+    public:
+        using callback_t = std::function<void()>;
+
+    public:
+        cancel_token_t();
+        cancel_token_t(std::nullptr_t);
+        cancel_token_t(const cancel_token_t& token);
+        cancel_token_t(cancel_token_t&& token);
+        cancel_token_t& operator=(const cancel_token_t& token);
+        cancel_token_t& operator=(cancel_token_t&& token);
+        ~cancel_token_t();
+
+    public:
+        /*
+          Cancels the token and calls all subscribed callbacks.
+          Nothing happens if it is already cancelled or empty.
+        */
+        void cancel() const;
+        bool is_cancelled() const;
+        bool empty() const;
+
+        /*
+          Callback is called once the token is cancelled (at once if it is
+          already). The returned id is used to unsubscribe, it is 0 when the
+          callback is not stored.
+        */
+        size_t subscribe(const callback_t& callback) const;
+        void unsubscribe(const size_t id) const;
+
+    private:
+        friend class cancel_token_impl_t;
+        shared_ptr_t<class cancel_token_impl_t> pimpl;
+    };
+
+
+} /* namespace crequests */
+
+#endif /* CANCEL_TOKEN_H */
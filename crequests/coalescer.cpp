@@ -0,0 +1,135 @@
+#include "coalescer.h"
+#include "response.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace crequests {
+
+
+    /************************************************************
+     * coalescer_impl_t section.
+     ************************************************************/
+
+
+    class coalescer_impl_t {
+    public:
+        coalescer_impl_t() = default;
+
+    public:
+        bool wait(const string_t& key, const coalescer_t::waiter_t& waiter, const bool lead);
+        void finish(const string_t& key, const shared_ptr_t<const response_t>& response);
+        size_t size() const;
+
+    private:
+        /*
+          The waiters of every flight on the way.
+        */
+        using flights_t = std::unordered_map<string_t, vector_t<coalescer_t::waiter_t> >;
+
+    private:
+        mutable std::mutex mutex {};
+        flights_t flights {};
+    };
+
+    bool coalescer_impl_t::wait(const string_t& key,
+                                const coalescer_t::waiter_t& waiter,
+                                const bool lead) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = flights.find(key);
+        if (it != flights.end()) {
+            it->second.push_back(waiter);
+            return true;
+        }
+
+        if (lead)
+            flights[key];
+        return false;
+    }
+
+    /*
+      The waiters are called after the lock is released, since they may
+      begin flights of their own.
+    */
+    void coalescer_impl_t::finish(const string_t& key, const shared_ptr_t<const response_t>& response) {
+        vector_t<coalescer_t::waiter_t> waiters;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto it = flights.find(key);
+            if (it == flights.end())
+                return;
+
+            waiters = std::move(it->second);
+            flights.erase(it);
+        }
+
+        for (const auto& waiter : waiters)
+            waiter(response);
+    }
+
+    size_t coalescer_impl_t::size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return flights.size();
+    }
+
+
+    /************************************************************
+     * coalescer_t section.
+     ************************************************************/
+
+
+    coalescer_t::coalescer_t()
+        : pimpl{std::make_shared<coalescer_impl_t>()}
+    {
+
+    }
+
+    coalescer_t::~coalescer_t() {
+
+    }
+
+    string_t coalescer_t::fingerprint(const request_t& request) {
+        if (toupper(request.method().value()) != "GET" or not request.data().empty())
+            return "";
+
+        vector_t<std::pair<string_t, string_t> > fields;
+        for (const auto& field : request.headers())
+            fields.emplace_back(tolower(field.first), field.second);
+        std::sort(fields.begin(), fields.end());
+
+        std::ostringstream stream;
+        stream << "GET " << request.uri().url().value() << "\n";
+        for (const auto& field : fields)
+            stream << field.first << ": " << field.second << "\n";
+        stream
+            << "\ncookies: " << request.cookies().to_string()
+            << "\nauth: " << request.auth().to_string()
+            << "\nverify peer: " << request.always_verify_peer().value()
+            << "\nverify path: " << request.verify_path().value()
+            << "\nverify file: " << request.verify_filename().value()
+            << "\ncertificate: " << request.certificate_file().value()
+            << "\nprivate key: " << request.private_key_file().value()
+            << "\n" << request.ssl_auth()
+            << "\nssl certs: " << request.ssl_certs()
+            << "\nredirect: " << request.redirect().value()
+            << " " << request.redirect_count().value();
+        return stream.str();
+    }
+
+    bool coalescer_t::wait(const string_t& key, const waiter_t& waiter, const bool lead) {
+        return pimpl->wait(key, waiter, lead);
+    }
+
+    void coalescer_t::finish(const string_t& key, const shared_ptr_t<const response_t>& response) {
+        pimpl->finish(key, response);
+    }
+
+    size_t coalescer_t::size() const {
+        return pimpl->size();
+    }
+
+
+} /* namespace crequests */
@@ -0,0 +1,65 @@
+#ifndef COALESCER_H
+#define COALESCER_H
+
+#include "macros.h"
+#include "types.h"
+
+namespace crequests {
+
+
+    /*
+      Single flight of identical GET requests of a service (see
+      coalesce_t). The first request of a fingerprint is sent and the
+      ones which come while it is on the way wait for it. They are all
+      given the same response, which is copied once into storage shared
+      by them and is not changed after that. Can be used from any thread.
+    */
+    class coalescer_t {
+    public:
+        using waiter_t = std::function<void(const shared_ptr_t<const response_t>& response)>;
+
+    public:
+        coalescer_t();
+        coalescer_t(const coalescer_t& coalescer) = delete;
+        coalescer_t& operator=(const coalescer_t& coalescer) = delete;
+        ~coalescer_t();
+
+    public:
+        /*
+          Canonical form of everything of the request the response may
+          depend on: the url, the headers sorted by the names in lower
+          case, the cookies, the credentials, the settings of the TLS
+          handshake and the redirect settings.
+          It is empty for the requests which can not share a response
+          (the ones other than GET and the ones with a body).
+        */
+        static string_t fingerprint(const request_t& request);
+
+        /*
+          Attaches the waiter to the flight of the fingerprint and returns
+          true when there is one. Otherwise, if the caller can lead, a new
+          flight is begun: the caller sends the request and calls finish().
+        */
+        bool wait(const string_t& key, const waiter_t& waiter, const bool lead);
+
+        /*
+          Ends the flight and calls its waiters with the response. A null
+          response means the leader gave up (it was cancelled), so every
+          waiter has to send the request by itself.
+        */
+        void finish(const string_t& key, const shared_ptr_t<const response_t>& response);
+
+        /*
+          Flights on the way.
+        */
+        size_t size() const;
+
+    private:
+        friend class coalescer_impl_t;
+        shared_ptr_t<class coalescer_impl_t> pimpl;
+    };
+
+
+} /* namespace crequests */
+
+#endif /* COALESCER_H */
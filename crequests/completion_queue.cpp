@@ -0,0 +1,215 @@
+#include "completion_queue.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <mutex>
+
+namespace crequests {
+
+
+    /************************************************************
+     * completion_t section.
+     ************************************************************/
+
+
+    completion_t::completion_t(const tag_t& tag, response_t&& response)
+        : m_tag{tag},
+          m_response{std::move(response)}
+    {
+
+    }
+
+    const tag_t& completion_t::tag() const {
+        return m_tag;
+    }
+
+    const response_t& completion_t::response() const {
+        return m_response;
+    }
+
+    response_t& completion_t::response() {
+        return m_response;
+    }
+
+
+    /************************************************************
+     * completion_queue_impl_t section.
+     ************************************************************/
+
+
+    class completion_queue_impl_t {
+    public:
+        void expect();
+        void push(const tag_t& tag, response_t&& response);
+        vector_t<completion_t> poll(const size_t max_count);
+        vector_t<completion_t> wait_for(const size_t count,
+                                        const time_point_t& deadline);
+        size_t size() const;
+        size_t pending() const;
+
+    private:
+        vector_t<completion_t> take(const size_t max_count);
+
+    private:
+        mutable std::mutex mutex {};
+        std::condition_variable condition {};
+        std::deque<completion_t> completions {};
+        size_t m_pending {0};
+    };
+
+    void completion_queue_impl_t::expect() {
+        std::lock_guard<std::mutex> lock(mutex);
+        m_pending++;
+    }
+
+    void completion_queue_impl_t::push(const tag_t& tag, response_t&& response) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            /*
+              A completion goes after the ready ones of the same or a greater
+              priority, so a consumer takes urgent responses first.
+            */
+            const auto priority = response.request().priority().value();
+            const auto it = std::find_if(
+                completions.rbegin(), completions.rend(),
+                [priority](const completion_t& completion) {
+                    return completion.response().request().priority().value() >= priority;
+                });
+            completions.emplace(it.base(), tag, std::move(response));
+            if (m_pending > 0)
+                m_pending--;
+        }
+        condition.notify_all();
+    }
+
+    vector_t<completion_t> completion_queue_impl_t::poll(const size_t max_count) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return take(max_count);
+    }
+
+    vector_t<completion_t> completion_queue_impl_t::wait_for(
+        const size_t count, const time_point_t& deadline)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait_until(lock, deadline, [this, count]() {
+            return completions.size() >= count or m_pending == 0;
+        });
+        return take(count);
+    }
+
+    vector_t<completion_t> completion_queue_impl_t::take(const size_t max_count) {
+        const size_t n = std::min(max_count, completions.size());
+
+        vector_t<completion_t> result;
+        result.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            result.push_back(std::move(completions.front()));
+            completions.pop_front();
+        }
+
+        return result;
+    }
+
+    size_t completion_queue_impl_t::size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return completions.size();
+    }
+
+    size_t completion_queue_impl_t::pending() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return m_pending;
+    }
+
+
+    /************************************************************
+     * completion_queue_t section.
+     ************************************************************/
+
+
+    completion_queue_t::completion_queue_t()
+        : pimpl{std::make_shared<completion_queue_impl_t>()}
+    {
+
+    }
+
+    completion_queue_t::completion_queue_t(const completion_queue_t& queue)
+        : pimpl{queue.pimpl}
+    {
+
+    }
+
+    completion_queue_t::completion_queue_t(completion_queue_t&& queue)
+        : pimpl{std::move(queue.pimpl)}
+    {
+        queue.pimpl = nullptr;
+    }
+
+    completion_queue_t& completion_queue_t::operator=(const completion_queue_t& queue) {
+        if (this != &queue) {
+            pimpl = queue.pimpl;
+        }
+
+        return *this;
+    }
+
+    completion_queue_t& completion_queue_t::operator=(completion_queue_t&& queue) {
+        if (this != &queue) {
+            pimpl = std::move(queue.pimpl);
+            queue.pimpl = nullptr;
+        }
+
+        return *this;
+    }
+
+    completion_queue_t::~completion_queue_t() {
+
+    }
+
+
+    /****************************************************************************
+     * Other functions.
+     ***************************************************************************/
+
+
+    completion_handler_t completion_queue_t::bind(const tag_t& tag) const {
+        pimpl->expect();
+        const auto impl = pimpl;
+        return [impl, tag](response_t&& response) {
+            impl->push(tag, std::move(response));
+        };
+    }
+
+    void completion_queue_t::push(const tag_t& tag, response_t&& response) const {
+        pimpl->push(tag, std::move(response));
+    }
+
+    vector_t<completion_t> completion_queue_t::poll(const size_t max_count) const {
+        return pimpl->poll(max_count);
+    }
+
+    vector_t<completion_t> completion_queue_t::poll() const {
+        return pimpl->poll(std::numeric_limits<size_t>::max());
+    }
+
+    vector_t<completion_t> completion_queue_t::wait_for(
+        const size_t count, const time_point_t& deadline) const
+    {
+        return pimpl->wait_for(count, deadline);
+    }
+
+    size_t completion_queue_t::size() const {
+        return pimpl->size();
+    }
+
+    bool completion_queue_t::empty() const {
+        return size() == 0;
+    }
+
+    size_t completion_queue_t::pending() const {
+        return pimpl->pending();
+    }
+
+
+} /* namespace crequests */
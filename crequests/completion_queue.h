@@ -0,0 +1,96 @@
+#ifndef COMPLETION_QUEUE_H
+#define COMPLETION_QUEUE_H
+
+#include "macros.h"
+#include "response.h"
+#include "types.h"
+
+namespace crequests {
+
+
+    declare_number(tag, size_t)
+
+
+    /*
+      One finished request: the user tag given at submission time
+      and the response (good or with an error, does not matter).
+    */
+    class completion_t {
+    public:
+        completion_t(const tag_t& tag, response_t&& response);
+
+    public:
+        const tag_t& tag() const;
+        const response_t& response() const;
+        response_t& response();
+
+    private:
+        tag_t m_tag;
+        response_t m_response;
+    };
+
+
+    /*
+      A queue which connections push finished responses into.
+      Instead of holding a future per request a consumer thread
+      drains many results at once with poll() or wait_for().
+      Ready completions are taken by priority of their requests
+      and then in the order they are done.
+      Copies of the queue object share the same storage.
+    */
+    class completion_queue_t {
+    public:
+        completion_queue_t();
+        completion_queue_t(const completion_queue_t& queue);
+        completion_queue_t(completion_queue_t&& queue);
+        completion_queue_t& operator=(const completion_queue_t& queue);
+        completion_queue_t& operator=(completion_queue_t&& queue);
+        ~completion_queue_t();
+
+    public:
+        /*
+          Returns a handler which delivers a response with the given tag
+          into this queue. Every handler counts as a pending request
+          until it is invoked.
+        */
+        completion_handler_t bind(const tag_t& tag) const;
+
+        /*
+          Puts a finished response into the queue and wakes up waiters.
+        */
+        void push(const tag_t& tag, response_t&& response) const;
+
+        /*
+          Takes up to max_count ready completions without blocking.
+        */
+        vector_t<completion_t> poll(const size_t max_count) const;
+        vector_t<completion_t> poll() const;
+
+        /*
+          Blocks until count completions are ready or deadline is reached
+          and takes up to count of them. It returns earlier with whatever
+          is ready if nothing is pending anymore.
+        */
+        vector_t<completion_t> wait_for(const size_t count,
+                                        const time_point_t& deadline) const;
+
+        /*
+          Number of ready completions in the queue.
+        */
+        size_t size() const;
+        bool empty() const;
+
+        /*
+          Number of bound handlers which are not delivered yet.
+        */
+        size_t pending() const;
+
+    private:
+        friend class completion_queue_impl_t;
+        shared_ptr_t<class completion_queue_impl_t> pimpl;
+    };
+
+
+} /* namespace crequests */
+
+#endif /* COMPLETION_QUEUE_H */
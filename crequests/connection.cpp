@@ -1,12 +1,19 @@
 #include "boost_asio.h"
+#include "breaker.h"
 #include "connection.h"
 #include "parser.h"
+#include "pool.h"
 #include "request.h"
 #include "response.h"
+#include "limiter.h"
 #include "service.h"
 #include "stream.h"
+#include "throttle.h"
+#include "timer_wheel.h"
 #include "utils.h"
 
+#include <limits>
+#include <mutex>
 #include <thread>
 
 namespace crequests {
@@ -14,6 +21,25 @@ namespace crequests {
 
     namespace {
 
+        /*
+          The largest single read of the socket (as asio does by default)
+          and the read quota used when only a bandwidth limit is set.
+        */
+        const std::size_t MAX_READ_SIZE = 65536;
+        const std::size_t THROTTLED_READ_QUOTA = 16384;
+
+        /*
+          How long before the Keep-Alive timeout of the server an idle
+          socket is retired.
+        */
+        const milliseconds_t KEEP_ALIVE_MARGIN {500};
+
+        /*
+          A redirect body up to this size is read to keep its socket alive,
+          a larger one is not worth it and the socket is dropped.
+        */
+        const std::size_t MAX_DRAINED_BODY = 65536;
+
         template <class StreamBufT>
         headers_t parse_headers(StreamBufT&& response_buf) {
             std::istream response_stream(&response_buf);
@@ -89,11 +115,56 @@ namespace crequests {
                  ec.value() == boost::asio::ssl::error::stream_truncated);
         }
 
+        /*
+          Completion condition of a read which transfers at least
+          the first number of bytes and at most the second one.
+        */
+        class transfer_slice_t {
+        public:
+            transfer_slice_t(const std::size_t at_least, const std::size_t at_most)
+                : m_at_least(at_least),
+                  m_at_most(at_most)
+            {}
+
+            std::size_t operator()(const ec_t& ec, const std::size_t transferred) const {
+                if (ec or transferred >= m_at_least or transferred >= m_at_most)
+                    return 0;
+                return std::min(m_at_most - transferred, MAX_READ_SIZE);
+            }
+
+        private:
+            std::size_t m_at_least;
+            std::size_t m_at_most;
+        };
+
         bool is_redirect_code(const status_code_t& code) {
             return
                 code == status_code_t(301) or
                 code == status_code_t(302) or
-                code == status_code_t(303);
+                code == status_code_t(303) or
+                code == status_code_t(307) or
+                code == status_code_t(308);
+        }
+
+        /*
+          A 303 turns the request into a GET (a HEAD stays as is) and so
+          do 301 and 302 for a POST, as the browsers do. 307 and 308 keep
+          the method and the body.
+        */
+        void rewrite_method(request_t& request, const unsigned int status) {
+            const auto method = toupper(request.method().value());
+            const bool to_get =
+                (status == 303 and method != "HEAD") or
+                ((status == 301 or status == 302) and method == "POST");
+            if (not to_get)
+                return;
+
+            auto fields = request.headers();
+            fields.erase("Content-Length");
+            fields.erase("Content-Type");
+            request.headers(std::move(fields));
+            request.method(method_t{"GET"});
+            request.data(data_t{});
         }
 
         bool is_redirect_exhausted(const response_t& response) {
@@ -102,6 +173,22 @@ namespace crequests {
                 response.request().redirect_count().value();
         }
 
+        /*
+          Makes a Location which is a path on the same host an absolute one.
+        */
+        string_t redirect_location(const response_t& response) {
+            const auto location = response.headers().at("Location");
+            if (location.empty() or location[0] != '/' or location.substr(0, 2) == "//")
+                return location;
+
+            const auto& uri = response.request().uri();
+            return
+                uri.protocol().value() + "://" +
+                uri.domain().value() + ":" +
+                uri.port().value() +
+                location;
+        }
+
 
     } /* anonymous namespace */
 
@@ -119,7 +206,8 @@ namespace crequests {
           request, which is needed for an instantiation of response object.
          */
         conn_impl_t(service_t& service,
-                    const request_t& request);
+                    const request_t& request,
+                    const completion_handler_t& completion);
         
         /*
           This constructor is used for reuse created early connections.
@@ -129,7 +217,18 @@ namespace crequests {
          */
         conn_impl_t(service_t& service,
                     const request_t& request,
-                    const connection_t& connection);
+                    const connection_t& connection,
+                    const completion_handler_t& completion);
+
+        /*
+          This constructor is used for connections which I/O is driven
+          by a caller owned io service instead of the service thread.
+          For example, by the thread of an inline synchronous request.
+         */
+        conn_impl_t(service_t& service,
+                    const ioservice_ptr_t& ioservice,
+                    const request_t& request,
+                    const completion_handler_t& completion);
         
         conn_impl_t(const conn_impl_t& conn_impl) = delete;
         conn_impl_t& operator=(const conn_impl_t& conn_impl) = delete;
@@ -142,11 +241,23 @@ namespace crequests {
         */
         void start();
 
+        /*
+          This function sets up the connection and parks it in the pool.
+        */
+        void preconnect();
+
         /*
           This function stops current and starts a new asynchronous connection.
           This connection will ends up in a background process.
         */
         void restart();
+
+        /*
+          This function aborts the connection from any thread. If it is not
+          done yet it ends up with the CANCELLED error and the socket is closed
+          because the response was not read up to the end.
+        */
+        void cancel();
         
         /*
           Function which gives us an object for the future response.
@@ -163,6 +274,23 @@ namespace crequests {
         */
         bool is_expired() const;
 
+        /*
+          This function returns true if the response is delivered into
+          a completion handler instead of the promise.
+        */
+        bool is_detached() const;
+
+        /*
+          This function returns the io service which drives I/O of the connection.
+        */
+        ioservice_t& get_service() const;
+
+        /*
+          This function returns true if the connection is done and keeps
+          its socket open for the origin of the request.
+        */
+        bool can_hand_over(const request_t& request);
+
     private:
         /*
           This functions starts resolving process.
@@ -314,7 +442,90 @@ namespace crequests {
         /*
           This function starts when time is out and set state accordingly.
          */
-        void on_timeout(const ec_t& ec);
+        void on_timeout();
+
+        /*
+          This function sets up the timeout of the phase the connection has
+          just entered (resolve, connect, handshake, the first byte or
+          the next read of the response) and cancels the previous one.
+         */
+        void setup_phase_timeout(const error_code_t& phase);
+
+        /*
+          This function starts when the phase is not done in time.
+         */
+        void on_phase_timeout(const error_code_t& phase,
+                              const size_t generation);
+
+        /*
+          This function asks the circuit breaker of the host whether the
+          request can go. Returns false when it fails at once.
+         */
+        bool check_circuit();
+
+        /*
+          This function tells the circuit breaker how the request ended up.
+         */
+        void report_circuit();
+
+        /*
+          This function arms the timer which sends a hedged copy of
+          the request when the response is late.
+         */
+        void setup_hedge();
+        void on_hedge_timer();
+
+        /*
+          This function starts when the hedged copy is done. A good
+          response of the copy becomes the response of this connection.
+         */
+        void on_hedge_response(const response_t& hedged);
+
+        /*
+          This function keeps the failed connection waiting for its
+          hedged copy, which may still succeed. Returns false when the
+          connection has to end up.
+         */
+        bool wait_for_hedge();
+
+        /*
+          This function sends the request again when it failed and its
+          retry policy, the retry budget and the time left allow that.
+          Returns false when the connection has to end up.
+         */
+        bool try_retry();
+        void on_retry_timer();
+
+        /*
+          This function takes a slot of the service limiter. Returns false
+          when the connection has to wait in the queue or is rejected.
+         */
+        bool admit();
+
+        /*
+          This function starts when the queued connection gets a slot
+          or waits in the queue for too long.
+         */
+        void on_admitted(const bool granted);
+
+        /*
+          This function gives the slot back to the service limiter.
+         */
+        void release_slot();
+
+        /*
+          This function returns the largest number of bytes which can be
+          read at once, or 0 if the reads are not limited.
+         */
+        size_t read_quota();
+
+        /*
+          This function counts the bytes just read and calls the next
+          step of reading. It is called at once when nothing is limited,
+          posted to give other connections their turn between the slices,
+          or delayed when the bandwidth limits are exceeded.
+         */
+        void pace(const size_t bytes, std::function<void()>&& next);
 
         /*
           This functions setup timeout for final response (with an error or not).
@@ -326,7 +537,7 @@ namespace crequests {
         /*
           No one obtain this response so it is can be destructed.
          */
-        void on_dispose_timer(const ec_t& ec);
+        void on_dispose_timer();
 
         /*
           This function called when HTTP response code say us the url was moved.
@@ -335,6 +546,62 @@ namespace crequests {
          */
         void perform_redirect();
 
+        /*
+          This function sends a new request to the Location kept in the
+          redirect cache of the service for its url, so the known hops
+          are not made over the network again.
+         */
+        void follow_cached_redirects();
+
+        /*
+          Functions for working with the http cache of the service. A fresh
+          response is served without going to the network, a stale one is
+          revalidated by the request. The response which came from the
+          network is given to the cache before the request is done. Requests
+          with a body callback are given the kept body without a copy, but
+          their own body is not kept.
+         */
+        bool serve_from_cache();
+        void update_cache();
+        void take_cached_body(const shared_body_t& body);
+
+        /*
+          Functions for working with the single flight of the service. A
+          request which can be coalesced waits for the identical one on the
+          way, or leads a flight and hands its response to the waiters when
+          it is done. When the leader is cancelled the waiters are started
+          as usual.
+         */
+        bool join_flight();
+        void on_flight_done(const shared_ptr_t<const response_t>& shared);
+        void finish_flight();
+
+        /*
+          This function tells whether the socket can serve one more request
+          after the redirect: it is kept alive and the body of the redirect
+          is short enough to be read up to its end.
+         */
+        bool can_keep_stream() const;
+
+        /*
+          This function tells whether the socket can take the request to
+          the Location of the redirect: it can be kept and the Location is
+          of the same origin.
+         */
+        bool can_reuse_for_redirect() const;
+
+        /*
+          This function is called right after the headers of a redirect.
+          When the socket can not be kept the redirect is followed at once,
+          so its body is not read at all. When the socket is kept for its
+          origin and the Location is another one, the connection to it is
+          set up while the body is read. Returns false when the body has
+          to be read.
+         */
+        bool redirect_early();
+        void speculate_redirect();
+        void on_speculation_done(const size_t generation);
+
         /*
           Functions for working with states of connection mechanism.
          */
@@ -342,6 +609,8 @@ namespace crequests {
         void set_error(const error_code_t& new_state, const ec_t& ec);
         void set_success();
         void set_timeout();
+        void set_cancel();
+        void set_phase_timeout(const error_code_t& phase);
         void set_dispose();
         void set_state(const error_code_t& state_);
         bool in_final_state() const;
@@ -359,6 +628,33 @@ namespace crequests {
          */
         bool is_reused() const;
 
+        /*
+          This function tells whether the socket of the previous request
+          can take this one: it is alive and the server has not said it
+          is going to drop it (the Keep-Alive timeout and max).
+         */
+        bool can_reuse_stream();
+
+        /*
+          This function keeps the socket for the next request of the session
+          after the response is done, and closes it when the server asks to
+          or when it would be idle longer than the server keeps it.
+         */
+        void park_stream();
+        void arm_idle_timer();
+        void on_idle_timer();
+
+        /*
+          This function hands the parked socket over to the next request.
+         */
+        stream_t take_stream();
+
+        /*
+          This function takes a connection to the origin of the request
+          from the service pool. Returns false when there is none.
+         */
+        bool take_pooled();
+
         /*
           Set up all neccessary parameters and callbacks for http parser.
          */
@@ -373,16 +669,24 @@ namespace crequests {
 
     public:
         service_t& service;
+        ioservice_ptr_t own_ioservice;
+        ioservice_t& ioservice;
         strand_t strand;
         stream_t stream;
         resolver_t resolver;
-        timer__t timeout_timer;
-        timer__t dispose_timer;
-        promise_t<response_t> promise;
+        timer_wheel_t& wheel;
+        timer_id_t timeout_timer;
+        timer_id_t phase_timer;
+        timer_id_t dispose_timer;
+        completion_handler_t completion;
+        std::unique_ptr<promise_t<response_t> > promise;
         future_t<response_t> future;
         response_t response;
         bool m_is_reused;
         error_code_t state;
+        size_t cancel_subscription;
+        size_t phase_generation;
+        bool timeout_is_set;
 
         streambuf_t request_buf;
         streambuf_t response_buf;
@@ -391,22 +695,72 @@ namespace crequests {
 
         string_t header_field;
         size_t content_length {0};
+        size_t drained_body {0};
         raw_t raw;
         headers_t headers;
+
+        bool hedge_armed {false};
+        timer_id_t hedge_timer {0};
+        std::shared_ptr<conn_impl_t> hedge {};
+        bool hedge_waiting {false};
+        bool timed_out {false};
+        bool circuit_checked {false};
+        bool circuit_allowed {false};
+        breaker_t::ticket_t circuit_ticket {0};
+        bool admitted {false};
+        bool holds_slot {false};
+        limiter_t::ticket_t ticket {0};
+        string_t host_key {};
+        token_bucket_t bucket {};
+        timer_id_t throttle_timer {0};
+        size_t retries {0};
+        bool request_sent {false};
+        timer_id_t retry_timer {0};
+        std::unique_ptr<timer__t> retry_wait {};
+        std::mutex stream_mutex {};
+        bool stream_taken {false};
+        string_t parked_origin {};
+        timer_id_t idle_timer {0};
+        milliseconds_t keep_alive_timeout {0};
+        time_point_t idle_until {time_point_t::max()};
+        size_t requests_left {std::numeric_limits<size_t>::max()};
+        bool warm_up {false};
+        http_cache_t::stale_t stale_entry {};
+        bool served_from_cache {false};
+        string_t flight {};
+        bool joined_flight {false};
+        std::shared_ptr<conn_impl_t> speculation {};
+        bool redirect_waiting {false};
+        size_t speculation_generation {0};
+        time_point_t expires_at {time_point_t::max()};
+        time_point_t queued_at {};
+        time_point_t admitted_at {};
+        time_point_t hop_started_at {};
+        milliseconds_t queued_for {0};
     };
 
-    conn_impl_t::conn_impl_t(service_t& service_, const request_t& request_)
+    conn_impl_t::conn_impl_t(service_t& service_,
+                             const request_t& request_,
+                             const completion_handler_t& completion_)
         : service(service_),
-          strand(service.get_service()),
-          stream(service.get_service(), request_),
-          resolver(service.get_service()),
-          timeout_timer(service.get_service()),
-          dispose_timer(service.get_service()),
-          promise(),
-          future{promise.get_future()},
+          own_ioservice(nullptr),
+          ioservice(service.get_service()),
+          strand(ioservice),
+          stream(ioservice, request_),
+          resolver(ioservice),
+          wheel(service.get_timer_wheel()),
+          timeout_timer{0},
+          phase_timer{0},
+          dispose_timer{0},
+          completion(completion_),
+          promise(completion ? nullptr : new promise_t<response_t>()),
+          future{promise ? promise->get_future() : future_t<response_t>{}},
           response(request_),
           m_is_reused(false),
           state{error_code_t::INIT},
+          cancel_subscription{0},
+          phase_generation{0},
+          timeout_is_set{false},
           request_buf{},
           response_buf{},
           parser{new parser_t(parser_t::parser_type_t::RESPONSE)},
@@ -420,18 +774,65 @@ namespace crequests {
 
     conn_impl_t::conn_impl_t(service_t& service_,
                              const request_t& request_,
-                             const connection_t& connection)
+                             const connection_t& connection,
+                             const completion_handler_t& completion_)
         : service(service_),
-          strand(service.get_service()),
-          stream(std::move(connection.pimpl->stream)),
-          resolver(service.get_service()),
-          timeout_timer(service.get_service()),
-          dispose_timer(service.get_service()),
-          promise(),
-          future{promise.get_future()},
+          own_ioservice(connection.pimpl->own_ioservice),
+          ioservice(connection.pimpl->ioservice),
+          strand(ioservice),
+          stream(connection.pimpl->take_stream()),
+          resolver(ioservice),
+          wheel(service.get_timer_wheel()),
+          timeout_timer{0},
+          phase_timer{0},
+          dispose_timer{0},
+          completion(completion_),
+          promise(completion ? nullptr : new promise_t<response_t>()),
+          future{promise ? promise->get_future() : future_t<response_t>{}},
           response(request_),
           m_is_reused(true),
           state{error_code_t::INIT},
+          cancel_subscription{0},
+          phase_generation{0},
+          timeout_is_set{false},
+          request_buf{},
+          response_buf{},
+          parser{new parser_t(parser_t::parser_type_t::RESPONSE)},
+          header_field{},
+          content_length{},
+          raw{},
+          headers{}
+    {
+        if (not connection.is_detached())
+            response.redirects(redirects_t{connection.get().get().redirects().get()});
+        keep_alive_timeout = connection.pimpl->keep_alive_timeout;
+        idle_until = connection.pimpl->idle_until;
+        requests_left = connection.pimpl->requests_left;
+    }
+
+    conn_impl_t::conn_impl_t(service_t& service_,
+                             const ioservice_ptr_t& ioservice_,
+                             const request_t& request_,
+                             const completion_handler_t& completion_)
+        : service(service_),
+          own_ioservice(ioservice_),
+          ioservice(*own_ioservice),
+          strand(ioservice),
+          stream(ioservice, request_),
+          resolver(ioservice),
+          wheel(service.get_timer_wheel()),
+          timeout_timer{0},
+          phase_timer{0},
+          dispose_timer{0},
+          completion(completion_),
+          promise(completion ? nullptr : new promise_t<response_t>()),
+          future{promise ? promise->get_future() : future_t<response_t>{}},
+          response(request_),
+          m_is_reused(false),
+          state{error_code_t::INIT},
+          cancel_subscription{0},
+          phase_generation{0},
+          timeout_is_set{false},
           request_buf{},
           response_buf{},
           parser{new parser_t(parser_t::parser_type_t::RESPONSE)},
@@ -440,7 +841,7 @@ namespace crequests {
           raw{},
           headers{}
     {
-        response.redirects(connection.get().get().redirects());
+
     }
 
     conn_impl_t::~conn_impl_t()
@@ -449,6 +850,13 @@ namespace crequests {
             delete parser;
             parser = nullptr;
         }
+
+        /*
+          A leader which is dropped before it is done lets the waiters
+          go on by themselves.
+        */
+        if (not flight.empty())
+            service.get_coalescer().finish(flight, nullptr);
     }
 
 
@@ -548,126 +956,741 @@ namespace crequests {
     }
 
     void conn_impl_t::start() {
+        if (in_final_state())
+            return;
+
+        if (not cancel_subscription) {
+            const std::weak_ptr<conn_impl_t> weak = shared_from_this();
+            cancel_subscription =
+                response.request().cancel_token().subscribe([weak]() {
+                    if (const auto self = weak.lock())
+                        self->cancel();
+                });
+        }
+
         prepare_parser();
+        hop_started_at = steady_clock_t::now();
+
+        /*
+          The timeout is armed first. Otherwise a connection may end up
+          on the service thread before its timer is registered.
+        */
+        setup_timeout();
+
+        /*
+          A warm up only sets up a connection, there is no request to
+          count in the limits or to hedge.
+        */
+        if (warm_up) {
+            resolve();
+            return;
+        }
+
+        if (not is_reused())
+            follow_cached_redirects();
+
+        if (serve_from_cache())
+            return;
+
+        if (join_flight())
+            return;
+
+        if (not check_circuit())
+            return;
+
+        if (not admit())
+            return;
+
+        setup_hedge();
 
         if (is_reused()) {
-            if (stream.is_open())
+            if (can_reuse_stream()) {
+                requests_left--;
                 write();
-            else
+            }
+            else {
                 restart();
+            }
+        }
+        else if (take_pooled()) {
+            write();
         }
         else {
             resolve();
         }
-
-        setup_timeout();
     }
 
-    void conn_impl_t::restart() {
-        stream.cancel();
-        stream = stream_t(service.get_service(), response.request());
-        if (parser) {
-            delete parser;
-            parser = nullptr;
-        }
-        parser = new parser_t(parser_t::parser_type_t::RESPONSE);
-        m_is_reused = false;
+    void conn_impl_t::preconnect() {
+        warm_up = true;
         start();
     }
 
-    void conn_impl_t::setup_timeout() {
-        timeout_timer.expires_from_now(
-            seconds_t(response.request().timeout().value()));
-        const auto self = shared_from_this();
-        const auto callback = [this, self](const ec_t& ec) {
-            on_timeout(ec);
-        };
-        timeout_timer.async_wait(strand.wrap(callback));
-    }
+    bool conn_impl_t::check_circuit() {
+        if (circuit_checked)
+            return true;
+        circuit_checked = true;
 
-    void conn_impl_t::on_timeout(const ec_t& ec) {
-        if (not ec)
-            set_timeout();
-    }
+        const auto& uri = response.request().uri();
+        host_key = uri.domain().value() + ":" + uri.port().value();
+        bucket.rate(response.request().max_bandwidth().value());
 
-    void conn_impl_t::setup_dispose_timer() {
-        dispose_timer.expires_from_now(
-            seconds_t(response.request().store_timeout().value()));
-        const auto self = shared_from_this();
-        const auto callback = [this, self](const ec_t& ec) {
-            on_dispose_timer(ec);
-        };
-        dispose_timer.async_wait(strand.wrap(callback));
-    }
+        auto& breaker = service.get_breaker();
+        if (not breaker.enabled())
+            return true;
 
-    void conn_impl_t::on_dispose_timer(const ec_t& ec) {
-        if (not ec)
-            set_dispose();
-    }
+        if (not breaker.allow(host_key, circuit_ticket)) {
+            set_error(error_code_t::CIRCUIT_OPEN, "circuit is open");
+            return false;
+        }
 
-    void conn_impl_t::resolve() {
-        const resolver_t::query query {
-            response.request().uri().domain().value(),
-            response.request().uri().port().value()
-        };
-        const auto self = shared_from_this();
-        const auto callback = [this, self](const ec_t& ec,
-                                           const resolver_t::iterator& endpoint) {
-            on_resolve(ec, endpoint);
-        };
-        set_state(error_code_t::RESOLVE);
-        resolver.async_resolve(query, callback);
+        circuit_allowed = true;
+        return true;
     }
 
-    void conn_impl_t::on_resolve(const ec_t& ec,
-                                 const resolver_t::iterator& endpoint) {
-        if (ec) {
-            set_error(error_code_t::RESOLVE_ERROR, ec);
+    void conn_impl_t::report_circuit() {
+        if (not circuit_allowed)
             return;
+        circuit_allowed = false;
+
+        /*
+          A request which has not got to the network (it timed out in
+          the limiter queue, for example) tells nothing about the host.
+        */
+        auto outcome = breaker_t::outcome_t::FAILURE;
+        switch (admitted ? state : error_code_t::CANCELLED) {
+        case error_code_t::SUCCESS:
+            outcome = response.status_code().value() >= 500
+                ? breaker_t::outcome_t::FAILURE
+                : breaker_t::outcome_t::SUCCESS;
+            break;
+        case error_code_t::CANCELLED:
+        case error_code_t::QUEUE_FULL:
+        case error_code_t::QUEUE_TIMEOUT:
+        case error_code_t::REDIRECT_EXHAUSTED:
+        case error_code_t::REDIRECT_ERROR:
+            outcome = breaker_t::outcome_t::NEUTRAL;
+            break;
+        default:
+            break;
         }
 
-        connect(endpoint);
+        service.get_breaker().report(host_key, circuit_ticket, outcome);
     }
 
-    void conn_impl_t::connect(const resolver_t::iterator& endpoint) {
-        const auto self = shared_from_this();
-        const auto callback = [this, self](const ec_t& ec,
-                                           const resolver_t::iterator& endpoint_) {
-            on_connect(ec, endpoint_);
-        };
-        set_state(error_code_t::CONNECT);
-        stream.async_connect(endpoint, strand.wrap(callback));
-    }
+    void conn_impl_t::setup_hedge() {
+        if (hedge_armed)
+            return;
+        hedge_armed = true;
 
-    void conn_impl_t::on_connect(const ec_t& ec,
-                                 const resolver_t::iterator&) {
-        if (ec) {
-            set_error(error_code_t::CONNECT_ERROR, ec);
+        /*
+          A request driven by the calling thread is not hedged, its io
+          service is run only while the request itself is not done.
+        */
+        const auto& request = response.request();
+        const auto percent = request.hedge_percentile().value();
+        if ((request.hedge_delay().value() == 0 and percent == 0) or
+            own_ioservice or
+            not is_idempotent_method(request.method().value()))
             return;
-        }
 
-        if (response.request().keep_alive())
-            stream.set_option(boost::asio::socket_base::keep_alive { true });
-        handshake();
-    }
+        auto& hedging = service.get_hedging();
+        hedging.deposit();
+
+        auto delay = milliseconds_t(request.hedge_delay().value());
+        if (percent > 0) {
+            const auto latency = hedging.percentile(host_key, percent);
+            if (latency)
+                delay = *latency;
+            else if (delay.count() == 0)
+                return;
+        }
 
-    void conn_impl_t::handshake() {
         const auto self = shared_from_this();
-        const auto callback = [this, self](const ec_t& ec) {
-            on_handshake(ec);
-        };
-        set_state(error_code_t::HANDSHAKE);
-        stream.async_handshake(strand.wrap(callback));
+        hedge_timer = wheel.schedule(delay, [this, self]() {
+            strand.post([this, self]() {
+                hedge_timer = 0;
+                on_hedge_timer();
+            });
+        });
     }
 
-    void conn_impl_t::on_handshake(const ec_t& ec) {
-        if (ec) {
-            set_error(error_code_t::HANDSHAKE_ERROR, ec);
+    void conn_impl_t::on_hedge_timer() {
+        if (in_final_state() or hedge or not service.get_hedging().withdraw())
             return;
-        }
 
-        write();
-    }
+        auto request = response.request();
+        request.hedge_delay(hedge_delay_t{0});
+        request.hedge_percentile(hedge_percentile_t{0});
+        request.retry_policy(retry_policy_t{});
+        request.coalesce(coalesce_t{false});
+
+        const std::weak_ptr<conn_impl_t> weak = shared_from_this();
+        const auto on_done = [weak](response_t&& hedged) {
+            const auto self = weak.lock();
+            if (not self)
+                return;
+
+            const auto shared = std::make_shared<response_t>(std::move(hedged));
+            self->strand.post([self, shared]() {
+                self->on_hedge_response(*shared);
+            });
+        };
+
+        hedge = std::make_shared<conn_impl_t>(service, request, on_done);
+        hedge->start();
+    }
+
+    void conn_impl_t::on_hedge_response(const response_t& hedged) {
+        hedge.reset();
+
+        /*
+          A failed copy is ignored, this connection may still succeed.
+          If it has failed already, it ends up with its own error.
+        */
+        if (hedged.error().code() != error_code_t::SUCCESS) {
+            if (hedge_waiting)
+                end();
+            return;
+        }
+
+        if (in_final_state() and not hedge_waiting)
+            return;
+
+        const auto delay = response.request().hedge_delay();
+        const auto percent = response.request().hedge_percentile();
+        const auto policy = response.request().retry_policy();
+        response = hedged;
+        response.request().hedge_delay(delay);
+        response.request().hedge_percentile(percent);
+        response.request().retry_policy(policy);
+        response.hedged(hedged_t{true});
+        raw = response.raw();
+
+        /*
+          The copy did not send the validators by itself, so its 304 is
+          taken by the cache here.
+        */
+        if (response.status_code() == status_code_t(304))
+            update_cache();
+
+        resolver.cancel();
+        stream.cancel();
+        stream.close();
+
+        state = error_code_t::SUCCESS;
+        end();
+    }
+
+    bool conn_impl_t::wait_for_hedge() {
+        if (not hedge or hedge_waiting or timed_out)
+            return false;
+
+        switch (state) {
+        case error_code_t::SUCCESS:
+        case error_code_t::CANCELLED:
+        case error_code_t::EXPIRED:
+            return false;
+        default:
+            break;
+        }
+
+        /*
+          The total timeout is left armed, so the copy does not make
+          the request longer than it was allowed to be.
+        */
+        hedge_waiting = true;
+        resolver.cancel();
+        wheel.cancel(phase_timer);
+        wheel.cancel(throttle_timer);
+        stream.cancel();
+        stream.close();
+        release_slot();
+        report_circuit();
+        return true;
+    }
+
+    bool conn_impl_t::try_retry() {
+        const auto& policy = response.request().retry_policy();
+        if (policy.empty() or warm_up)
+            return false;
+
+        auto& budget = service.get_retry_budget();
+        if (retries == 0)
+            budget.deposit();
+
+        bool retryable = false;
+        switch (state) {
+        case error_code_t::SUCCESS:
+            retryable = policy.retries_status(response.status_code().value());
+            break;
+        case error_code_t::CANCELLED:
+        case error_code_t::EXPIRED:
+            break;
+        default:
+            retryable = policy.retries_error(state);
+            break;
+        }
+
+        /*
+          A request which has not got to the server can be sent again
+          whatever its method is.
+        */
+        const auto& request = response.request();
+        if (not retryable or
+            retries >= policy.retries() or
+            (request_sent and not policy.retries_method(request.method().value())))
+            return false;
+
+        auto delay = policy.delay(retries);
+        if (state == error_code_t::SUCCESS and response.headers().count("Retry-After")) {
+            const auto& retry_after = response.headers().at("Retry-After");
+            if (not retry_after.empty() and
+                retry_after.find_first_not_of("0123456789") == string_t::npos)
+                delay = std::max<milliseconds_t>(
+                    delay, seconds_t(std::stoul(retry_after.substr(0, 9))));
+        }
+
+        /*
+          The total timeout covers the retries as well, so there is no
+          point to wait for a retry which will be timed out anyway.
+        */
+        if (steady_clock_t::now() + delay >= expires_at or not budget.withdraw())
+            return false;
+
+        retries++;
+
+        wheel.cancel(phase_timer);
+        wheel.cancel(throttle_timer);
+        wheel.cancel(hedge_timer);
+        if (hedge) {
+            hedge->cancel();
+            hedge.reset();
+        }
+        if (speculation) {
+            speculation->cancel();
+            speculation.reset();
+        }
+        redirect_waiting = false;
+
+        release_slot();
+        report_circuit();
+        admitted = false;
+        circuit_checked = false;
+        hedge_armed = false;
+        request_sent = false;
+
+        resolver.cancel();
+        stream.cancel();
+        stream.close();
+        stream = stream_t(ioservice, request);
+        m_is_reused = false;
+        if (request_buf.size() > 0)
+            request_buf.consume(request_buf.size());
+        if (response_buf.size() > 0)
+            response_buf.consume(response_buf.size());
+        if (parser) {
+            delete parser;
+            parser = nullptr;
+        }
+        parser = new parser_t(parser_t::parser_type_t::RESPONSE);
+
+        auto redirect_count = std::move(response.redirect_count());
+        auto redirects = std::move(response.redirects());
+        response = response_t{response.request()};
+        response.redirect_count(std::move(redirect_count));
+        response.redirects(std::move(redirects));
+        state = error_code_t::INIT;
+
+        /*
+          The wheel runs on the service thread, while a caller owned io
+          service is run only as long as it has some work, so the wait
+          is done by its own timer then.
+        */
+        const auto self = shared_from_this();
+        if (own_ioservice) {
+            if (not retry_wait)
+                retry_wait.reset(new timer__t(ioservice));
+            retry_wait->expires_from_now(delay);
+            retry_wait->async_wait(strand.wrap([this, self](const ec_t& ec) {
+                if (not ec)
+                    on_retry_timer();
+            }));
+        }
+        else {
+            retry_timer = wheel.schedule(delay, [this, self]() {
+                strand.post([this, self]() {
+                    retry_timer = 0;
+                    on_retry_timer();
+                });
+            });
+        }
+
+        return true;
+    }
+
+    void conn_impl_t::on_retry_timer() {
+        if (not in_final_state())
+            start();
+    }
+
+    bool conn_impl_t::admit() {
+        if (admitted)
+            return true;
+
+        auto& limiter = service.get_limiter();
+        if (not limiter.enabled()) {
+            admitted = true;
+            admitted_at = steady_clock_t::now();
+            return true;
+        }
+
+        queued_at = steady_clock_t::now();
+
+        const auto self = shared_from_this();
+        const auto admission = limiter.acquire(
+            host_key,
+            response.request().priority().value(),
+            expires_at,
+            [this, self](const bool granted) {
+                strand.post([this, self, granted]() {
+                    on_admitted(granted);
+                });
+            },
+            ticket);
+
+        switch (admission) {
+        case limiter_t::admission_t::GRANTED:
+            admitted = true;
+            holds_slot = true;
+            admitted_at = queued_at;
+            return true;
+        case limiter_t::admission_t::REJECTED:
+            set_error(error_code_t::QUEUE_FULL, "queue is full");
+            return false;
+        case limiter_t::admission_t::QUEUED:
+            return false;
+        }
+
+        return false;
+    }
+
+    void conn_impl_t::on_admitted(const bool granted) {
+        ticket = 0;
+        holds_slot = granted;
+
+        /*
+          The connection may be cancelled or timed out while its grant
+          was on the way, then the slot goes to the next one at once.
+        */
+        if (in_final_state()) {
+            release_slot();
+            return;
+        }
+
+        if (not granted) {
+            set_error(error_code_t::QUEUE_TIMEOUT, "queue timeout");
+            return;
+        }
+
+        admitted = true;
+        admitted_at = steady_clock_t::now();
+        queued_for += std::chrono::duration_cast<milliseconds_t>(admitted_at - queued_at);
+        start();
+    }
+
+    void conn_impl_t::release_slot() {
+        if (not holds_slot)
+            return;
+
+        /*
+          Only the outcomes which tell something about the host load
+          feed its adaptive limit.
+        */
+        auto& limiter = service.get_limiter();
+        const auto latency = std::chrono::duration_cast<milliseconds_t>(
+            steady_clock_t::now() - admitted_at);
+        switch (admitted ? state : error_code_t::INIT) {
+        case error_code_t::SUCCESS:
+            limiter.sample(host_key, latency, response.status_code().value() >= 500);
+            break;
+        case error_code_t::TIMEOUT:
+        case error_code_t::CONNECT_ERROR:
+            limiter.sample(host_key, latency, true);
+            break;
+        default:
+            break;
+        }
+
+        holds_slot = false;
+        service.get_limiter().release(host_key);
+    }
+
+    size_t conn_impl_t::read_quota() {
+        const auto request_quota = response.request().read_quota().value();
+        const auto service_quota = service.get_throttle().read_quota();
+
+        size_t quota = 0;
+        if (request_quota > 0 and service_quota > 0)
+            quota = std::min(request_quota, service_quota);
+        else
+            quota = std::max(request_quota, service_quota);
+
+        /*
+          A whole body read at once cannot be throttled, so the limited
+          reads are always done by slices.
+        */
+        if (quota == 0 and (bucket.rate() > 0 or service.get_throttle().enabled()))
+            quota = THROTTLED_READ_QUOTA;
+
+        return quota;
+    }
+
+    void conn_impl_t::pace(const size_t bytes, std::function<void()>&& next) {
+        auto& throttle = service.get_throttle();
+        const auto now = steady_clock_t::now();
+        auto delay = bucket.consume(bytes, now);
+        if (throttle.enabled())
+            delay = std::max(delay, throttle.consume(host_key, bytes));
+
+        const auto self = shared_from_this();
+        if (delay.count() > 0) {
+            /*
+              The connection is idle on purpose, so the read timeout
+              is not running until the next read.
+            */
+            wheel.cancel(phase_timer);
+            throttle_timer = wheel.schedule(delay, [this, self, next]() {
+                strand.post([this, self, next]() {
+                    throttle_timer = 0;
+                    if (not in_final_state())
+                        next();
+                });
+            });
+        }
+        else if (read_quota() > 0) {
+            strand.post([this, self, next]() {
+                if (not in_final_state())
+                    next();
+            });
+        }
+        else {
+            next();
+        }
+    }
+
+    void conn_impl_t::restart() {
+        stream.cancel();
+        stream = stream_t(ioservice, response.request());
+        if (parser) {
+            delete parser;
+            parser = nullptr;
+        }
+        parser = new parser_t(parser_t::parser_type_t::RESPONSE);
+        m_is_reused = false;
+        start();
+    }
+
+    void conn_impl_t::cancel() {
+        const auto self = shared_from_this();
+        strand.dispatch([this, self]() {
+            set_cancel();
+        });
+    }
+
+    void conn_impl_t::setup_timeout() {
+        /*
+          The whole request is limited once. Restarts of a stale
+          keep-alive connection and redirects are not given more time.
+        */
+        if (timeout_is_set)
+            return;
+        timeout_is_set = true;
+
+        const auto& total_timeout = response.request().total_timeout();
+        const milliseconds_t timeout = total_timeout.value() > 0
+            ? milliseconds_t(total_timeout.value())
+            : milliseconds_t(seconds_t(response.request().timeout().value()));
+        const auto& deadline = response.request().deadline();
+        const auto now = steady_clock_t::now();
+        const auto expiry = not deadline.empty() and deadline.value() < now + timeout
+            ? deadline.value()
+            : now + timeout;
+        expires_at = expiry;
+        const auto self = shared_from_this();
+        const auto callback = [this, self]() {
+            strand.post([this, self]() {
+                on_timeout();
+            });
+        };
+
+        /*
+          A request which has no time left is timed out at once instead
+          of waiting for the next tick of the wheel.
+        */
+        if (expiry <= now)
+            callback();
+        else
+            timeout_timer = wheel.schedule(expiry, callback);
+    }
+
+    void conn_impl_t::on_timeout() {
+        set_timeout();
+    }
+
+    void conn_impl_t::setup_phase_timeout(const error_code_t& phase) {
+        const auto& request = response.request();
+        size_t timeout = 0;
+        switch (phase) {
+        case error_code_t::RESOLVE:
+            timeout = request.resolve_timeout().value();
+            break;
+        case error_code_t::CONNECT:
+            timeout = request.connect_timeout().value();
+            break;
+        case error_code_t::HANDSHAKE:
+            timeout = request.handshake_timeout().value();
+            break;
+        case error_code_t::READ_STATUS:
+            timeout = request.first_byte_timeout().value();
+            break;
+        case error_code_t::READ_HEADERS:
+        case error_code_t::READ_CONTENT_LENGTH:
+        case error_code_t::READ_CHUNK_HEADER:
+        case error_code_t::READ_CHUNK_DATA:
+        case error_code_t::READ_UNTIL_EOF:
+            timeout = request.read_timeout().value();
+            break;
+        default:
+            break;
+        }
+
+        /*
+          A handler of the previous phase may be already posted when
+          the timer is rearmed, so it is told apart by the generation.
+        */
+        const auto generation = ++phase_generation;
+
+        wheel.cancel(phase_timer);
+        if (timeout == 0)
+            return;
+
+        const auto self = shared_from_this();
+        const auto callback = [this, self, phase, generation]() {
+            strand.post([this, self, phase, generation]() {
+                on_phase_timeout(phase, generation);
+            });
+        };
+        phase_timer = wheel.schedule(milliseconds_t(timeout), callback);
+    }
+
+    void conn_impl_t::on_phase_timeout(const error_code_t& phase,
+                                       const size_t generation) {
+        if (generation == phase_generation)
+            set_phase_timeout(phase);
+    }
+
+    void conn_impl_t::setup_dispose_timer() {
+        const auto self = shared_from_this();
+        /*
+          The wheel runs on the service thread. A caller owned io service
+          is not run anymore when it is expired, so the handler can not
+          go through the connection strand then.
+         */
+        const auto callback = [this, self]() {
+            if (own_ioservice)
+                on_dispose_timer();
+            else
+                strand.post([this, self]() {
+                    on_dispose_timer();
+                });
+        };
+        dispose_timer = wheel.schedule(
+            seconds_t(response.request().store_timeout().value()), callback);
+    }
+
+    void conn_impl_t::on_dispose_timer() {
+        set_dispose();
+    }
+
+    void conn_impl_t::resolve() {
+        const resolver_t::query query {
+            response.request().uri().domain().value(),
+            response.request().uri().port().value()
+        };
+        const auto self = shared_from_this();
+        const auto callback = [this, self](const ec_t& ec,
+                                           const resolver_t::iterator& endpoint) {
+            on_resolve(ec, endpoint);
+        };
+        set_state(error_code_t::RESOLVE);
+        setup_phase_timeout(error_code_t::RESOLVE);
+        resolver.async_resolve(query, callback);
+    }
+
+    void conn_impl_t::on_resolve(const ec_t& ec,
+                                 const resolver_t::iterator& endpoint) {
+        if (ec) {
+            set_error(error_code_t::RESOLVE_ERROR, ec);
+            return;
+        }
+
+        connect(endpoint);
+    }
+
+    void conn_impl_t::connect(const resolver_t::iterator& endpoint) {
+        const auto self = shared_from_this();
+        const auto callback = [this, self](const ec_t& ec,
+                                           const resolver_t::iterator& endpoint_) {
+            on_connect(ec, endpoint_);
+        };
+        set_state(error_code_t::CONNECT);
+        setup_phase_timeout(error_code_t::CONNECT);
+        stream.async_connect(endpoint, strand.wrap(callback));
+    }
+
+    void conn_impl_t::on_connect(const ec_t& ec,
+                                 const resolver_t::iterator&) {
+        if (ec) {
+            set_error(error_code_t::CONNECT_ERROR, ec);
+            return;
+        }
+
+        if (response.request().keep_alive())
+            stream.set_option(boost::asio::socket_base::keep_alive { true });
+        handshake();
+    }
+
+    void conn_impl_t::handshake() {
+        const auto self = shared_from_this();
+        const auto callback = [this, self](const ec_t& ec) {
+            on_handshake(ec);
+        };
+        set_state(error_code_t::HANDSHAKE);
+        setup_phase_timeout(error_code_t::HANDSHAKE);
+        stream.async_handshake(strand.wrap(callback));
+    }
+
+    void conn_impl_t::on_handshake(const ec_t& ec) {
+        if (ec) {
+            set_error(error_code_t::HANDSHAKE_ERROR, ec);
+            return;
+        }
+
+        if (warm_up) {
+            wheel.cancel(phase_timer);
+            if (not service.get_pool().put(pool_t::key(response.request()), std::move(stream))) {
+                set_error(error_code_t::QUEUE_FULL, "the pool of the origin is full");
+                return;
+            }
+
+            set_state(error_code_t::SUCCESS);
+            response.error(error_t(state, "success"));
+            end();
+            return;
+        }
+
+        write();
+    }
 
     void conn_impl_t::write() {
         std::ostream request_stream(&request_buf);
@@ -679,6 +1702,8 @@ namespace crequests {
             on_write(ec, length);
         };
         set_state(error_code_t::WRITE);
+        setup_phase_timeout(error_code_t::WRITE);
+        request_sent = true;
         stream.async_write(request_buf, strand.wrap(callback));
     }
 
@@ -702,6 +1727,7 @@ namespace crequests {
             on_read_status(ec, length);
         };
         set_state(error_code_t::READ_STATUS);
+        setup_phase_timeout(error_code_t::READ_STATUS);
         stream.async_read_until(response_buf, "\r\n", strand.wrap(callback));
     }
 
@@ -730,6 +1756,7 @@ namespace crequests {
             on_read_headers(ec, length);
         };
         set_state(error_code_t::READ_HEADERS);
+        setup_phase_timeout(error_code_t::READ_HEADERS);
         stream.async_read_until(response_buf, "\r\n\r\n", strand.wrap(callback));
     }
 
@@ -747,6 +1774,9 @@ namespace crequests {
             return;
         }
 
+        if (redirect_early())
+            return;
+
         read_content();
     }
 
@@ -765,20 +1795,29 @@ namespace crequests {
             on_read_content_length(ec, length);
         };
         set_state(error_code_t::READ_CONTENT_LENGTH);
+        setup_phase_timeout(error_code_t::READ_CONTENT_LENGTH);
         const size_t n = response_buf.size() > content_length
             ? 0
             : content_length - response_buf.size();
+        const size_t quota = read_quota();
         stream.async_read(response_buf,
-                          boost::asio::transfer_at_least(n),
+                          quota > 0
+                          ? transfer_slice_t(std::min(n, quota), quota)
+                          : transfer_slice_t(n, std::numeric_limits<std::size_t>::max()),
                           strand.wrap(callback));
     }
 
-    void conn_impl_t::on_read_content_length(const ec_t& ec, const std::size_t) {
+    void conn_impl_t::on_read_content_length(const ec_t& ec, const std::size_t length) {
         if ((ec and not is_eof(ec)) or
             (ec and is_eof(ec) and response_buf.size() < content_length))
         {
             set_error(error_code_t::READ_CONTENT_LENGTH_ERROR, ec);
         }
+        else if (not ec and response_buf.size() < content_length) {
+            pace(length, [this]() {
+                read_content_length();
+            });
+        }
         else {
             raw.value().reserve(content_length);
             if (not execute_parser()) {
@@ -798,6 +1837,8 @@ namespace crequests {
             return;
         }
 
+        setup_phase_timeout(error_code_t::READ_CHUNK_HEADER);
+
         const auto self = shared_from_this();
         const auto callback = [this, self](const ec_t& ec, const std::size_t length) {
             on_read_chunk_header(ec, length);
@@ -820,10 +1861,24 @@ namespace crequests {
             return;
         }
 
+        /*
+          The size of a chunked redirect body is known chunk by chunk, so
+          its socket is dropped as soon as the body is too large to drain.
+        */
+        if (is_redirect_code(response.status_code()) and response.request().redirect()) {
+            drained_body += content_length;
+            if (drained_body > MAX_DRAINED_BODY) {
+                stream.cancel();
+                stream.close();
+                perform_redirect();
+                return;
+            }
+        }
+
         if (content_length > 0) {
             if (response_buf.size() > content_length) {
                 set_state(error_code_t::READ_CHUNK_DATA);
-                on_read_chunk_data(ec_t(), content_length);
+                on_read_chunk_data(ec_t(), 0);
             }
             else {
                 read_chunk_data();
@@ -836,6 +1891,7 @@ namespace crequests {
 
     void conn_impl_t::read_chunk_data() {
         set_state(error_code_t::READ_CHUNK_DATA);
+        setup_phase_timeout(error_code_t::READ_CHUNK_DATA);
 
         const auto self = shared_from_this();
         const auto callback = [this, self](const ec_t& ec,
@@ -843,12 +1899,16 @@ namespace crequests {
             on_read_chunk_data(ec, length);
         };
 
+        const size_t n = content_length - response_buf.size();
+        const size_t quota = read_quota();
         stream.async_read(response_buf,
-                          boost::asio::transfer_at_least(content_length - response_buf.size()),
+                          quota > 0
+                          ? transfer_slice_t(std::min(n, quota), quota)
+                          : transfer_slice_t(n, std::numeric_limits<std::size_t>::max()),
                           strand.wrap(callback));
     }
 
-    void conn_impl_t::on_read_chunk_data(const ec_t& ec, const std::size_t) {
+    void conn_impl_t::on_read_chunk_data(const ec_t& ec, const std::size_t length) {
         if (ec and not is_eof(ec)) {
             set_error(error_code_t::READ_CHUNK_DATA_ERROR, ec);
             return;
@@ -858,13 +1918,22 @@ namespace crequests {
             return;
         }
 
+        if (not ec and response_buf.size() < content_length) {
+            pace(length, [this]() {
+                read_chunk_data();
+            });
+            return;
+        }
+
         raw.value().reserve(response.raw().value().size() + content_length);
         if (not execute_parser()) {
             set_error(error_code_t::READ_CHUNK_DATA_ERROR, "chunk data error");
             return;
         }
 
-        read_chunk_header();
+        pace(length, [this]() {
+            read_chunk_header();
+        });
     }
 
     void conn_impl_t::read_until_eof() {
@@ -873,12 +1942,14 @@ namespace crequests {
             on_read_until_eof(ec, length);
         };
         set_state(error_code_t::READ_UNTIL_EOF);
+        setup_phase_timeout(error_code_t::READ_UNTIL_EOF);
+        const size_t quota = read_quota();
         stream.async_read(response_buf,
-                          boost::asio::transfer_at_least(1),
+                          transfer_slice_t(1, quota > 0 ? quota : MAX_READ_SIZE),
                           strand.wrap(callback));
     }
 
-    void conn_impl_t::on_read_until_eof(const ec_t& ec, const std::size_t) {
+    void conn_impl_t::on_read_until_eof(const ec_t& ec, const std::size_t length) {
         if (ec) {
             if (not is_eof(ec)) {
                 set_error(error_code_t::READ_UNTIL_EOF_ERROR, ec);
@@ -892,7 +1963,9 @@ namespace crequests {
             }
         }
         else {
-            read_until_eof();
+            pace(length, [this]() {
+                read_until_eof();
+            });
         }
     }
 
@@ -906,36 +1979,208 @@ namespace crequests {
         return state == error_code_t::EXPIRED;
     }
 
+    bool conn_impl_t::is_detached() const {
+        return static_cast<bool>(completion);
+    }
+
+    ioservice_t& conn_impl_t::get_service() const {
+        return ioservice;
+    }
+
     bool conn_impl_t::is_reused() const {
         return m_is_reused;
     }
 
     void conn_impl_t::end() {
+        /*
+          A connection which waited for its hedged copy has been through
+          its retry policy already.
+        */
+        if (not hedge_waiting and (try_retry() or wait_for_hedge()))
+            return;
+        hedge_waiting = false;
+
         resolver.cancel();
-        timeout_timer.cancel();
+        wheel.cancel(timeout_timer);
+        wheel.cancel(phase_timer);
+        wheel.cancel(throttle_timer);
+        wheel.cancel(hedge_timer);
+        wheel.cancel(retry_timer);
+        if (retry_wait)
+            retry_wait->cancel();
+        response.request().cancel_token().unsubscribe(cancel_subscription);
+
+        if (hedge) {
+            hedge->cancel();
+            hedge.reset();
+        }
+
+        if (speculation) {
+            speculation->cancel();
+            speculation.reset();
+        }
+
+        /*
+          A queued connection leaves the queue. If it has been granted
+          a slot just now, on_admitted() will give the slot back.
+        */
+        if (ticket)
+            service.get_limiter().cancel(ticket);
+        release_slot();
+        report_circuit();
+
+        response.queue_time(queue_time_t{static_cast<size_t>(queued_for.count())});
+        response.retries(retries_t{retries});
+        if (admitted) {
+            const auto elapsed = std::chrono::duration_cast<milliseconds_t>(
+                steady_clock_t::now() - admitted_at);
+            response.network_time(network_time_t{static_cast<size_t>(elapsed.count())});
+
+            if (state == error_code_t::SUCCESS and
+                response.request().hedge_percentile().value() > 0)
+                service.get_hedging().record(host_key, elapsed);
+        }
+
         if (response.request().final_callback())
             response.request().final_callback()(response);
-        setup_dispose_timer();
+        if (not is_detached())
+            setup_dispose_timer();
 
-        if (response.request().keep_alive()) {
-            if (response.headers().contains("Connection", "close")) {
-                stream.cancel();
-                stream.close();
-            }
-        }
-        else {
+        if (response.request().keep_alive())
+            park_stream();
+        else
             stream.cancel();
+
+        if (response.request().keep_alive() and stream.is_open()) {
+            std::lock_guard<std::mutex> lock(stream_mutex);
+            parked_origin = pool_t::key(response.request());
         }
 
         response.raw(std::move(raw));
+        finish_flight();
 
         if (response.request().body_callback())
             response.request().body_callback()(nullptr, 0, response.error());
 
-        if (response.error() and response.request().throw_on_error())
-            promise.set_exception(std::make_exception_ptr(response.error()));
+        if (completion) {
+            /*
+              The response is moved into the handler and nobody can
+              fetch it later, so there is nothing to keep it stored for.
+            */
+            completion(std::move(response));
+            set_dispose();
+        }
+        else if (response.error() and response.request().throw_on_error())
+            promise->set_exception(std::make_exception_ptr(response.error()));
         else
-            promise.set_value(response);
+            promise->set_value(response);
+    }
+
+    bool conn_impl_t::can_reuse_stream() {
+        return
+            stream.is_open() and
+            requests_left > 0 and
+            steady_clock_t::now() < idle_until and
+            stream.is_alive();
+    }
+
+    void conn_impl_t::park_stream() {
+        /*
+          A response from the cache or of another request tells nothing
+          about the socket, so it keeps the idle deadline it had.
+        */
+        if (served_from_cache or joined_flight) {
+            if (stream.is_open() and idle_until != time_point_t::max())
+                arm_idle_timer();
+            return;
+        }
+
+        const auto& hints = response.headers();
+        if (hints.contains("Connection", "close")) {
+            stream.cancel();
+            stream.close();
+            return;
+        }
+
+        if (hints.count("Keep-Alive")) {
+            size_t timeout = 0;
+            size_t max = requests_left;
+            parse_keep_alive(hints.at("Keep-Alive"), timeout, max);
+            if (timeout > 0)
+                keep_alive_timeout = seconds_t(timeout);
+            requests_left = max;
+        }
+
+        if (requests_left == 0) {
+            stream.cancel();
+            stream.close();
+            return;
+        }
+
+        if (keep_alive_timeout.count() == 0 or not stream.is_open())
+            return;
+
+        /*
+          The socket is retired a bit before the server timeout, so the
+          next request does not race the server closing it.
+        */
+        const auto idle = keep_alive_timeout > KEEP_ALIVE_MARGIN * 2
+            ? keep_alive_timeout - KEEP_ALIVE_MARGIN
+            : keep_alive_timeout / 2;
+        idle_until = steady_clock_t::now() + idle;
+        arm_idle_timer();
+    }
+
+    void conn_impl_t::arm_idle_timer() {
+        const std::weak_ptr<conn_impl_t> weak = shared_from_this();
+        idle_timer = wheel.schedule(idle_until, [weak]() {
+            if (const auto self = weak.lock())
+                self->on_idle_timer();
+        });
+    }
+
+    /*
+      Called on the service thread: the socket is idle and may be taken
+      by the next request at the same time, so it is guarded by the lock.
+    */
+    void conn_impl_t::on_idle_timer() {
+        std::lock_guard<std::mutex> lock(stream_mutex);
+        idle_timer = 0;
+        if (stream_taken)
+            return;
+
+        stream.cancel();
+        stream.close();
+    }
+
+    bool conn_impl_t::can_hand_over(const request_t& request) {
+        std::lock_guard<std::mutex> lock(stream_mutex);
+        return
+            not stream_taken and
+            not parked_origin.empty() and
+            parked_origin == pool_t::key(request);
+    }
+
+    stream_t conn_impl_t::take_stream() {
+        std::lock_guard<std::mutex> lock(stream_mutex);
+        wheel.cancel(idle_timer);
+        stream_taken = true;
+        return std::move(stream);
+    }
+
+    bool conn_impl_t::take_pooled() {
+        /*
+          Pooled connections run on the service io service, so a caller
+          owned one can not drive them.
+        */
+        if (own_ioservice or
+            not service.get_pool().take(pool_t::key(response.request()), stream))
+            return false;
+
+        m_is_reused = true;
+        requests_left = std::numeric_limits<size_t>::max();
+        idle_until = time_point_t::max();
+        return true;
     }
 
     void conn_impl_t::perform_redirect() {
@@ -949,28 +2194,62 @@ namespace crequests {
             return;
         }
 
-        auto redirects = std::move(response.redirects());
+        /*
+          The connection to the Location is still being set up, the
+          redirect goes on when it is done.
+        */
+        if (speculation) {
+            redirect_waiting = true;
+            wheel.cancel(phase_timer);
+            return;
+        }
+
+        /*
+          The socket is checked before the request is moved out of the
+          response, since the check looks at the origin of both. A socket
+          which can not take the redirect is parked for its own origin.
+        */
+        const bool reuse = can_reuse_for_redirect() and stream.is_alive();
+        const bool park =
+            not reuse and
+            not own_ioservice and
+            can_keep_stream() and
+            stream.is_alive();
+        const auto origin = pool_t::key(response.request());
+        const auto location = redirect_location(response);
+        const auto status = response.status_code().value();
+
+        const auto now = steady_clock_t::now();
 
-        if (redirects.get().empty()) {
+        auto redirects = std::move(response.redirects());
+        if (response.request().keep_redirect_responses())
             redirects.add(response);
-        }
 
         auto redirect_count = std::move(response.redirect_count());
         auto request = std::move(response.request());
+        const auto& url = request.uri().url().value();
+
+        if (request.cache_redirects())
+            service.get_redirect_cache().put(url, location, status, response.headers());
+
+        redirects.add(hop_t{
+            url, status, location,
+            std::chrono::duration_cast<milliseconds_t>(now - hop_started_at)});
+        hop_started_at = now;
 
         redirect_count.value()++;
-        request.uri(uri_t::from_string(response.headers().at("Location")));
+        request.uri(uri_t::from_string(location));
+        rewrite_method(request, status);
         request.prepare();
 
         response = response_t{std::move(request)};
         response.redirect_count(std::move(redirect_count));
         response.redirects(std::move(redirects));
 
-        redirects = response.redirects();
-        redirects.add(response);
-        response.redirects(std::move(redirects));
-
-        stream = stream_t(service.get_service(), response.request());
+        if (park)
+            service.get_pool().put(origin, std::move(stream));
+        if (not reuse)
+            stream = stream_t(ioservice, response.request());
 
         if (request_buf.size() > 0) {
             request_buf.consume(request_buf.size());
@@ -985,9 +2264,255 @@ namespace crequests {
             parser = nullptr;
         }
         parser = new parser_t(parser_t::parser_type_t::RESPONSE);
+        drained_body = 0;
         prepare_parser();
 
-        resolve();
+        m_is_reused = reuse;
+        if (reuse or take_pooled())
+            write();
+        else
+            resolve();
+    }
+
+    /*
+      The hops are followed while they are in the cache, but no more of
+      them than the redirects allowed to the request, so a loop of
+      redirects does not hang here.
+    */
+    void conn_impl_t::follow_cached_redirects() {
+        auto& request = response.request();
+        if (not request.redirect() or not request.cache_redirects())
+            return;
+
+        auto& cache = service.get_redirect_cache();
+        string_t location;
+        unsigned int status = 0;
+        bool found = false;
+
+        /*
+          The cached hops take no time, but they are a part of the history
+          and count against the limit as the ones sent are.
+        */
+        while (not is_redirect_exhausted(response)) {
+            const auto url = request.uri().url().value();
+            if (not cache.find(url, location, status))
+                break;
+
+            response.redirects().add(hop_t{url, status, location, milliseconds_t{0}});
+            response.redirect_count().value()++;
+            request.uri(uri_t::from_string(location));
+            rewrite_method(request, status);
+            request.prepare();
+            found = true;
+        }
+
+        if (found)
+            stream = stream_t(ioservice, request);
+    }
+
+    bool conn_impl_t::serve_from_cache() {
+        auto& cache = service.get_http_cache();
+        if (not cache.enabled())
+            return false;
+
+        /*
+          A stale response of a previous hop is not the one of this hop.
+        */
+        stale_entry.reset();
+        shared_body_t body;
+        switch (cache.lookup(response, body, stale_entry)) {
+        case http_cache_t::lookup_t::FRESH:
+            served_from_cache = true;
+            take_cached_body(body);
+            set_state(error_code_t::SUCCESS);
+            response.error(error_t(state, "success"));
+            end();
+            return true;
+        case http_cache_t::lookup_t::STALE:
+            return false;
+        default:
+            return false;
+        }
+    }
+
+    void conn_impl_t::update_cache() {
+        auto& cache = service.get_http_cache();
+        if (warm_up or not cache.enabled())
+            return;
+
+        shared_body_t cached;
+        if (cache.update(response, raw.value(), stale_entry, cached))
+            take_cached_body(cached);
+    }
+
+    /*
+      The body callback gets the kept body as is, without a copy.
+    */
+    void conn_impl_t::take_cached_body(const shared_body_t& body) {
+        if (response.request().body_callback())
+            response.request().body_callback()(body.data(), body.size(), error_t{});
+        else
+            raw.value().assign(body.data(), body.size());
+    }
+
+    bool conn_impl_t::join_flight() {
+        const auto& request = response.request();
+        if (not request.coalesce() or joined_flight or not flight.empty())
+            return false;
+
+        const auto key = coalescer_t::fingerprint(request);
+        if (key.empty())
+            return false;
+
+        /*
+          A body which goes to the body callback is not kept in the
+          response, so such a request can only wait.
+        */
+        const auto self = shared_from_this();
+        const auto waiter = [this, self](const shared_ptr_t<const response_t>& shared) {
+            strand.post([this, self, shared]() {
+                on_flight_done(shared);
+            });
+        };
+        const bool lead = not request.body_callback();
+        if (service.get_coalescer().wait(key, waiter, lead)) {
+            joined_flight = true;
+            return true;
+        }
+
+        if (lead)
+            flight = key;
+        return false;
+    }
+
+    void conn_impl_t::on_flight_done(const shared_ptr_t<const response_t>& shared) {
+        if (in_final_state())
+            return;
+
+        if (not shared) {
+            joined_flight = false;
+            start();
+            return;
+        }
+
+        const auto& source = *shared;
+        response.http_major(source.http_major());
+        response.http_minor(source.http_minor());
+        response.status_code(source.status_code());
+        response.status_message(source.status_message());
+        response.headers(source.headers());
+        response.cookies(source.cookies());
+        response.redirect_count(source.redirect_count());
+        response.redirects(source.redirects());
+        response.from_cache(source.from_cache());
+        response.coalesced(coalesced_t{true});
+
+        /*
+          The body callback reads the shared body in place.
+        */
+        const auto& body = source.raw().value();
+        if (response.request().body_callback())
+            response.request().body_callback()(body.data(), body.size(), error_t{});
+        else
+            raw = source.raw();
+
+        set_state(source.error().code());
+        response.error(source.error());
+        end();
+    }
+
+    void conn_impl_t::finish_flight() {
+        if (flight.empty())
+            return;
+
+        const auto key = std::move(flight);
+        flight.clear();
+
+        auto& coalescer = service.get_coalescer();
+        if (state == error_code_t::CANCELLED)
+            coalescer.finish(key, nullptr);
+        else
+            coalescer.finish(key, std::make_shared<const response_t>(response));
+    }
+
+    bool conn_impl_t::can_keep_stream() const {
+        const auto& fields = response.headers();
+        if (not response.request().keep_alive() or fields.contains("Connection", "close"))
+            return false;
+
+        if (fields.count("Content-Length"))
+            return content_length <= MAX_DRAINED_BODY;
+        return
+            fields.contains("Transfer-Encoding", "chunked") and
+            drained_body <= MAX_DRAINED_BODY;
+    }
+
+    bool conn_impl_t::can_reuse_for_redirect() const {
+        if (not can_keep_stream() or not response.headers().count("Location"))
+            return false;
+
+        const auto& uri = response.request().uri();
+        auto target = uri_t::from_string(redirect_location(response));
+        target.prepare();
+        return
+            target.protocol() == uri.protocol() and
+            target.domain() == uri.domain() and
+            target.port() == uri.port();
+    }
+
+    bool conn_impl_t::redirect_early() {
+        if (not is_redirect_code(response.status_code()) or
+            not response.request().redirect() or
+            can_reuse_for_redirect())
+            return false;
+
+        if (can_keep_stream() and
+            not own_ioservice and
+            response.headers().count("Location") and
+            not is_redirect_exhausted(response))
+        {
+            speculate_redirect();
+            return false;
+        }
+
+        stream.cancel();
+        stream.close();
+        perform_redirect();
+        return true;
+    }
+
+    /*
+      The connection is set up by a warm up one which parks it in the
+      pool, where perform_redirect() takes it from.
+    */
+    void conn_impl_t::speculate_redirect() {
+        auto target = response.request();
+        target.uri(uri_t::from_string(redirect_location(response)));
+        target.prepare();
+
+        const auto generation = ++speculation_generation;
+        const std::weak_ptr<conn_impl_t> weak = shared_from_this();
+        const auto on_done = [weak, generation](response_t&&) {
+            if (const auto self = weak.lock())
+                self->strand.post([self, generation]() {
+                    self->on_speculation_done(generation);
+                });
+        };
+
+        speculation = std::make_shared<conn_impl_t>(service, target, on_done);
+        speculation->preconnect();
+    }
+
+    void conn_impl_t::on_speculation_done(const size_t generation) {
+        if (generation != speculation_generation)
+            return;
+
+        speculation.reset();
+        if (not redirect_waiting or in_final_state())
+            return;
+
+        redirect_waiting = false;
+        perform_redirect();
     }
 
     void conn_impl_t::set_error(const error_code_t& new_state, const string_t& msg) {
@@ -1014,6 +2539,7 @@ namespace crequests {
         }
         else {
             if (not in_final_state()) {
+                update_cache();
                 set_state(error_code_t::SUCCESS);
                 response.error(error_t(state, "success"));
                 end();
@@ -1022,6 +2548,14 @@ namespace crequests {
     }
 
     void conn_impl_t::set_timeout() {
+        timed_out = true;
+        if (hedge_waiting) {
+            state = error_code_t::TIMEOUT;
+            response.error(error_t(state, "timeout"));
+            end();
+            return;
+        }
+
         if (in_final_state()) {
             if (not response.request().keep_alive())
                 stream.close();
@@ -1033,6 +2567,56 @@ namespace crequests {
         end();
     }
 
+    void conn_impl_t::set_cancel() {
+        if (hedge_waiting) {
+            state = error_code_t::CANCELLED;
+            response.error(error_t(state, "cancelled"));
+            end();
+            return;
+        }
+
+        if (in_final_state())
+            return;
+
+        set_state(error_code_t::CANCELLED);
+        response.error(error_t(state, "cancelled"));
+        resolver.cancel();
+        stream.cancel();
+        stream.close();
+        end();
+    }
+
+    void conn_impl_t::set_phase_timeout(const error_code_t& phase) {
+        if (in_final_state())
+            return;
+
+        string_t name;
+        switch (phase) {
+        case error_code_t::RESOLVE:
+            name = "resolve";
+            break;
+        case error_code_t::CONNECT:
+            name = "connect";
+            break;
+        case error_code_t::HANDSHAKE:
+            name = "handshake";
+            break;
+        case error_code_t::READ_STATUS:
+            name = "first byte";
+            break;
+        default:
+            name = "read";
+            break;
+        }
+
+        set_state(error_code_t::TIMEOUT);
+        response.error(error_t(state, name + " timeout"));
+        resolver.cancel();
+        stream.cancel();
+        stream.close();
+        end();
+    }
+
     void conn_impl_t::set_dispose() {
         set_state(error_code_t::EXPIRED);
     }
@@ -1058,6 +2642,10 @@ namespace crequests {
         case error_code_t::REDIRECT_EXHAUSTED:
         case error_code_t::REDIRECT_ERROR:
         case error_code_t::TIMEOUT:
+        case error_code_t::CANCELLED:
+        case error_code_t::QUEUE_FULL:
+        case error_code_t::QUEUE_TIMEOUT:
+        case error_code_t::CIRCUIT_OPEN:
         case error_code_t::EXPIRED:
         case error_code_t::SUCCESS:
             return true;
@@ -1085,16 +2673,28 @@ namespace crequests {
      ************************************************************/
 
 
-    connection_t::connection_t(service_t& service, const request_t& request)
-        : pimpl(std::make_shared<conn_impl_t>(service, request))
+    connection_t::connection_t(service_t& service,
+                               const request_t& request,
+                               const completion_handler_t& completion)
+        : pimpl(std::make_shared<conn_impl_t>(service, request, completion))
+    {
+
+    }
+
+    connection_t::connection_t(service_t& service,
+                               const request_t& request,
+                               const connection_t& connection,
+                               const completion_handler_t& completion)
+        : pimpl(std::make_shared<conn_impl_t>(service, request, connection, completion))
     {
 
     }
 
     connection_t::connection_t(service_t& service,
+                               const ioservice_ptr_t& ioservice,
                                const request_t& request,
-                               const connection_t& connection)
-        : pimpl(std::make_shared<conn_impl_t>(service, request, connection))
+                               const completion_handler_t& completion)
+        : pimpl(std::make_shared<conn_impl_t>(service, ioservice, request, completion))
     {
 
     }
@@ -1104,6 +2704,12 @@ namespace crequests {
 
     }
 
+    connection_t::connection_t(const connection_t& connection)
+        : pimpl {connection.pimpl}
+    {
+
+    }
+
     connection_t::connection_t(connection_t&& connection)
         : pimpl {std::move(connection.pimpl)}
     {
@@ -1141,9 +2747,29 @@ namespace crequests {
         pimpl->start();
     }
 
+    void connection_t::preconnect() {
+        pimpl->preconnect();
+    }
+
+    void connection_t::cancel() const {
+        pimpl->cancel();
+    }
+
     bool connection_t::is_expired() const {
         return pimpl->is_expired();
     }
 
+    bool connection_t::is_detached() const {
+        return pimpl->is_detached();
+    }
+
+    bool connection_t::can_hand_over(const request_t& request) const {
+        return pimpl->can_hand_over(request);
+    }
+
+    ioservice_t& connection_t::get_service() const {
+        return pimpl->get_service();
+    }
+
 
 } /* namespace crequests */
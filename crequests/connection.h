@@ -12,10 +12,16 @@ namespace crequests {
     class connection_t {
     public:
         connection_t(service_t& service,
-                     const request_t& request);
+                     const request_t& request,
+                     const completion_handler_t& completion = nullptr);
+        connection_t(service_t& service,
+                     const request_t& request,
+                     const connection_t& connection,
+                     const completion_handler_t& completion = nullptr);
         connection_t(service_t& service,
+                     const ioservice_ptr_t& ioservice,
                      const request_t& request,
-                     const connection_t& connection);
+                     const completion_handler_t& completion = nullptr);
         ~connection_t();
         connection_t(const connection_t& connection);
         connection_t(connection_t&& connection);
@@ -36,6 +42,20 @@ namespace crequests {
         */
         void start();
 
+        /*
+          This function only sets up the connection (resolve, connect and
+          handshake) and parks it in the pool of the service for the
+          requests to come. The response tells whether it has succeeded.
+        */
+        void preconnect();
+
+        /*
+          This function aborts the connection. It can be called from any
+          thread. A connection which is not done yet ends up with the
+          CANCELLED error.
+        */
+        void cancel() const;
+
         /*
           This function say us that the current connection is expired.
           This means the current connection ends up + waited dispose
@@ -44,6 +64,26 @@ namespace crequests {
         */
         bool is_expired() const;
 
+        /*
+          This function returns true if the connection delivers its response
+          into a completion handler. Such connection has no future response.
+        */
+        bool is_detached() const;
+
+        /*
+          This function returns the io service which drives I/O of the
+          connection. It is the service one unless the connection was
+          created on a caller owned io service.
+        */
+        ioservice_t& get_service() const;
+
+        /*
+          This function returns true if the connection is done and keeps
+          its socket alive for the origin of the given request, so the
+          socket can be handed over without waiting for the response.
+        */
+        bool can_hand_over(const request_t& request) const;
+
     private:
         friend class conn_impl_t;
         shared_ptr_t<class conn_impl_t> pimpl;
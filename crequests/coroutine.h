@@ -0,0 +1,149 @@
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+/*
+  C++20 coroutine support. The library itself is built as C++11, so
+  everything here is header only and is available when the user code
+  is compiled with coroutines enabled.
+*/
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#define CREQUESTS_HAS_COROUTINES 1
+#endif
+
+#ifdef CREQUESTS_HAS_COROUTINES
+
+#include "api.h"
+
+#include <coroutine>
+
+namespace crequests {
+
+
+    /*
+      Awaitable result of a request. The request is sent when the
+      coroutine is suspended on it and the coroutine is resumed directly
+      from the service thread when the connection ends up. So the code
+      after co_await runs on the service thread and must not block it
+      (for example, by calling synchronous Get() of the same service).
+    */
+    class awaitable_response_t {
+    public:
+        explicit awaitable_response_t(const session_t& session)
+            : m_session(session)
+        {
+
+        }
+
+    public:
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            /*
+              The coroutine may be resumed on the service thread before
+              AsyncSend returns, so nothing of this object is used after it.
+            */
+            const auto session = m_session;
+            const auto completion = [this, handle](response_t&& response) {
+                m_response.emplace(std::move(response));
+                handle.resume();
+            };
+            session.AsyncSend(completion_handler_t{completion});
+        }
+
+        response_t await_resume() {
+            if (m_response->error() and m_response->request().throw_on_error())
+                throw m_response->error();
+            return std::move(*m_response);
+        }
+
+    private:
+        session_t m_session;
+        optional_t<response_t> m_response {};
+    };
+
+
+    inline awaitable_response_t async_send(session_t& session) {
+        return awaitable_response_t{session};
+    }
+
+    inline awaitable_response_t async_get(session_t& session) {
+        session.set_option(method_t {"GET"});
+        return async_send(session);
+    }
+
+    inline awaitable_response_t async_post(session_t& session) {
+        session.set_option(method_t {"POST"});
+        return async_send(session);
+    }
+
+    inline awaitable_response_t async_put(session_t& session) {
+        session.set_option(method_t {"PUT"});
+        return async_send(session);
+    }
+
+    inline awaitable_response_t async_patch(session_t& session) {
+        session.set_option(method_t {"PATCH"});
+        return async_send(session);
+    }
+
+    inline awaitable_response_t async_delete(session_t& session) {
+        session.set_option(method_t {"DELETE"});
+        return async_send(session);
+    }
+
+    inline awaitable_response_t async_head(session_t& session) {
+        session.set_option(method_t {"HEAD"});
+        return async_send(session);
+    }
+
+    template <class ServiceT, class... Args>
+    awaitable_response_t async_get(ServiceT&& service, Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        return async_get(session);
+    }
+
+    template <class ServiceT, class... Args>
+    awaitable_response_t async_post(ServiceT&& service, Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        return async_post(session);
+    }
+
+    template <class ServiceT, class... Args>
+    awaitable_response_t async_put(ServiceT&& service, Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        return async_put(session);
+    }
+
+    template <class ServiceT, class... Args>
+    awaitable_response_t async_patch(ServiceT&& service, Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        return async_patch(session);
+    }
+
+    template <class ServiceT, class... Args>
+    awaitable_response_t async_delete(ServiceT&& service, Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        return async_delete(session);
+    }
+
+    template <class ServiceT, class... Args>
+    awaitable_response_t async_head(ServiceT&& service, Args&& ...args) {
+        auto& session = service.new_session();
+        set_option(session, std::forward<Args>(args)...);
+        return async_head(session);
+    }
+
+
+} /* namespace crequests */
+
+#endif /* CREQUESTS_HAS_COROUTINES */
+
+#endif /* COROUTINE_H */
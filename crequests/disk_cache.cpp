@@ -0,0 +1,663 @@
+#include "disk_cache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <set>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace crequests {
+
+
+    namespace {
+
+        const std::uint64_t INDEX_MAGIC = 0x3130584449515243ull;
+        const std::uint32_t RECORD_MAGIC = 0x43455243u;
+        const std::uint64_t INDEX_SLOTS = 16384;
+        const std::uint64_t PROBES = 16;
+
+        /*
+          The store is split into about this number of segments, so the
+          oldest eighth of it is dropped at once when it is full.
+        */
+        const size_t SEGMENTS = 8;
+        const size_t MIN_SEGMENT_SIZE = 1 << 20;
+        const size_t MAX_SEGMENT_SIZE = 256 << 20;
+        const size_t DEFAULT_MAX_DISK_CACHE_SIZE = 1 << 30;
+
+        struct index_header_t {
+            std::uint64_t magic;
+            std::uint64_t slots;
+            std::uint64_t first_segment;
+            std::uint64_t last_segment;
+        };
+
+        /*
+          The check is a hash of the other fields, a slot which was torn
+          by a crash does not match it.
+        */
+        struct slot_t {
+            std::uint64_t hash;
+            std::uint64_t segment;
+            std::uint64_t offset;
+            std::uint64_t length;
+            std::uint64_t check;
+        };
+
+        struct record_header_t {
+            std::uint32_t magic;
+            std::uint32_t key_size;
+            std::uint32_t meta_size;
+            std::uint32_t reserved;
+            std::uint64_t body_size;
+            std::uint64_t checksum;
+        };
+
+        std::uint64_t fnv1a(const char* data,
+                            const size_t size,
+                            std::uint64_t hash = 14695981039346656037ull) {
+            for (size_t i = 0; i < size; ++i) {
+                hash ^= static_cast<unsigned char>(data[i]);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        std::uint64_t key_hash(const string_t& key) {
+            const auto hash = fnv1a(key.data(), key.size());
+            return hash == 0 ? 1 : hash;
+        }
+
+        std::uint64_t slot_check(const slot_t& slot) {
+            return fnv1a(reinterpret_cast<const char*>(&slot), offsetof(slot_t, check));
+        }
+
+        /*
+          The checksum covers the whole record, so a body which was not
+          written to the end before a crash is not served. It is checked
+          once for a record while the store is open.
+        */
+        std::uint64_t record_checksum(const string_t& key,
+                                      const char* meta,
+                                      const size_t meta_size,
+                                      const char* body,
+                                      const std::uint64_t body_size) {
+            auto hash = fnv1a(key.data(), key.size());
+            hash = fnv1a(meta, meta_size, hash);
+            hash = fnv1a(reinterpret_cast<const char*>(&body_size), sizeof(body_size), hash);
+            return fnv1a(body, static_cast<size_t>(body_size), hash);
+        }
+
+        bool write_all(const int fd, const char* data, size_t size) {
+            while (size > 0) {
+                const auto written = ::write(fd, data, size);
+                if (written < 0 and errno == EINTR)
+                    continue;
+                if (written <= 0)
+                    return false;
+                data += written;
+                size -= static_cast<size_t>(written);
+            }
+            return true;
+        }
+
+        /*
+          A read only mapping of a whole segment.
+        */
+        class mapping_t {
+        public:
+            mapping_t(void* addr, const size_t size)
+                : m_addr(addr),
+                  m_size(size)
+            {}
+
+            mapping_t(const mapping_t& mapping) = delete;
+            mapping_t& operator=(const mapping_t& mapping) = delete;
+
+            ~mapping_t() {
+                ::munmap(m_addr, m_size);
+            }
+
+            const char* data() const {
+                return static_cast<const char*>(m_addr);
+            }
+
+            size_t size() const {
+                return m_size;
+            }
+
+        private:
+            void* m_addr;
+            size_t m_size;
+        };
+
+        shared_ptr_t<mapping_t> map_file(const string_t& path) {
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return nullptr;
+
+            struct stat st {};
+            shared_ptr_t<mapping_t> rv;
+            if (::fstat(fd, &st) == 0 and st.st_size > 0) {
+                const auto size = static_cast<size_t>(st.st_size);
+                void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+                if (addr != MAP_FAILED)
+                    rv = std::make_shared<mapping_t>(addr, size);
+            }
+
+            ::close(fd);
+            return rv;
+        }
+
+    } /* anonymous namespace */
+
+
+    /************************************************************
+     * shared_body_t section.
+     ************************************************************/
+
+
+    shared_body_t::shared_body_t()
+        : m_owner{},
+          m_data{nullptr},
+          m_size{0}
+    {
+
+    }
+
+    shared_body_t::shared_body_t(const shared_ptr_t<const void>& owner,
+                                 const char* data,
+                                 const size_t size)
+        : m_owner{owner},
+          m_data{data},
+          m_size{size}
+    {
+
+    }
+
+    const char* shared_body_t::data() const {
+        return m_data;
+    }
+
+    size_t shared_body_t::size() const {
+        return m_size;
+    }
+
+
+    /************************************************************
+     * disk_cache_impl_t section.
+     ************************************************************/
+
+
+    class disk_cache_impl_t {
+    public:
+        disk_cache_impl_t() = default;
+        disk_cache_impl_t(const disk_cache_impl_t& disk_cache) = delete;
+        disk_cache_impl_t& operator=(const disk_cache_impl_t& disk_cache) = delete;
+        ~disk_cache_impl_t();
+
+    public:
+        bool set_option(const cache_directory_t& cache_directory);
+        void set_option(const max_disk_cache_size_t& max_disk_cache_size);
+        bool enabled() const;
+        bool put(const string_t& key, const string_t& meta, const char* body, const size_t body_size);
+        bool get(const string_t& key, string_t& meta, shared_body_t& body);
+        void erase(const string_t& key);
+        size_t size() const;
+        size_t count() const;
+        void clear();
+
+    private:
+        string_t segment_path(const std::uint64_t segment) const;
+        index_header_t& header() const;
+        slot_t* slots() const;
+        bool is_valid(const slot_t& slot) const;
+        slot_t* find(const std::uint64_t hash) const;
+        slot_t* choose(const std::uint64_t hash) const;
+        void sync(const void* addr, const size_t size) const;
+        void reset(slot_t& slot) const;
+        bool open_segment(const bool truncate);
+        void roll();
+        void evict();
+        size_t total() const;
+        void close();
+
+    private:
+        mutable std::mutex mutex {};
+        string_t directory {};
+        int index_fd {-1};
+        char* index {nullptr};
+        size_t index_size {0};
+        int segment_fd {-1};
+        std::map<std::uint64_t, size_t> segment_sizes {};
+        std::map<std::uint64_t, shared_ptr_t<mapping_t> > mappings {};
+        std::set<std::pair<std::uint64_t, std::uint64_t> > verified {};
+        size_t max_disk_cache_size {DEFAULT_MAX_DISK_CACHE_SIZE};
+    };
+
+    disk_cache_impl_t::~disk_cache_impl_t() {
+        close();
+    }
+
+    string_t disk_cache_impl_t::segment_path(const std::uint64_t segment) const {
+        return directory + "/segment." + std::to_string(segment);
+    }
+
+    index_header_t& disk_cache_impl_t::header() const {
+        return *reinterpret_cast<index_header_t*>(index);
+    }
+
+    slot_t* disk_cache_impl_t::slots() const {
+        return reinterpret_cast<slot_t*>(index + sizeof(index_header_t));
+    }
+
+    bool disk_cache_impl_t::is_valid(const slot_t& slot) const {
+        return
+            slot.hash != 0 and
+            slot.check == slot_check(slot) and
+            slot.segment >= header().first_segment and
+            slot.segment <= header().last_segment;
+    }
+
+    slot_t* disk_cache_impl_t::find(const std::uint64_t hash) const {
+        for (std::uint64_t i = 0; i < PROBES; ++i) {
+            auto& slot = slots()[(hash + i) % INDEX_SLOTS];
+            if (slot.hash == hash and is_valid(slot))
+                return &slot;
+        }
+        return nullptr;
+    }
+
+    /*
+      The slot of the same key, else a free one, else the first one of
+      the probes is taken over.
+    */
+    slot_t* disk_cache_impl_t::choose(const std::uint64_t hash) const {
+        slot_t* free = nullptr;
+        for (std::uint64_t i = 0; i < PROBES; ++i) {
+            auto& slot = slots()[(hash + i) % INDEX_SLOTS];
+            const bool valid = is_valid(slot);
+            if (valid and slot.hash == hash)
+                return &slot;
+            if (not valid and not free)
+                free = &slot;
+        }
+        return free ? free : &slots()[hash % INDEX_SLOTS];
+    }
+
+    void disk_cache_impl_t::sync(const void* addr, const size_t size) const {
+        static const auto page = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+        const auto begin = reinterpret_cast<std::uintptr_t>(addr) / page * page;
+        const auto end = reinterpret_cast<std::uintptr_t>(addr) + size;
+        ::msync(reinterpret_cast<void*>(begin), end - begin, MS_SYNC);
+    }
+
+    void disk_cache_impl_t::reset(slot_t& slot) const {
+        std::memset(&slot, 0, sizeof(slot));
+        sync(&slot, sizeof(slot));
+    }
+
+    bool disk_cache_impl_t::open_segment(const bool truncate) {
+        if (segment_fd >= 0)
+            ::close(segment_fd);
+
+        const auto last = header().last_segment;
+        segment_fd = ::open(segment_path(last).c_str(),
+                            O_WRONLY | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0),
+                            0644);
+        if (segment_fd < 0)
+            return false;
+
+        struct stat st {};
+        segment_sizes[last] = ::fstat(segment_fd, &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+        return true;
+    }
+
+    void disk_cache_impl_t::close() {
+        if (segment_fd >= 0)
+            ::close(segment_fd);
+        if (index)
+            ::munmap(index, index_size);
+        if (index_fd >= 0)
+            ::close(index_fd);
+
+        segment_fd = -1;
+        index = nullptr;
+        index_fd = -1;
+        directory.clear();
+        segment_sizes.clear();
+        mappings.clear();
+        verified.clear();
+    }
+
+    /*
+      The index is rebuilt when it is missing or is not of this version,
+      the records of the old segments are not reachable then.
+    */
+    bool disk_cache_impl_t::set_option(const cache_directory_t& cache_directory) {
+        std::lock_guard<std::mutex> lock(mutex);
+        close();
+        if (cache_directory.empty())
+            return true;
+
+        const auto& path = cache_directory.value();
+        if (::mkdir(path.c_str(), 0755) != 0 and errno != EEXIST)
+            return false;
+
+        index_fd = ::open((path + "/index").c_str(), O_RDWR | O_CREAT, 0644);
+        if (index_fd < 0)
+            return false;
+
+        if (::flock(index_fd, LOCK_EX | LOCK_NB) != 0) {
+            close();
+            return false;
+        }
+
+        index_size = sizeof(index_header_t) + INDEX_SLOTS * sizeof(slot_t);
+        struct stat st {};
+        const bool resized =
+            ::fstat(index_fd, &st) != 0 or static_cast<size_t>(st.st_size) != index_size;
+        if (resized and
+            (::ftruncate(index_fd, 0) != 0 or
+             ::ftruncate(index_fd, static_cast<off_t>(index_size)) != 0))
+        {
+            close();
+            return false;
+        }
+
+        void* addr = ::mmap(nullptr, index_size, PROT_READ | PROT_WRITE, MAP_SHARED, index_fd, 0);
+        if (addr == MAP_FAILED) {
+            close();
+            return false;
+        }
+        index = static_cast<char*>(addr);
+        directory = path;
+
+        const bool rebuilt = header().magic != INDEX_MAGIC or header().slots != INDEX_SLOTS;
+        if (rebuilt) {
+            std::memset(index, 0, index_size);
+            header().magic = INDEX_MAGIC;
+            header().slots = INDEX_SLOTS;
+            sync(index, index_size);
+        }
+
+        for (auto segment = header().first_segment; segment < header().last_segment; ++segment) {
+            struct stat segment_st {};
+            if (::stat(segment_path(segment).c_str(), &segment_st) == 0)
+                segment_sizes[segment] = static_cast<size_t>(segment_st.st_size);
+        }
+
+        if (not open_segment(rebuilt)) {
+            close();
+            return false;
+        }
+
+        evict();
+        return true;
+    }
+
+    void disk_cache_impl_t::set_option(const max_disk_cache_size_t& max_disk_cache_size_) {
+        std::lock_guard<std::mutex> lock(mutex);
+        max_disk_cache_size = max_disk_cache_size_.value();
+        if (index)
+            evict();
+    }
+
+    bool disk_cache_impl_t::enabled() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return index != nullptr;
+    }
+
+    void disk_cache_impl_t::roll() {
+        header().last_segment++;
+        sync(&header(), sizeof(index_header_t));
+        open_segment(true);
+    }
+
+    /*
+      Mapped bodies of the deleted segments stay readable until they
+      are released.
+    */
+    void disk_cache_impl_t::evict() {
+        while (total() > max_disk_cache_size and header().first_segment < header().last_segment) {
+            const auto first = header().first_segment;
+            ::unlink(segment_path(first).c_str());
+            segment_sizes.erase(first);
+            mappings.erase(first);
+            verified.erase(verified.lower_bound({first, 0}), verified.lower_bound({first + 1, 0}));
+            header().first_segment++;
+            sync(&header(), sizeof(index_header_t));
+        }
+    }
+
+    /*
+      Neither the record nor the slot is synced, since the write is done
+      for every cacheable response: the check of the slot is written
+      last, and the checksum of the record tells on the first lookup
+      after a crash whether the record got to the disk whole. A record
+      written here is known to be whole.
+    */
+    bool disk_cache_impl_t::put(const string_t& key,
+                                const string_t& meta,
+                                const char* body,
+                                const size_t body_size) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto length = sizeof(record_header_t) + key.size() + meta.size() + body_size;
+        if (not index or segment_fd < 0 or length > max_disk_cache_size)
+            return false;
+
+        const auto segment_size = std::min(
+            MAX_SEGMENT_SIZE,
+            std::max(MIN_SEGMENT_SIZE, max_disk_cache_size / SEGMENTS));
+        auto offset = segment_sizes[header().last_segment];
+        if (offset > 0 and offset + length > segment_size) {
+            roll();
+            if (segment_fd < 0)
+                return false;
+            offset = 0;
+        }
+
+        record_header_t record {};
+        record.magic = RECORD_MAGIC;
+        record.key_size = static_cast<std::uint32_t>(key.size());
+        record.meta_size = static_cast<std::uint32_t>(meta.size());
+        record.body_size = body_size;
+        record.checksum = record_checksum(key, meta.data(), meta.size(), body, body_size);
+
+        const bool written =
+            write_all(segment_fd, reinterpret_cast<const char*>(&record), sizeof(record)) and
+            write_all(segment_fd, key.data(), key.size()) and
+            write_all(segment_fd, meta.data(), meta.size()) and
+            write_all(segment_fd, body, body_size);
+        /*
+          The segment may be mapped for the bodies read from it, so it is
+          never truncated below them: when the torn record can not be cut
+          off, the next records go to a new segment.
+        */
+        if (not written) {
+            if (::ftruncate(segment_fd, static_cast<off_t>(offset)) != 0)
+                roll();
+            return false;
+        }
+        segment_sizes[header().last_segment] = offset + length;
+
+        const auto hash = key_hash(key);
+        auto& slot = *choose(hash);
+        slot.check = 0;
+        slot.hash = hash;
+        slot.segment = header().last_segment;
+        slot.offset = offset;
+        slot.length = length;
+        slot.check = slot_check(slot);
+        verified.emplace(slot.segment, offset);
+
+        evict();
+        return true;
+    }
+
+    bool disk_cache_impl_t::get(const string_t& key, string_t& meta, shared_body_t& body) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (not index)
+            return false;
+
+        auto slot = find(key_hash(key));
+        if (not slot)
+            return false;
+
+        /*
+          The last segment grows, so it is mapped again when the record
+          is past the end of its mapping.
+        */
+        auto& mapping = mappings[slot->segment];
+        if (not mapping or mapping->size() < slot->offset + slot->length)
+            mapping = map_file(segment_path(slot->segment));
+        if (not mapping or mapping->size() < slot->offset + slot->length) {
+            reset(*slot);
+            return false;
+        }
+
+        record_header_t record {};
+        const char* at = mapping->data() + slot->offset;
+        std::memcpy(&record, at, sizeof(record));
+        at += sizeof(record);
+
+        /*
+          The whole body is read for the checksum only the first time,
+          so the later lookups touch just the pages which are served.
+        */
+        const char* meta_at = at + record.key_size;
+        const std::pair<std::uint64_t, std::uint64_t> place {slot->segment, slot->offset};
+        const bool matches =
+            record.magic == RECORD_MAGIC and
+            sizeof(record) + record.key_size + record.meta_size + record.body_size == slot->length and
+            key.compare(0, string_t::npos, at, record.key_size) == 0 and
+            (verified.count(place) or
+             record.checksum == record_checksum(key, meta_at, record.meta_size,
+                                                meta_at + record.meta_size, record.body_size));
+        if (not matches) {
+            reset(*slot);
+            return false;
+        }
+        verified.insert(place);
+
+        meta.assign(meta_at, record.meta_size);
+        body = shared_body_t(mapping, meta_at + record.meta_size, record.body_size);
+        return true;
+    }
+
+    void disk_cache_impl_t::erase(const string_t& key) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (not index)
+            return;
+
+        if (const auto slot = find(key_hash(key)))
+            reset(*slot);
+    }
+
+    size_t disk_cache_impl_t::size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return total();
+    }
+
+    size_t disk_cache_impl_t::total() const {
+        size_t rv = 0;
+        for (const auto& segment : segment_sizes)
+            rv += segment.second;
+        return rv;
+    }
+
+    size_t disk_cache_impl_t::count() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (not index)
+            return 0;
+
+        size_t rv = 0;
+        for (std::uint64_t i = 0; i < INDEX_SLOTS; ++i)
+            rv += is_valid(slots()[i]) ? 1 : 0;
+        return rv;
+    }
+
+    void disk_cache_impl_t::clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (not index)
+            return;
+
+        for (const auto& segment : segment_sizes)
+            ::unlink(segment_path(segment.first).c_str());
+        segment_sizes.clear();
+        mappings.clear();
+        verified.clear();
+
+        const auto next = header().last_segment + 1;
+        std::memset(slots(), 0, INDEX_SLOTS * sizeof(slot_t));
+        header().first_segment = next;
+        header().last_segment = next;
+        sync(index, index_size);
+        open_segment(true);
+    }
+
+
+    /************************************************************
+     * disk_cache_t section.
+     ************************************************************/
+
+
+    disk_cache_t::disk_cache_t()
+        : pimpl{std::make_shared<disk_cache_impl_t>()}
+    {
+
+    }
+
+    disk_cache_t::~disk_cache_t() {
+
+    }
+
+    bool disk_cache_t::set_option(const cache_directory_t& cache_directory) {
+        return pimpl->set_option(cache_directory);
+    }
+
+    void disk_cache_t::set_option(const max_disk_cache_size_t& max_disk_cache_size) {
+        pimpl->set_option(max_disk_cache_size);
+    }
+
+    bool disk_cache_t::enabled() const {
+        return pimpl->enabled();
+    }
+
+    bool disk_cache_t::put(const string_t& key,
+                           const string_t& meta,
+                           const char* body,
+                           const size_t body_size) {
+        return pimpl->put(key, meta, body, body_size);
+    }
+
+    bool disk_cache_t::get(const string_t& key, string_t& meta, shared_body_t& body) {
+        return pimpl->get(key, meta, body);
+    }
+
+    void disk_cache_t::erase(const string_t& key) {
+        pimpl->erase(key);
+    }
+
+    size_t disk_cache_t::size() const {
+        return pimpl->size();
+    }
+
+    size_t disk_cache_t::count() const {
+        return pimpl->count();
+    }
+
+    void disk_cache_t::clear() {
+        pimpl->clear();
+    }
+
+
+} /* namespace crequests */
@@ -0,0 +1,93 @@
+#ifndef DISK_CACHE_H
+#define DISK_CACHE_H
+
+#include "macros.h"
+#include "types.h"
+
+namespace crequests {
+
+
+    /*
+      Service options of the disk tier of the http cache: the directory
+      it is kept in (empty, the default, turns it off) and how many bytes
+      of responses are kept there (a gigabyte by default).
+    */
+    declare_string(cache_directory)
+    declare_number(max_disk_cache_size, size_t)
+
+
+    /*
+      Body of a cached response which is shared instead of copied. It
+      stays valid as long as the object lives, even if the response is
+      dropped from the cache meanwhile.
+    */
+    class shared_body_t {
+    public:
+        shared_body_t();
+        shared_body_t(const shared_ptr_t<const void>& owner,
+                      const char* data,
+                      const size_t size);
+        shared_body_t(const shared_body_t& body) = default;
+        shared_body_t& operator=(const shared_body_t& body) = default;
+
+    public:
+        const char* data() const;
+        size_t size() const;
+
+    private:
+        shared_ptr_t<const void> m_owner;
+        const char* m_data;
+        size_t m_size;
+    };
+
+
+    /*
+      Persistent store of the responses of the http cache. The records
+      (a key, the metadata and the body) are appended to segment files,
+      and a hash index of the keys is mapped into memory. Bodies are read
+      right from the mapped segments. Writes are not synced: an index
+      slot is checked before it is used and a record is checked against
+      the checksum of its key, metadata and body the first time it is
+      read after the store is opened, so a crash loses the last records
+      at most. When the store is full the oldest segment is deleted. A directory is used
+      by one service at a time. Can be used from any thread.
+    */
+    class disk_cache_t {
+    public:
+        disk_cache_t();
+        disk_cache_t(const disk_cache_t& disk_cache) = delete;
+        disk_cache_t& operator=(const disk_cache_t& disk_cache) = delete;
+        ~disk_cache_t();
+
+    public:
+        /*
+          Opens (creating it if needed) the directory. Returns false when
+          it can not be used, the store is off then.
+        */
+        bool set_option(const cache_directory_t& cache_directory);
+        void set_option(const max_disk_cache_size_t& max_disk_cache_size);
+        bool enabled() const;
+
+        bool put(const string_t& key,
+                 const string_t& meta,
+                 const char* body,
+                 const size_t body_size);
+        bool get(const string_t& key, string_t& meta, shared_body_t& body);
+        void erase(const string_t& key);
+
+        /*
+          Bytes of the segments and records in the index.
+        */
+        size_t size() const;
+        size_t count() const;
+        void clear();
+
+    private:
+        friend class disk_cache_impl_t;
+        shared_ptr_t<class disk_cache_impl_t> pimpl;
+    };
+
+
+} /* namespace crequests */
+
+#endif /* DISK_CACHE_H */
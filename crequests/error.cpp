@@ -55,6 +55,14 @@ namespace crequests {
             return "REDIRECT_ERROR";
         case error_code_t::TIMEOUT:
             return "TIMEOUT";
+        case error_code_t::CANCELLED:
+            return "CANCELLED";
+        case error_code_t::QUEUE_FULL:
+            return "QUEUE_FULL";
+        case error_code_t::QUEUE_TIMEOUT:
+            return "QUEUE_TIMEOUT";
+        case error_code_t::CIRCUIT_OPEN:
+            return "CIRCUIT_OPEN";
         case error_code_t::EXPIRED:
             return "EXPIRED";
         case error_code_t::SUCCESS:
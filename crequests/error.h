@@ -31,6 +31,10 @@ namespace crequests {
         REDIRECT_EXHAUSTED,
         REDIRECT_ERROR,
         TIMEOUT,
+        CANCELLED,
+        QUEUE_FULL,
+        QUEUE_TIMEOUT,
+        CIRCUIT_OPEN,
         EXPIRED,
         SUCCESS
     };
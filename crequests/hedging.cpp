@@ -0,0 +1,159 @@
+#include "budget.h"
+#include "hedging.h"
+
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace crequests {
+
+
+    namespace {
+
+        /*
+          Latencies kept per host and the least of them to take
+          a percentile from.
+        */
+        const size_t WINDOW = 128;
+        const size_t MIN_SAMPLES = 16;
+
+        /*
+          Latencies of this number of hosts are kept, the ones of the least
+          recently used host are forgotten first.
+        */
+        const size_t MAX_HOSTS = 1024;
+
+    } /* anonymous namespace */
+
+
+    /************************************************************
+     * hedging_impl_t section.
+     ************************************************************/
+
+
+    class hedging_impl_t {
+    public:
+        void budget(const size_t value);
+        void record(const string_t& host, const milliseconds_t& latency);
+        optional_t<milliseconds_t> percentile(const string_t& host,
+                                              const size_t percent) const;
+        void deposit();
+        bool withdraw();
+
+    private:
+        using lru_t = std::list<string_t>;
+
+        struct host_t {
+            vector_t<milliseconds_t> latencies {};
+            size_t next {0};
+            lru_t::iterator lru_it {};
+        };
+
+    private:
+        host_t& touch(const string_t& host);
+
+    private:
+        mutable std::mutex mutex {};
+        budget_t m_budget {10};
+        std::unordered_map<string_t, host_t> hosts {};
+        lru_t lru {};
+    };
+
+    void hedging_impl_t::budget(const size_t value) {
+        m_budget.percent(value);
+    }
+
+    void hedging_impl_t::record(const string_t& host, const milliseconds_t& latency) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& state = touch(host);
+        if (state.latencies.size() < WINDOW) {
+            state.latencies.push_back(latency);
+        }
+        else {
+            state.latencies[state.next] = latency;
+            state.next = (state.next + 1) % WINDOW;
+        }
+    }
+
+    hedging_impl_t::host_t& hedging_impl_t::touch(const string_t& host) {
+        const auto it = hosts.find(host);
+        if (it != hosts.end()) {
+            lru.splice(lru.end(), lru, it->second.lru_it);
+            return it->second;
+        }
+
+        if (hosts.size() >= MAX_HOSTS) {
+            hosts.erase(lru.front());
+            lru.pop_front();
+        }
+
+        auto& state = hosts[host];
+        state.lru_it = lru.insert(lru.end(), host);
+        return state;
+    }
+
+    optional_t<milliseconds_t> hedging_impl_t::percentile(const string_t& host,
+                                                          const size_t percent) const {
+        vector_t<milliseconds_t> latencies;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto it = hosts.find(host);
+            if (it == hosts.end() or it->second.latencies.size() < MIN_SAMPLES)
+                return boost::none;
+            latencies = it->second.latencies;
+        }
+
+        const auto n = std::min(latencies.size() - 1,
+                                latencies.size() * std::min<size_t>(percent, 100) / 100);
+        std::nth_element(latencies.begin(), latencies.begin() + n, latencies.end());
+        return latencies[n];
+    }
+
+    void hedging_impl_t::deposit() {
+        m_budget.deposit();
+    }
+
+    bool hedging_impl_t::withdraw() {
+        return m_budget.withdraw();
+    }
+
+
+    /************************************************************
+     * hedging_t section.
+     ************************************************************/
+
+
+    hedging_t::hedging_t()
+        : pimpl{std::make_shared<hedging_impl_t>()}
+    {
+
+    }
+
+    hedging_t::~hedging_t() {
+
+    }
+
+    void hedging_t::set_option(const hedge_budget_t& hedge_budget) {
+        pimpl->budget(hedge_budget.value());
+    }
+
+    void hedging_t::record(const string_t& host, const milliseconds_t& latency) {
+        pimpl->record(host, latency);
+    }
+
+    optional_t<milliseconds_t> hedging_t::percentile(const string_t& host,
+                                                     const size_t percent) const {
+        return pimpl->percentile(host, percent);
+    }
+
+    void hedging_t::deposit() {
+        pimpl->deposit();
+    }
+
+    bool hedging_t::withdraw() {
+        return pimpl->withdraw();
+    }
+
+
+} /* namespace crequests */
@@ -0,0 +1,59 @@
+#ifndef HEDGING_H
+#define HEDGING_H
+
+#include "macros.h"
+#include "types.h"
+
+namespace crequests {
+
+
+    /*
+      Service option: hedged copies may add at most this percent of
+      the hedgeable requests on top of them (10 by default).
+    */
+    declare_number(hedge_budget, size_t)
+
+
+    /*
+      Shared state of the hedged requests of a service: recent latencies
+      of the hosts for the percentile delays and the budget of the extra
+      copies. Can be used from any thread.
+    */
+    class hedging_t {
+    public:
+        hedging_t();
+        hedging_t(const hedging_t& hedging) = delete;
+        hedging_t& operator=(const hedging_t& hedging) = delete;
+        ~hedging_t();
+
+    public:
+        void set_option(const hedge_budget_t& hedge_budget);
+
+        /*
+          Remembers the latency of a good response of the host.
+        */
+        void record(const string_t& host, const milliseconds_t& latency);
+
+        /*
+          The given percentile of the recent latencies of the host. Empty
+          until there are enough of them to tell.
+        */
+        optional_t<milliseconds_t> percentile(const string_t& host,
+                                              const size_t percent) const;
+
+        /*
+          Every hedgeable request earns a part of a copy, and a copy is
+          sent only when the whole one is earned.
+        */
+        void deposit();
+        bool withdraw();
+
+    private:
+        friend class hedging_impl_t;
+        shared_ptr_t<class hedging_impl_t> pimpl;
+    };
+
+
+} /* namespace crequests */
+
+#endif /* HEDGING_H */
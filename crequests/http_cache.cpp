@@ -0,0 +1,686 @@
+#include "http_cache.h"
+#include "disk_cache.h"
+#include "response.h"
+#include "utils.h"
+
+#include <ctime>
+#include <iomanip>
+#include <list>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace crequests {
+
+
+    namespace {
+
+        using vary_t = vector_t<std::pair<string_t, string_t> >;
+
+        /*
+          Statuses which can be kept without being named by the
+          response (RFC 7231 6.1), but for the ones of methods other
+          than GET.
+        */
+        bool is_cacheable_status(const unsigned int status) {
+            switch (status) {
+            case 200:
+            case 203:
+            case 204:
+            case 300:
+            case 301:
+            case 308:
+            case 404:
+            case 410:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        bool is_safe_method(const string_t& method) {
+            return
+                method == "GET" or
+                method == "HEAD" or
+                method == "OPTIONS" or
+                method == "TRACE";
+        }
+
+        bool parse_http_date(const string_t& value, std::time_t& time) {
+            std::tm tm {};
+            std::istringstream stream(value);
+            stream >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S");
+            if (stream.fail())
+                return false;
+            time = timegm(&tm);
+            return true;
+        }
+
+        /*
+          The names of the request headers the response varies by.
+          Returns false for "Vary: *", which can not be matched.
+        */
+        bool vary_names(const headers_t& fields, vector_t<string_t>& names) {
+            const auto range = fields.equal_range("Vary");
+            for (auto it = range.first; it != range.second; ++it) {
+                for (const auto& item : split(it->second, ',')) {
+                    const auto name = tolower(trim(item));
+                    if (name == "*")
+                        return false;
+                    if (not name.empty())
+                        names.push_back(name);
+                }
+            }
+            return true;
+        }
+
+        /*
+          Cookies of a request are not among its headers until it is
+          written, so they are taken apart.
+        */
+        string_t request_field(const request_t& request, const string_t& name) {
+            if (name == "cookie")
+                return request.cookies().to_string();
+
+            string_t rv;
+            const auto range = request.headers().equal_range(name);
+            for (auto it = range.first; it != range.second; ++it)
+                rv += it->second + ",";
+            return rv;
+        }
+
+        /*
+          Version of the metadata of the responses on the disk.
+        */
+        const string_t META_VERSION = "1";
+
+        shared_body_t make_body(const string_t& body) {
+            const auto owner = std::make_shared<const string_t>(body);
+            return shared_body_t(owner, owner->data(), owner->size());
+        }
+
+    } /* anonymous namespace */
+
+
+    struct http_cache_entry_t {
+        string_t url {};
+        vary_t vary {};
+        unsigned short http_major {1};
+        unsigned short http_minor {1};
+        unsigned int status {0};
+        string_t message {};
+        headers_t headers {};
+        shared_body_t body {};
+        time_point_t stored_at {};
+        std::time_t stored_on {0};
+        seconds_t initial_age {0};
+        seconds_t lifetime {0};
+        bool no_cache {false};
+        size_t size {0};
+    };
+
+
+    /************************************************************
+     * http_cache_impl_t section.
+     ************************************************************/
+
+
+    class http_cache_impl_t {
+    public:
+        http_cache_impl_t() = default;
+
+    public:
+        void set_option(const max_cache_size_t& max_cache_size);
+        bool set_option(const cache_directory_t& cache_directory);
+        void set_option(const max_disk_cache_size_t& max_disk_cache_size);
+        bool enabled() const;
+        http_cache_t::lookup_t lookup(response_t& response,
+                                      shared_body_t& body,
+                                      http_cache_t::stale_t& stale);
+        bool update(response_t& response,
+                    const string_t& body,
+                    const http_cache_t::stale_t& stale,
+                    shared_body_t& cached);
+        disk_cache_t& get_disk_cache();
+        size_t size() const;
+        size_t count() const;
+        void clear();
+
+    private:
+        using entry_t = http_cache_entry_t;
+
+        /*
+          The most recently used responses are at the front of the list.
+        */
+        using entries_t = std::list<entry_t>;
+
+    private:
+        entries_t::iterator find(const request_t& request);
+        entries_t::iterator load(const request_t& request);
+        bool store(const response_t& response, const string_t& body, entry_t& stored);
+        void refresh(entry_t& entry, const time_point_t& now);
+        void fill(response_t& response, shared_body_t& body, const entry_t& entry, const seconds_t& age);
+        void measure(entry_t& entry);
+        string_t dump(const entry_t& entry) const;
+        bool parse(const string_t& meta, entry_t& entry) const;
+        void erase(const entries_t::iterator& it);
+        void erase(const string_t& url);
+        void shrink();
+
+    private:
+        mutable std::mutex mutex {};
+        disk_cache_t disk {};
+        entries_t entries {};
+        std::unordered_multimap<string_t, entries_t::iterator> index {};
+        size_t total {0};
+        size_t max_cache_size {0};
+    };
+
+    void http_cache_impl_t::set_option(const max_cache_size_t& max_cache_size_) {
+        std::lock_guard<std::mutex> lock(mutex);
+        max_cache_size = max_cache_size_.value();
+        shrink();
+    }
+
+    bool http_cache_impl_t::set_option(const cache_directory_t& cache_directory) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return disk.set_option(cache_directory);
+    }
+
+    void http_cache_impl_t::set_option(const max_disk_cache_size_t& max_disk_cache_size) {
+        disk.set_option(max_disk_cache_size);
+    }
+
+    bool http_cache_impl_t::enabled() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return max_cache_size > 0 or disk.enabled();
+    }
+
+    disk_cache_t& http_cache_impl_t::get_disk_cache() {
+        return disk;
+    }
+
+    http_cache_impl_t::entries_t::iterator http_cache_impl_t::find(const request_t& request) {
+        const auto range = index.equal_range(request.uri().url().value());
+        for (auto it = range.first; it != range.second; ++it) {
+            bool matches = true;
+            for (const auto& field : it->second->vary)
+                matches = matches and request_field(request, field.first) == field.second;
+            if (matches)
+                return it->second;
+        }
+        return entries.end();
+    }
+
+    /*
+      The response of the url on the disk, if it is of the variant of
+      the request, is put into memory. It is dropped again by shrink()
+      when it does not fit there.
+    */
+    http_cache_impl_t::entries_t::iterator http_cache_impl_t::load(const request_t& request) {
+        const auto url = request.uri().url().value();
+        string_t meta;
+        entry_t entry;
+        if (not disk.get(url, meta, entry.body))
+            return entries.end();
+
+        if (not parse(meta, entry)) {
+            disk.erase(url);
+            return entries.end();
+        }
+
+        for (const auto& field : entry.vary)
+            if (request_field(request, field.first) != field.second)
+                return entries.end();
+
+        entry.url = url;
+        measure(entry);
+        total += entry.size;
+        entries.push_front(std::move(entry));
+        index.emplace(entries.front().url, entries.begin());
+        return entries.begin();
+    }
+
+    /*
+      Freshness and age of the kept response after its headers (RFC 7234
+      4.2.1 and 4.2.3). Expires is measured from the Date of the response,
+      a malformed one means the response is already stale.
+    */
+    void http_cache_impl_t::refresh(entry_t& entry, const time_point_t& now) {
+        const auto& fields = entry.headers;
+        const auto directives = cache_control(fields);
+        const auto current = std::time(nullptr);
+
+        std::time_t date = current;
+        if (fields.count("Date"))
+            parse_http_date(fields.at("Date"), date);
+
+        seconds_t age {0};
+        if (fields.count("Age"))
+            parse_seconds(fields.at("Age"), age);
+
+        entry.stored_at = now;
+        entry.stored_on = current;
+        entry.initial_age = std::max(age, seconds_t(std::max<std::time_t>(0, current - date)));
+        entry.no_cache = directives.count("no-cache") > 0;
+        entry.lifetime = seconds_t{0};
+
+        std::time_t expires = 0;
+        if (parse_seconds(directives, "s-maxage", entry.lifetime) or
+            parse_seconds(directives, "max-age", entry.lifetime))
+            return;
+        if (fields.count("Expires") and parse_http_date(fields.at("Expires"), expires))
+            entry.lifetime = seconds_t(std::max<std::time_t>(0, expires - date));
+    }
+
+    void http_cache_impl_t::fill(response_t& response,
+                                 shared_body_t& body,
+                                 const entry_t& entry,
+                                 const seconds_t& age) {
+        auto fields = entry.headers;
+        fields.insert("Age", std::to_string(age.count()));
+
+        response.http_major(http_major_t{entry.http_major});
+        response.http_minor(http_minor_t{entry.http_minor});
+        response.status_code(status_code_t{entry.status});
+        response.status_message(status_message_t{entry.message});
+        response.headers(std::move(fields));
+        response.from_cache(from_cache_t{true});
+        body = entry.body;
+    }
+
+    void http_cache_impl_t::measure(entry_t& entry) {
+        entry.size = entry.url.size() + entry.message.size() + entry.body.size();
+        for (const auto& field : entry.vary)
+            entry.size += field.first.size() + field.second.size();
+        for (const auto& field : entry.headers)
+            entry.size += field.first.size() + field.second.size();
+    }
+
+    /*
+      The metadata on the disk is a line per value: the version, the
+      status line, the freshness, then the counted vary pairs and
+      headers, a line for a name and a line for a value. Header values
+      do not have line breaks.
+    */
+    string_t http_cache_impl_t::dump(const entry_t& entry) const {
+        std::ostringstream stream;
+        stream
+            << META_VERSION << '\n'
+            << entry.status << '\n'
+            << entry.http_major << '\n'
+            << entry.http_minor << '\n'
+            << entry.message << '\n'
+            << entry.stored_on << '\n'
+            << entry.initial_age.count() << '\n'
+            << entry.lifetime.count() << '\n'
+            << entry.no_cache << '\n'
+            << entry.vary.size() << '\n';
+        for (const auto& field : entry.vary)
+            stream << field.first << '\n' << field.second << '\n';
+        stream << entry.headers.size() << '\n';
+        for (const auto& field : entry.headers)
+            stream << field.first << '\n' << field.second << '\n';
+        return stream.str();
+    }
+
+    bool http_cache_impl_t::parse(const string_t& meta, entry_t& entry) const {
+        std::istringstream stream(meta);
+        string_t version;
+        std::getline(stream, version);
+        if (version != META_VERSION)
+            return false;
+
+        long long initial_age = 0, lifetime = 0;
+        size_t count = 0;
+        stream >> entry.status >> entry.http_major >> entry.http_minor;
+        stream.ignore();
+        std::getline(stream, entry.message);
+        stream >> entry.stored_on >> initial_age >> lifetime >> entry.no_cache >> count;
+        stream.ignore();
+
+        string_t name, value;
+        for (size_t i = 0; i < count and std::getline(stream, name) and std::getline(stream, value); ++i)
+            entry.vary.emplace_back(name, value);
+
+        stream >> count;
+        stream.ignore();
+        for (size_t i = 0; i < count and std::getline(stream, name) and std::getline(stream, value); ++i)
+            entry.headers.insert(name, value);
+        if (stream.fail())
+            return false;
+
+        /*
+          The age of the response goes on with the wall clock while it
+          is on the disk.
+        */
+        const auto now = steady_clock_t::now();
+        const auto gone = std::max<std::time_t>(0, std::time(nullptr) - entry.stored_on);
+        entry.stored_at = now - seconds_t(gone);
+        entry.initial_age = seconds_t(initial_age);
+        entry.lifetime = seconds_t(lifetime);
+        return true;
+    }
+
+    void http_cache_impl_t::erase(const entries_t::iterator& it) {
+        const auto range = index.equal_range(it->url);
+        for (auto pos = range.first; pos != range.second; ++pos) {
+            if (pos->second == it) {
+                index.erase(pos);
+                break;
+            }
+        }
+        total -= it->size;
+        entries.erase(it);
+    }
+
+    void http_cache_impl_t::erase(const string_t& url) {
+        const auto range = index.equal_range(url);
+        for (auto it = range.first; it != range.second; ++it) {
+            total -= it->second->size;
+            entries.erase(it->second);
+        }
+        index.erase(range.first, range.second);
+    }
+
+    void http_cache_impl_t::shrink() {
+        while (total > max_cache_size)
+            erase(std::prev(entries.end()));
+    }
+
+    http_cache_t::lookup_t http_cache_impl_t::lookup(response_t& response,
+                                                     shared_body_t& body,
+                                                     http_cache_t::stale_t& stale) {
+        auto& request = response.request();
+        const auto& fields = request.headers();
+
+        /*
+          A request which is conditional or partial by itself is the
+          business of the application.
+        */
+        std::lock_guard<std::mutex> lock(mutex);
+        if ((max_cache_size == 0 and not disk.enabled()) or
+            toupper(request.method().value()) != "GET" or
+            fields.count("If-None-Match") or
+            fields.count("If-Modified-Since") or
+            fields.count("Range"))
+            return http_cache_t::lookup_t::MISS;
+
+        const auto directives = cache_control(fields);
+        if (directives.count("no-store"))
+            return http_cache_t::lookup_t::MISS;
+
+        auto it = find(request);
+        if (it == entries.end())
+            it = load(request);
+        if (it == entries.end())
+            return http_cache_t::lookup_t::MISS;
+
+        const auto now = steady_clock_t::now();
+        const auto age =
+            it->initial_age + std::chrono::duration_cast<seconds_t>(now - it->stored_at);
+
+        bool fresh = not it->no_cache and age < it->lifetime;
+        if (directives.count("no-cache") or fields.contains("Pragma", "no-cache"))
+            fresh = false;
+
+        seconds_t max_age {0};
+        if (parse_seconds(directives, "max-age", max_age) and age > max_age)
+            fresh = false;
+
+        if (fresh) {
+            entries.splice(entries.begin(), entries, it);
+            fill(response, body, *it, age);
+            shrink();
+            return http_cache_t::lookup_t::FRESH;
+        }
+
+        const auto& kept = it->headers;
+        if (not kept.count("ETag") and not kept.count("Last-Modified")) {
+            disk.erase(it->url);
+            erase(it);
+            return http_cache_t::lookup_t::MISS;
+        }
+
+        auto conditional = fields;
+        if (kept.count("ETag"))
+            conditional.insert("If-None-Match", kept.at("ETag"));
+        if (kept.count("Last-Modified"))
+            conditional.insert("If-Modified-Since", kept.at("Last-Modified"));
+        request.headers(std::move(conditional));
+        stale = std::make_shared<const entry_t>(*it);
+        shrink();
+        return http_cache_t::lookup_t::STALE;
+    }
+
+    /*
+      The responses are written to the disk after the lock is released,
+      since the write waits for the disk.
+    */
+    bool http_cache_impl_t::update(response_t& response,
+                                   const string_t& body,
+                                   const http_cache_t::stale_t& stale,
+                                   shared_body_t& cached) {
+        const auto& request = response.request();
+        const auto method = toupper(request.method().value());
+        const auto status = response.status_code().value();
+        const auto url = request.uri().url().value();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (max_cache_size == 0 and not disk.enabled())
+            return false;
+
+        if (not is_safe_method(method)) {
+            if (status < 400) {
+                erase(url);
+                lock.unlock();
+                disk.erase(url);
+            }
+            return false;
+        }
+
+        if (method != "GET")
+            return false;
+
+        entry_t stored;
+        if (status != 304) {
+            if (store(response, body, stored)) {
+                const auto meta = dump(stored);
+                lock.unlock();
+                disk.put(url, meta, stored.body.data(), stored.body.size());
+            }
+            return false;
+        }
+
+        if (not stale)
+            return false;
+
+        /*
+          The kept response may be dropped while it is revalidated, then
+          the copy taken by the lookup comes back.
+        */
+        auto it = find(request);
+        if (it == entries.end())
+            it = load(request);
+        if (it == entries.end()) {
+            total += stale->size;
+            entries.push_front(*stale);
+            index.emplace(entries.front().url, entries.begin());
+            it = entries.begin();
+        }
+
+        /*
+          The headers of the 304 replace the kept ones (RFC 7234 4.3.4),
+          but for the length of the body which is not sent.
+        */
+        for (const auto& field : response.headers()) {
+            if (iequals{}(field.first, "Content-Length"))
+                continue;
+            it->headers.erase(field.first);
+        }
+        for (const auto& field : response.headers()) {
+            if (iequals{}(field.first, "Content-Length"))
+                continue;
+            it->headers.emplace(field.first, field.second);
+        }
+
+        total -= it->size;
+        measure(*it);
+        total += it->size;
+        refresh(*it, steady_clock_t::now());
+        entries.splice(entries.begin(), entries, it);
+        fill(response, cached, *it, it->initial_age);
+
+        const auto meta = dump(*it);
+        shrink();
+        lock.unlock();
+        disk.put(url, meta, cached.data(), cached.size());
+        return true;
+    }
+
+    /*
+      Keeps the response in memory if it fits there. Returns true with
+      the entry when it can be kept at all, so it goes to the disk too.
+      A body which went to the body callback of the request is not at
+      hand to be kept.
+    */
+    bool http_cache_impl_t::store(const response_t& response, const string_t& body, entry_t& stored) {
+        const auto& request = response.request();
+        const auto& fields = response.headers();
+        const auto status = response.status_code().value();
+        if (request.body_callback() or not is_cacheable_status(status))
+            return false;
+
+        const auto directives = cache_control(fields);
+        const auto request_directives = cache_control(request.headers());
+        if (request_directives.count("no-store") or
+            directives.count("no-store") or
+            directives.count("private") or
+            fields.count("Set-Cookie"))
+            return false;
+
+        if (request.headers().count("Authorization") and
+            not directives.count("public") and
+            not directives.count("s-maxage") and
+            not directives.count("must-revalidate"))
+            return false;
+
+        vector_t<string_t> names;
+        if (not vary_names(fields, names))
+            return false;
+
+        entry_t entry;
+        entry.url = request.uri().url().value();
+        entry.http_major = response.http_major().value();
+        entry.http_minor = response.http_minor().value();
+        entry.status = status;
+        entry.message = response.status_message().value();
+        entry.headers = fields;
+        entry.body = make_body(body);
+        refresh(entry, steady_clock_t::now());
+
+        const bool has_validators = fields.count("ETag") or fields.count("Last-Modified");
+        if ((entry.no_cache or entry.lifetime.count() == 0) and not has_validators)
+            return false;
+
+        for (const auto& name : names)
+            entry.vary.emplace_back(name, request_field(request, name));
+        measure(entry);
+
+        const auto it = find(request);
+        if (it != entries.end())
+            erase(it);
+
+        stored = entry;
+        if (entry.size > max_cache_size)
+            return true;
+
+        total += entry.size;
+        entries.push_front(std::move(entry));
+        index.emplace(entries.front().url, entries.begin());
+        shrink();
+        return true;
+    }
+
+    size_t http_cache_impl_t::size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return total;
+    }
+
+    size_t http_cache_impl_t::count() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+    void http_cache_impl_t::clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        index.clear();
+        entries.clear();
+        total = 0;
+        disk.clear();
+    }
+
+
+    /************************************************************
+     * http_cache_t section.
+     ************************************************************/
+
+
+    http_cache_t::http_cache_t()
+        : pimpl{std::make_shared<http_cache_impl_t>()}
+    {
+
+    }
+
+    http_cache_t::~http_cache_t() {
+
+    }
+
+    void http_cache_t::set_option(const max_cache_size_t& max_cache_size) {
+        pimpl->set_option(max_cache_size);
+    }
+
+    bool http_cache_t::set_option(const cache_directory_t& cache_directory) {
+        return pimpl->set_option(cache_directory);
+    }
+
+    void http_cache_t::set_option(const max_disk_cache_size_t& max_disk_cache_size) {
+        pimpl->set_option(max_disk_cache_size);
+    }
+
+    bool http_cache_t::enabled() const {
+        return pimpl->enabled();
+    }
+
+    http_cache_t::lookup_t http_cache_t::lookup(response_t& response,
+                                                shared_body_t& body,
+                                                stale_t& stale) {
+        return pimpl->lookup(response, body, stale);
+    }
+
+    bool http_cache_t::update(response_t& response,
+                              const string_t& body,
+                              const stale_t& stale,
+                              shared_body_t& cached) {
+        return pimpl->update(response, body, stale, cached);
+    }
+
+    disk_cache_t& http_cache_t::get_disk_cache() {
+        return pimpl->get_disk_cache();
+    }
+
+    size_t http_cache_t::size() const {
+        return pimpl->size();
+    }
+
+    size_t http_cache_t::count() const {
+        return pimpl->count();
+    }
+
+    void http_cache_t::clear() {
+        pimpl->clear();
+    }
+
+
+} /* namespace crequests */
@@ -0,0 +1,102 @@
+#ifndef HTTP_CACHE_H
+#define HTTP_CACHE_H
+
+#include "disk_cache.h"
+#include "macros.h"
+#include "types.h"
+
+namespace crequests {
+
+
+    /*
+      Service option of the http cache: how many bytes of responses
+      (bodies, headers and urls) are kept. 0 (the default) turns the
+      cache off.
+    */
+    declare_number(max_cache_size, size_t)
+
+
+    struct http_cache_entry_t;
+
+
+    /*
+      Cache of the responses to GET requests after RFC 7234. It is
+      shared by all requests of a service, so it follows the rules of
+      a shared cache: private responses, responses which set cookies
+      and responses to requests with credentials (unless the response
+      allows it) are not kept. Freshness comes from s-maxage, max-age
+      or Expires. A stale response with an ETag or a Last-Modified is
+      revalidated by a conditional request, and a 304 refreshes it. The
+      variants of a url are told apart by the request headers named in
+      Vary. The least recently used responses are dropped when the
+      cache is full. With a cache directory the responses are written
+      through to the disk as well (see disk_cache.h), one variant of a
+      url there, and are read back into memory when they are looked up.
+      Can be used from any thread.
+    */
+    class http_cache_t {
+    public:
+        enum class lookup_t {
+            MISS,
+            FRESH,
+            STALE
+        };
+
+        /*
+          A copy of the stale response a revalidation is sent for, so
+          the 304 is answered from it even when the cache drops the
+          response meanwhile.
+        */
+        using stale_t = shared_ptr_t<const http_cache_entry_t>;
+
+    public:
+        http_cache_t();
+        http_cache_t(const http_cache_t& http_cache) = delete;
+        http_cache_t& operator=(const http_cache_t& http_cache) = delete;
+        ~http_cache_t();
+
+    public:
+        void set_option(const max_cache_size_t& max_cache_size);
+        bool set_option(const cache_directory_t& cache_directory);
+        void set_option(const max_disk_cache_size_t& max_disk_cache_size);
+        bool enabled() const;
+
+        /*
+          Looks up the response to the request of the given one. A fresh
+          response is copied into it, but for the body which is shared
+          through the given object. For a stale one the validators are
+          added to the request, so it can be sent to revalidate the
+          response, and the response is kept in stale.
+        */
+        lookup_t lookup(response_t& response, shared_body_t& body, stale_t& stale);
+
+        /*
+          Takes the response which came from the network. A 304 to a
+          revalidation (stale is the one given by the lookup) is replaced
+          by the kept response (returns true then, with its body in
+          cached), other responses are kept if they can be. A successful
+          unsafe request drops the responses of its url.
+        */
+        bool update(response_t& response,
+                    const string_t& body,
+                    const stale_t& stale,
+                    shared_body_t& cached);
+
+        disk_cache_t& get_disk_cache();
+
+        /*
+          Bytes and responses kept.
+        */
+        size_t size() const;
+        size_t count() const;
+        void clear();
+
+    private:
+        friend class http_cache_impl_t;
+        shared_ptr_t<class http_cache_impl_t> pimpl;
+    };
+
+
+} /* namespace crequests */
+
+#endif /* HTTP_CACHE_H */
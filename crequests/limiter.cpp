@@ -0,0 +1,475 @@
+#include "limiter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <list>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+namespace crequests {
+
+
+    namespace {
+
+        /*
+          Adaptive limits of idle hosts which are kept for their next
+          requests. The least recently used ones are forgotten first.
+        */
+        const size_t MAX_IDLE_HOSTS = 1024;
+
+    } /* anonymous namespace */
+
+
+    /************************************************************
+     * limiter_impl_t section.
+     ************************************************************/
+
+
+    class limiter_impl_t : public std::enable_shared_from_this<limiter_impl_t> {
+    public:
+        explicit limiter_impl_t(timer_wheel_t& wheel);
+
+    public:
+        void max_connections(const size_t value);
+        void max_host_connections(const size_t value);
+        void max_queue_size(const size_t value);
+        void max_queue_time(const size_t value);
+        void adaptive_concurrency(const bool value);
+        bool enabled() const;
+        limiter_t::admission_t acquire(const string_t& host,
+                                       const int priority,
+                                       const time_point_t& deadline,
+                                       limiter_t::callback_t&& callback,
+                                       limiter_t::ticket_t& ticket);
+        bool cancel(const limiter_t::ticket_t ticket);
+        void release(const string_t& host);
+        void sample(const string_t& host,
+                    const milliseconds_t& latency,
+                    const bool dropped);
+        size_t host_limit(const string_t& host) const;
+        std::map<string_t, size_t> host_limits() const;
+        size_t active() const;
+        size_t queued() const;
+
+    private:
+        using idle_hosts_t = std::list<string_t>;
+
+        struct host_t {
+            size_t active {0};
+            adaptive_limit_t adaptive {};
+            bool idle {false};
+            idle_hosts_t::iterator idle_it {};
+        };
+
+        struct waiter_t {
+            string_t host {};
+            limiter_t::callback_t callback {};
+            timer_id_t timer {0};
+        };
+
+        struct key_t {
+            key_t(const int priority_,
+                  const time_point_t& deadline_,
+                  const limiter_t::ticket_t ticket_)
+                : priority(priority_), deadline(deadline_), ticket(ticket_)
+            {}
+
+            int priority;
+            time_point_t deadline;
+            limiter_t::ticket_t ticket;
+
+            bool operator<(const key_t& rhs) const {
+                if (priority != rhs.priority)
+                    return priority > rhs.priority;
+                if (deadline != rhs.deadline)
+                    return deadline < rhs.deadline;
+                return ticket < rhs.ticket;
+            }
+        };
+
+        using granted_t = vector_t<limiter_t::callback_t>;
+
+    private:
+        size_t limit_of(const host_t& host) const;
+        bool has_slot(const string_t& host) const;
+        void take_slot(const string_t& host);
+        void grant(granted_t& granted);
+        bool remove(const limiter_t::ticket_t ticket, waiter_t& waiter);
+        void expire(const limiter_t::ticket_t ticket);
+        void update_enabled();
+        void forget_idle();
+
+    private:
+        mutable std::mutex mutex {};
+        timer_wheel_t& wheel;
+        std::atomic<bool> m_enabled {false};
+        size_t m_max_connections {0};
+        size_t m_max_host_connections {0};
+        size_t m_max_queue_size {std::numeric_limits<size_t>::max()};
+        size_t m_max_queue_time {0};
+        bool m_adaptive {false};
+        size_t m_active {0};
+        std::unordered_map<string_t, host_t> hosts {};
+        idle_hosts_t idle_hosts {};
+        std::map<key_t, waiter_t> waiters {};
+        std::unordered_map<limiter_t::ticket_t, key_t> tickets {};
+        limiter_t::ticket_t last_ticket {0};
+    };
+
+    limiter_impl_t::limiter_impl_t(timer_wheel_t& wheel_)
+        : wheel(wheel_)
+    {
+
+    }
+
+    void limiter_impl_t::max_connections(const size_t value) {
+        granted_t granted;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            m_max_connections = value;
+            update_enabled();
+            grant(granted);
+        }
+
+        for (const auto& callback : granted)
+            callback(true);
+    }
+
+    void limiter_impl_t::max_host_connections(const size_t value) {
+        granted_t granted;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            m_max_host_connections = value;
+            update_enabled();
+            grant(granted);
+        }
+
+        for (const auto& callback : granted)
+            callback(true);
+    }
+
+    void limiter_impl_t::max_queue_size(const size_t value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        m_max_queue_size = value;
+    }
+
+    void limiter_impl_t::max_queue_time(const size_t value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        m_max_queue_time = value;
+    }
+
+    void limiter_impl_t::adaptive_concurrency(const bool value) {
+        granted_t granted;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            m_adaptive = value;
+            if (not m_adaptive)
+                forget_idle();
+            update_enabled();
+            grant(granted);
+        }
+
+        for (const auto& callback : granted)
+            callback(true);
+    }
+
+    void limiter_impl_t::update_enabled() {
+        m_enabled = m_max_connections > 0 or m_max_host_connections > 0 or m_adaptive;
+    }
+
+    bool limiter_impl_t::enabled() const {
+        return m_enabled;
+    }
+
+    bool limiter_impl_t::has_slot(const string_t& host) const {
+        if (m_max_connections > 0 and m_active >= m_max_connections)
+            return false;
+
+        const auto it = hosts.find(host);
+        if (it == hosts.end())
+            return true;
+
+        const auto limit = limit_of(it->second);
+        return limit == 0 or it->second.active < limit;
+    }
+
+    size_t limiter_impl_t::limit_of(const host_t& host) const {
+        if (not m_adaptive)
+            return m_max_host_connections;
+
+        return m_max_host_connections > 0
+            ? std::min(host.adaptive.limit(), m_max_host_connections)
+            : host.adaptive.limit();
+    }
+
+    void limiter_impl_t::take_slot(const string_t& host) {
+        m_active++;
+        auto& state = hosts[host];
+        if (state.idle) {
+            idle_hosts.erase(state.idle_it);
+            state.idle = false;
+        }
+        state.active++;
+    }
+
+    void limiter_impl_t::forget_idle() {
+        for (const auto& host : idle_hosts)
+            hosts.erase(host);
+        idle_hosts.clear();
+    }
+
+    limiter_t::admission_t limiter_impl_t::acquire(const string_t& host,
+                                                   const int priority,
+                                                   const time_point_t& deadline,
+                                                   limiter_t::callback_t&& callback,
+                                                   limiter_t::ticket_t& ticket) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        /*
+          Every waiter which fits into the limits is granted at once, so
+          the ones left wait for other hosts and a free slot of this host
+          does not let the new request jump over anybody.
+        */
+        if (has_slot(host)) {
+            take_slot(host);
+            return limiter_t::admission_t::GRANTED;
+        }
+
+        if (waiters.size() >= m_max_queue_size)
+            return limiter_t::admission_t::REJECTED;
+
+        ticket = ++last_ticket;
+        const key_t key {priority, deadline, ticket};
+        tickets.emplace(ticket, key);
+        auto& waiter = waiters[key];
+        waiter.host = host;
+        waiter.callback = std::move(callback);
+
+        if (m_max_queue_time > 0) {
+            const std::weak_ptr<limiter_impl_t> weak = shared_from_this();
+            const auto id = ticket;
+            waiter.timer = wheel.schedule(
+                milliseconds_t(m_max_queue_time), [weak, id]() {
+                    if (const auto self = weak.lock())
+                        self->expire(id);
+                });
+        }
+
+        return limiter_t::admission_t::QUEUED;
+    }
+
+    bool limiter_impl_t::remove(const limiter_t::ticket_t ticket, waiter_t& waiter) {
+        const auto it = tickets.find(ticket);
+        if (it == tickets.end())
+            return false;
+
+        const auto waiter_it = waiters.find(it->second);
+        waiter = std::move(waiter_it->second);
+        waiters.erase(waiter_it);
+        tickets.erase(it);
+        return true;
+    }
+
+    bool limiter_impl_t::cancel(const limiter_t::ticket_t ticket) {
+        waiter_t waiter;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (not remove(ticket, waiter))
+                return false;
+        }
+
+        wheel.cancel(waiter.timer);
+        return true;
+    }
+
+    void limiter_impl_t::expire(const limiter_t::ticket_t ticket) {
+        waiter_t waiter;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (not remove(ticket, waiter))
+                return;
+        }
+
+        waiter.callback(false);
+    }
+
+    void limiter_impl_t::release(const string_t& host) {
+        granted_t granted;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (m_active > 0)
+                m_active--;
+
+            /*
+              Adaptive limits which moved away from the initial one are
+              kept for the next requests to the host, up to MAX_IDLE_HOSTS.
+            */
+            const auto it = hosts.find(host);
+            if (it != hosts.end() and it->second.active > 0 and --it->second.active == 0) {
+                if (not m_adaptive or it->second.adaptive.limit() == adaptive_limit_t{}.limit()) {
+                    hosts.erase(it);
+                }
+                else {
+                    it->second.idle = true;
+                    it->second.idle_it = idle_hosts.insert(idle_hosts.end(), host);
+                    if (idle_hosts.size() > MAX_IDLE_HOSTS) {
+                        hosts.erase(idle_hosts.front());
+                        idle_hosts.pop_front();
+                    }
+                }
+            }
+
+            grant(granted);
+        }
+
+        for (const auto& callback : granted)
+            callback(true);
+    }
+
+    void limiter_impl_t::sample(const string_t& host,
+                                const milliseconds_t& latency,
+                                const bool dropped) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (not m_adaptive)
+            return;
+
+        const auto it = hosts.find(host);
+        if (it == hosts.end())
+            return;
+
+        auto& state = it->second;
+        state.adaptive.sample(latency, state.active, dropped, m_max_host_connections);
+    }
+
+    size_t limiter_impl_t::host_limit(const string_t& host) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = hosts.find(host);
+        if (it != hosts.end())
+            return limit_of(it->second);
+
+        return limit_of(host_t{});
+    }
+
+    std::map<string_t, size_t> limiter_impl_t::host_limits() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::map<string_t, size_t> limits;
+        for (const auto& host : hosts)
+            limits.emplace(host.first, limit_of(host.second));
+        return limits;
+    }
+
+    /*
+      Waiters are served in the order of the queue. A waiter of a host
+      which is at its own limit does not hold back the others.
+    */
+    void limiter_impl_t::grant(granted_t& granted) {
+        auto it = waiters.begin();
+        while (it != waiters.end()) {
+            if (m_max_connections > 0 and m_active >= m_max_connections)
+                return;
+
+            if (not has_slot(it->second.host)) {
+                ++it;
+                continue;
+            }
+
+            take_slot(it->second.host);
+            wheel.cancel(it->second.timer);
+            granted.push_back(std::move(it->second.callback));
+            tickets.erase(it->first.ticket);
+            it = waiters.erase(it);
+        }
+    }
+
+    size_t limiter_impl_t::active() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return m_active;
+    }
+
+    size_t limiter_impl_t::queued() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return waiters.size();
+    }
+
+
+    /************************************************************
+     * limiter_t section.
+     ************************************************************/
+
+
+    limiter_t::limiter_t(timer_wheel_t& wheel)
+        : pimpl{std::make_shared<limiter_impl_t>(wheel)}
+    {
+
+    }
+
+    limiter_t::~limiter_t() {
+
+    }
+
+    void limiter_t::set_option(const max_connections_t& max_connections) {
+        pimpl->max_connections(max_connections.value());
+    }
+
+    void limiter_t::set_option(const max_host_connections_t& max_host_connections) {
+        pimpl->max_host_connections(max_host_connections.value());
+    }
+
+    void limiter_t::set_option(const max_queue_size_t& max_queue_size) {
+        pimpl->max_queue_size(max_queue_size.value());
+    }
+
+    void limiter_t::set_option(const max_queue_time_t& max_queue_time) {
+        pimpl->max_queue_time(max_queue_time.value());
+    }
+
+    void limiter_t::set_option(const adaptive_concurrency_t& adaptive_concurrency) {
+        pimpl->adaptive_concurrency(adaptive_concurrency.value());
+    }
+
+    bool limiter_t::enabled() const {
+        return pimpl->enabled();
+    }
+
+    limiter_t::admission_t limiter_t::acquire(const string_t& host,
+                                              const int priority,
+                                              const time_point_t& deadline,
+                                              callback_t&& callback,
+                                              ticket_t& ticket) {
+        return pimpl->acquire(host, priority, deadline, std::move(callback), ticket);
+    }
+
+    void limiter_t::sample(const string_t& host,
+                           const milliseconds_t& latency,
+                           const bool dropped) {
+        pimpl->sample(host, latency, dropped);
+    }
+
+    size_t limiter_t::host_limit(const string_t& host) const {
+        return pimpl->host_limit(host);
+    }
+
+    std::map<string_t, size_t> limiter_t::host_limits() const {
+        return pimpl->host_limits();
+    }
+
+    bool limiter_t::cancel(const ticket_t ticket) {
+        return pimpl->cancel(ticket);
+    }
+
+    void limiter_t::release(const string_t& host) {
+        pimpl->release(host);
+    }
+
+    size_t limiter_t::active() const {
+        return pimpl->active();
+    }
+
+    size_t limiter_t::queued() const {
+        return pimpl->queued();
+    }
+
+
+} /* namespace crequests */
@@ -0,0 +1,124 @@
+#ifndef LIMITER_H
+#define LIMITER_H
+
+#include "adaptive_limit.h"
+#include "macros.h"
+#include "timer_wheel.h"
+#include "types.h"
+
+#include <cstdint>
+#include <functional>
+#include <map>
+
+namespace crequests {
+
+
+    /*
+      Service options of the concurrency limiter. Connection limits of 0
+      mean no limit (the default). The queue size is unlimited by default
+      and 0 means requests are rejected at once when no slot is free.
+      The queue time is in milliseconds, 0 means no limit.
+    */
+    declare_number(max_connections, size_t)
+    declare_number(max_host_connections, size_t)
+    declare_number(max_queue_size, size_t)
+    declare_number(max_queue_time, size_t)
+
+
+    /*
+      With adaptive concurrency the limit of every host follows its
+      latency and errors (see adaptive_limit.h). max_host_connections
+      bounds it from above then.
+    */
+    declare_bool(adaptive_concurrency)
+
+
+    /*
+      Bounds the number of connections running at once in the whole
+      service and per host. Requests over the limits wait in a queue
+      until a slot is released, or are rejected when the queue is full or
+      they waited too long. The queue is ordered by priority, then by the
+      earliest deadline and then by arrival. Can be used from any thread.
+    */
+    class limiter_t {
+    public:
+        enum class admission_t {
+            GRANTED,
+            QUEUED,
+            REJECTED
+        };
+
+        using ticket_t = std::uint64_t;
+
+        /*
+          Called once for a queued request: with true when it gets a slot
+          and with false when it waited longer than the queue time.
+        */
+        using callback_t = std::function<void(bool granted)>;
+
+    public:
+        explicit limiter_t(timer_wheel_t& wheel);
+        limiter_t(const limiter_t& limiter) = delete;
+        limiter_t& operator=(const limiter_t& limiter) = delete;
+        ~limiter_t();
+
+    public:
+        void set_option(const max_connections_t& max_connections);
+        void set_option(const max_host_connections_t& max_host_connections);
+        void set_option(const max_queue_size_t& max_queue_size);
+        void set_option(const max_queue_time_t& max_queue_time);
+        void set_option(const adaptive_concurrency_t& adaptive_concurrency);
+
+        /*
+          Returns false when no limit is set, so there is nothing to acquire.
+        */
+        bool enabled() const;
+
+        /*
+          Takes a slot for the host. When there is no free one the request
+          is queued (and the ticket is set) or rejected.
+        */
+        admission_t acquire(const string_t& host,
+                            const int priority,
+                            const time_point_t& deadline,
+                            callback_t&& callback,
+                            ticket_t& ticket);
+
+        /*
+          Removes a queued request. Returns false if it has already got
+          a slot or was rejected (its callback is called or is being called).
+        */
+        bool cancel(const ticket_t ticket);
+
+        /*
+          Returns the slot of the host and grants it to the next request.
+        */
+        void release(const string_t& host);
+
+        /*
+          Feeds the adaptive limit of the host with a request which holds
+          a slot and is done. Must be called before the slot is released.
+        */
+        void sample(const string_t& host,
+                    const milliseconds_t& latency,
+                    const bool dropped);
+
+        /*
+          The current connection limit of the host (0 means no limit)
+          and the limits of all hosts which are known to the limiter.
+        */
+        size_t host_limit(const string_t& host) const;
+        std::map<string_t, size_t> host_limits() const;
+
+        size_t active() const;
+        size_t queued() const;
+
+    private:
+        friend class limiter_impl_t;
+        shared_ptr_t<class limiter_impl_t> pimpl;
+    };
+
+
+} /* namespace crequests */
+
+#endif /* LIMITER_H */
@@ -0,0 +1,283 @@
+#include "pool.h"
+#include "request.h"
+#include "stream.h"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+namespace crequests {
+
+
+    namespace {
+
+        const size_t DEFAULT_MAX_IDLE_CONNECTIONS = 8;
+        const size_t DEFAULT_MAX_IDLE_TIME = 30000;
+
+    } /* anonymous namespace */
+
+
+    /************************************************************
+     * pool_impl_t section.
+     ************************************************************/
+
+
+    class pool_impl_t : public std::enable_shared_from_this<pool_impl_t> {
+    public:
+        explicit pool_impl_t(timer_wheel_t& wheel);
+
+    public:
+        void set_option(const max_idle_connections_t& max_idle_connections);
+        void set_option(const max_idle_time_t& max_idle_time);
+        bool put(const string_t& key, stream_t&& stream);
+        bool take(const string_t& key, stream_t& stream);
+        size_t size(const string_t& key) const;
+        size_t size() const;
+        void clear();
+
+    private:
+        struct entry_t {
+            entry_t(stream_t&& stream_, const time_point_t& parked_at_)
+                : stream(std::move(stream_)),
+                  parked_at(parked_at_)
+            {}
+
+            stream_t stream;
+            time_point_t parked_at;
+        };
+
+        using entries_t = std::deque<std::unique_ptr<entry_t> >;
+
+    private:
+        void expire(entries_t& entries, const time_point_t& now);
+        void schedule_sweep();
+        void sweep();
+
+    private:
+        mutable std::mutex mutex {};
+        timer_wheel_t& wheel;
+        timer_id_t sweep_timer {0};
+        std::map<string_t, entries_t> origins {};
+        size_t max_idle_connections {DEFAULT_MAX_IDLE_CONNECTIONS};
+        milliseconds_t max_idle_time {DEFAULT_MAX_IDLE_TIME};
+    };
+
+    pool_impl_t::pool_impl_t(timer_wheel_t& wheel_)
+        : wheel(wheel_)
+    {
+
+    }
+
+    void pool_impl_t::set_option(const max_idle_connections_t& max_idle_connections_) {
+        std::lock_guard<std::mutex> lock(mutex);
+        max_idle_connections = max_idle_connections_.value();
+        for (auto& origin : origins)
+            while (origin.second.size() > max_idle_connections)
+                origin.second.pop_front();
+    }
+
+    void pool_impl_t::set_option(const max_idle_time_t& max_idle_time_) {
+        std::lock_guard<std::mutex> lock(mutex);
+        max_idle_time = milliseconds_t(max_idle_time_.value());
+        wheel.cancel(sweep_timer);
+        sweep_timer = 0;
+        schedule_sweep();
+    }
+
+    /*
+      The oldest connections are at the front, so the expired ones
+      are dropped from there.
+    */
+    void pool_impl_t::expire(entries_t& entries, const time_point_t& now) {
+        while (not entries.empty() and entries.front()->parked_at + max_idle_time <= now)
+            entries.pop_front();
+    }
+
+    /*
+      A single timer is armed for the oldest parked connection. The
+      sweep drops every expired one and arms the timer for the next.
+    */
+    void pool_impl_t::schedule_sweep() {
+        if (sweep_timer != 0)
+            return;
+
+        bool found = false;
+        time_point_t oldest = time_point_t::max();
+        for (const auto& origin : origins) {
+            if (not origin.second.empty()) {
+                oldest = std::min(oldest, origin.second.front()->parked_at);
+                found = true;
+            }
+        }
+        if (not found)
+            return;
+
+        const std::weak_ptr<pool_impl_t> weak = shared_from_this();
+        sweep_timer = wheel.schedule(oldest + max_idle_time, [weak]() {
+            if (const auto self = weak.lock())
+                self->sweep();
+        });
+    }
+
+    void pool_impl_t::sweep() {
+        std::lock_guard<std::mutex> lock(mutex);
+        sweep_timer = 0;
+
+        const auto now = steady_clock_t::now();
+        auto it = origins.begin();
+        while (it != origins.end()) {
+            expire(it->second, now);
+            if (it->second.empty())
+                it = origins.erase(it);
+            else
+                ++it;
+        }
+
+        schedule_sweep();
+    }
+
+    bool pool_impl_t::put(const string_t& key, stream_t&& stream) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto now = steady_clock_t::now();
+        auto& entries = origins[key];
+        expire(entries, now);
+
+        if (entries.size() >= max_idle_connections) {
+            stream.cancel();
+            stream.close();
+            return false;
+        }
+
+        entries.emplace_back(new entry_t(std::move(stream), now));
+        schedule_sweep();
+        return true;
+    }
+
+    /*
+      The most recently parked connection is the most likely one to
+      be still alive, so it is handed out first.
+    */
+    bool pool_impl_t::take(const string_t& key, stream_t& stream) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = origins.find(key);
+        if (it == origins.end())
+            return false;
+
+        auto& entries = it->second;
+        expire(entries, steady_clock_t::now());
+
+        bool found = false;
+        while (not found and not entries.empty()) {
+            auto entry = std::move(entries.back());
+            entries.pop_back();
+            if (entry->stream.is_alive()) {
+                stream = std::move(entry->stream);
+                found = true;
+            }
+        }
+
+        if (entries.empty())
+            origins.erase(it);
+
+        return found;
+    }
+
+    size_t pool_impl_t::size(const string_t& key) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = origins.find(key);
+        return it == origins.end() ? 0 : it->second.size();
+    }
+
+    size_t pool_impl_t::size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t rv = 0;
+        for (const auto& origin : origins)
+            rv += origin.second.size();
+        return rv;
+    }
+
+    void pool_impl_t::clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        wheel.cancel(sweep_timer);
+        sweep_timer = 0;
+        origins.clear();
+    }
+
+
+    /************************************************************
+     * pool_t section.
+     ************************************************************/
+
+
+    pool_t::pool_t(timer_wheel_t& wheel)
+        : pimpl{std::make_shared<pool_impl_t>(wheel)}
+    {
+
+    }
+
+    pool_t::~pool_t() {
+
+    }
+
+    void pool_t::set_option(const max_idle_connections_t& max_idle_connections) {
+        pimpl->set_option(max_idle_connections);
+    }
+
+    void pool_t::set_option(const max_idle_time_t& max_idle_time) {
+        pimpl->set_option(max_idle_time);
+    }
+
+    /*
+      A TLS connection is checked and authenticated once, in its handshake,
+      so the settings of the handshake are a part of its origin. They are
+      hashed to keep the inline certificates out of the key.
+    */
+    string_t pool_t::key(const request_t& request) {
+        const auto& uri = request.uri();
+        const auto origin =
+            uri.protocol().value() + "://" +
+            uri.domain().value() + ":" +
+            uri.port().value();
+        if (not request.is_ssl())
+            return origin;
+
+        std::ostringstream settings;
+        settings
+            << request.always_verify_peer().value() << "\n"
+            << request.verify_path().value() << "\n"
+            << request.verify_filename().value() << "\n"
+            << request.certificate_file().value() << "\n"
+            << request.private_key_file().value() << "\n"
+            << request.ssl_auth() << "\n"
+            << request.ssl_certs();
+
+        std::ostringstream rv;
+        rv << origin << "#" << std::hex << std::hash<string_t>()(settings.str());
+        return rv.str();
+    }
+
+    bool pool_t::put(const string_t& key, stream_t&& stream) {
+        return pimpl->put(key, std::move(stream));
+    }
+
+    bool pool_t::take(const string_t& key, stream_t& stream) {
+        return pimpl->take(key, stream);
+    }
+
+    size_t pool_t::size(const string_t& key) const {
+        return pimpl->size(key);
+    }
+
+    size_t pool_t::size() const {
+        return pimpl->size();
+    }
+
+    void pool_t::clear() {
+        pimpl->clear();
+    }
+
+
+} /* namespace crequests */
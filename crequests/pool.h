@@ -0,0 +1,72 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include "macros.h"
+#include "timer_wheel.h"
+#include "types.h"
+
+namespace crequests {
+
+
+    class stream_t;
+
+
+    /*
+      Service options of the pool of idle connections: how many of them
+      are kept per origin (8 by default) and how long an idle one is kept
+      in milliseconds (30 seconds by default).
+    */
+    declare_number(max_idle_connections, size_t)
+    declare_number(max_idle_time, size_t)
+
+
+    /*
+      Connections which are set up ahead of the traffic (see
+      service_t::preconnect()) and wait for the first requests to their
+      origin. A parked connection is checked before it is handed out, so
+      the ones closed by the server or idle for too long are dropped. The
+      ones nobody asks for are swept by a timer of the wheel when their
+      idle time is over. Can be used from any thread.
+    */
+    class pool_t {
+    public:
+        explicit pool_t(timer_wheel_t& wheel);
+        pool_t(const pool_t& pool) = delete;
+        pool_t& operator=(const pool_t& pool) = delete;
+        ~pool_t();
+
+    public:
+        void set_option(const max_idle_connections_t& max_idle_connections);
+        void set_option(const max_idle_time_t& max_idle_time);
+
+        /*
+          The origin the connection of the request belongs to. The one
+          of a TLS connection includes the settings of its handshake.
+        */
+        static string_t key(const request_t& request);
+
+        /*
+          Parks the connection. Returns false (and closes the connection)
+          when the origin has enough of them already.
+        */
+        bool put(const string_t& key, stream_t&& stream);
+
+        /*
+          Moves a live connection of the origin into the stream.
+          Returns false when there is none.
+        */
+        bool take(const string_t& key, stream_t& stream);
+
+        size_t size(const string_t& key) const;
+        size_t size() const;
+        void clear();
+
+    private:
+        friend class pool_impl_t;
+        shared_ptr_t<class pool_impl_t> pimpl;
+    };
+
+
+} /* namespace crequests */
+
+#endif /* POOL_H */
@@ -0,0 +1,235 @@
+#include "redirect_cache.h"
+#include "utils.h"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace crequests {
+
+
+    namespace {
+
+        const size_t DEFAULT_MAX_CACHED_REDIRECTS = 1024;
+        const size_t DEFAULT_PERMANENT_REDIRECT_TTL = 3600000;
+        const size_t DEFAULT_TEMPORARY_REDIRECT_TTL = 0;
+
+        bool is_permanent(const unsigned int status) {
+            return status == 301 or status == 308;
+        }
+
+        bool is_temporary(const unsigned int status) {
+            return status == 302 or status == 303 or status == 307;
+        }
+
+    } /* anonymous namespace */
+
+
+    /************************************************************
+     * redirect_cache_impl_t section.
+     ************************************************************/
+
+
+    class redirect_cache_impl_t {
+    public:
+        redirect_cache_impl_t() = default;
+
+    public:
+        void set_option(const max_cached_redirects_t& max_cached_redirects);
+        void set_option(const permanent_redirect_ttl_t& permanent_redirect_ttl);
+        void set_option(const temporary_redirect_ttl_t& temporary_redirect_ttl);
+        void put(const string_t& url,
+                 const string_t& location,
+                 const unsigned int status,
+                 const headers_t& fields);
+        bool find(const string_t& url, string_t& location, unsigned int& status);
+        size_t size() const;
+        void clear();
+
+    private:
+        /*
+          The most recently used urls are at the front of the list.
+        */
+        using order_t = std::list<string_t>;
+
+        struct entry_t {
+            entry_t(const string_t& location_,
+                    const unsigned int status_,
+                    const time_point_t& expires_at_,
+                    const order_t::iterator& position_)
+                : location(location_),
+                  status(status_),
+                  expires_at(expires_at_),
+                  position(position_)
+            {}
+
+            string_t location;
+            unsigned int status;
+            time_point_t expires_at;
+            order_t::iterator position;
+        };
+
+    private:
+        void erase(const string_t& url);
+        void shrink();
+
+    private:
+        mutable std::mutex mutex {};
+        order_t order {};
+        std::unordered_map<string_t, entry_t> entries {};
+        size_t max_cached_redirects {DEFAULT_MAX_CACHED_REDIRECTS};
+        milliseconds_t permanent_ttl {DEFAULT_PERMANENT_REDIRECT_TTL};
+        milliseconds_t temporary_ttl {DEFAULT_TEMPORARY_REDIRECT_TTL};
+    };
+
+    void redirect_cache_impl_t::set_option(const max_cached_redirects_t& max_cached_redirects_) {
+        std::lock_guard<std::mutex> lock(mutex);
+        max_cached_redirects = max_cached_redirects_.value();
+        shrink();
+    }
+
+    void redirect_cache_impl_t::set_option(const permanent_redirect_ttl_t& permanent_redirect_ttl) {
+        std::lock_guard<std::mutex> lock(mutex);
+        permanent_ttl = milliseconds_t(permanent_redirect_ttl.value());
+    }
+
+    void redirect_cache_impl_t::set_option(const temporary_redirect_ttl_t& temporary_redirect_ttl) {
+        std::lock_guard<std::mutex> lock(mutex);
+        temporary_ttl = milliseconds_t(temporary_redirect_ttl.value());
+    }
+
+    void redirect_cache_impl_t::erase(const string_t& url) {
+        const auto it = entries.find(url);
+        if (it == entries.end())
+            return;
+
+        order.erase(it->second.position);
+        entries.erase(it);
+    }
+
+    void redirect_cache_impl_t::shrink() {
+        while (entries.size() > max_cached_redirects) {
+            entries.erase(order.back());
+            order.pop_back();
+        }
+    }
+
+    /*
+      A redirect which is not cacheable any more replaces the one kept
+      before, so the url is forgotten.
+    */
+    void redirect_cache_impl_t::put(const string_t& url,
+                                    const string_t& location,
+                                    const unsigned int status,
+                                    const headers_t& fields) {
+        const auto directives = cache_control(fields);
+        std::lock_guard<std::mutex> lock(mutex);
+        erase(url);
+
+        auto ttl =
+            is_permanent(status) ? permanent_ttl :
+            is_temporary(status) ? temporary_ttl :
+            milliseconds_t{0};
+
+        seconds_t max_age;
+        if (directives.count("no-store") or directives.count("no-cache"))
+            ttl = milliseconds_t{0};
+        else if ((is_permanent(status) or is_temporary(status)) and
+                 parse_seconds(directives, "max-age", max_age))
+            ttl = std::chrono::duration_cast<milliseconds_t>(max_age);
+
+        if (ttl.count() == 0 or max_cached_redirects == 0 or url == location)
+            return;
+
+        order.push_front(url);
+        entries.emplace(url, entry_t(location, status, steady_clock_t::now() + ttl, order.begin()));
+        shrink();
+    }
+
+    bool redirect_cache_impl_t::find(const string_t& url,
+                                     string_t& location,
+                                     unsigned int& status) {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = entries.find(url);
+        if (it == entries.end())
+            return false;
+
+        if (it->second.expires_at <= steady_clock_t::now()) {
+            erase(url);
+            return false;
+        }
+
+        order.splice(order.begin(), order, it->second.position);
+        location = it->second.location;
+        status = it->second.status;
+        return true;
+    }
+
+    size_t redirect_cache_impl_t::size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.size();
+    }
+
+    void redirect_cache_impl_t::clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+        order.clear();
+    }
+
+
+    /************************************************************
+     * redirect_cache_t section.
+     ************************************************************/
+
+
+    redirect_cache_t::redirect_cache_t()
+        : pimpl{std::make_shared<redirect_cache_impl_t>()}
+    {
+
+    }
+
+    redirect_cache_t::~redirect_cache_t() {
+
+    }
+
+    void redirect_cache_t::set_option(const max_cached_redirects_t& max_cached_redirects) {
+        pimpl->set_option(max_cached_redirects);
+    }
+
+    void redirect_cache_t::set_option(const permanent_redirect_ttl_t& permanent_redirect_ttl) {
+        pimpl->set_option(permanent_redirect_ttl);
+    }
+
+    void redirect_cache_t::set_option(const temporary_redirect_ttl_t& temporary_redirect_ttl) {
+        pimpl->set_option(temporary_redirect_ttl);
+    }
+
+    void redirect_cache_t::put(const string_t& url,
+                               const string_t& location,
+                               const unsigned int status) {
+        pimpl->put(url, location, status, headers_t{});
+    }
+
+    void redirect_cache_t::put(const string_t& url,
+                               const string_t& location,
+                               const unsigned int status,
+                               const headers_t& fields) {
+        pimpl->put(url, location, status, fields);
+    }
+
+    bool redirect_cache_t::find(const string_t& url,
+                                string_t& location,
+                                unsigned int& status) {
+        return pimpl->find(url, location, status);
+    }
+
+    size_t redirect_cache_t::size() const {
+        return pimpl->size();
+    }
+
+    void redirect_cache_t::clear() {
+        pimpl->clear();
+    }
+
+
+} /* namespace crequests */
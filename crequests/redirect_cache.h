@@ -0,0 +1,70 @@
+#ifndef REDIRECT_CACHE_H
+#define REDIRECT_CACHE_H
+
+#include "headers.h"
+#include "macros.h"
+#include "types.h"
+
+namespace crequests {
+
+
+    /*
+      Service options of the redirect cache: how many urls are kept
+      (1024 by default, 0 turns the cache off) and how long the permanent
+      (301, 308) and the temporary (302, 303, 307) redirects are kept
+      in milliseconds. The permanent ones are kept for an hour and the
+      temporary ones are not kept by default. Cache-Control of the redirect
+      overrides them: no-store and no-cache ones are not kept and max-age
+      sets how long the redirect is kept.
+    */
+    declare_number(max_cached_redirects, size_t)
+    declare_number(permanent_redirect_ttl, size_t)
+    declare_number(temporary_redirect_ttl, size_t)
+
+
+    /*
+      Redirects seen by all requests of a service, so the next request
+      to a moved url goes to its Location at once. The least recently
+      used url is dropped when the cache is full. Can be used from any
+      thread.
+    */
+    class redirect_cache_t {
+    public:
+        redirect_cache_t();
+        redirect_cache_t(const redirect_cache_t& redirect_cache) = delete;
+        redirect_cache_t& operator=(const redirect_cache_t& redirect_cache) = delete;
+        ~redirect_cache_t();
+
+    public:
+        void set_option(const max_cached_redirects_t& max_cached_redirects);
+        void set_option(const permanent_redirect_ttl_t& permanent_redirect_ttl);
+        void set_option(const temporary_redirect_ttl_t& temporary_redirect_ttl);
+
+        /*
+          Keeps the redirect of the url if its status and the Cache-Control
+          of its response fields allow that.
+        */
+        void put(const string_t& url, const string_t& location, const unsigned int status);
+        void put(const string_t& url,
+                 const string_t& location,
+                 const unsigned int status,
+                 const headers_t& fields);
+
+        /*
+          Sets the Location and the status of a fresh redirect of the url.
+          Returns false when there is none.
+        */
+        bool find(const string_t& url, string_t& location, unsigned int& status);
+
+        size_t size() const;
+        void clear();
+
+    private:
+        friend class redirect_cache_impl_t;
+        shared_ptr_t<class redirect_cache_impl_t> pimpl;
+    };
+
+
+} /* namespace crequests */
+
+#endif /* REDIRECT_CACHE_H */
@@ -5,59 +5,97 @@
 namespace crequests {
 
 
+    hop_t::hop_t()
+        : url{},
+          status{0},
+          location{},
+          elapsed{0}
+    {
+
+    }
+
+    hop_t::hop_t(const string_t& url_,
+                 const unsigned int status_,
+                 const string_t& location_,
+                 const milliseconds_t& elapsed_)
+        : url{url_},
+          status{status_},
+          location{location_},
+          elapsed{elapsed_}
+    {
+
+    }
+
     redirects_t::redirects_t()
-        : m_data{}
+        : m_hops{},
+          m_responses{}
     {
 
     }
 
-    redirects_t::redirects_t(const vector_t<response_t>& responses)
-        : m_data{responses}
+    redirects_t::redirects_t(const vector_t<hop_t>& hops)
+        : m_hops{hops},
+          m_responses{}
     {
 
     }
 
-    redirects_t::redirects_t(vector_t<response_t>&& responses)
-        : m_data{std::move(responses)}
+    redirects_t::redirects_t(vector_t<hop_t>&& hops)
+        : m_hops{std::move(hops)},
+          m_responses{}
     {
 
     }
 
-    const vector_t<response_t>& redirects_t::get() const
+    const vector_t<hop_t>& redirects_t::get() const
+    {
+        return m_hops;
+    }
+
+    vector_t<hop_t>& redirects_t::get()
     {
-        return m_data;
+        return m_hops;
     }
 
-    vector_t<response_t>& redirects_t::get()
+    void redirects_t::add(hop_t&& hop)
     {
-        return m_data;
+        m_hops.push_back(std::move(hop));
+    }
+
+    const vector_t<response_t>& redirects_t::responses() const
+    {
+        return m_responses;
     }
 
     void redirects_t::add(const response_t& response)
     {
-        for (const auto& resp : get()) {
-            if (resp.request().uri().domain() == response.request().uri().domain()) {
-                return;
-            }
-        }
-        get().push_back(response);
+        m_responses.push_back(response);
     }
 
-    optional_t<response_t> redirects_t::find(const request_t& request) const
+    optional_t<string_t> redirects_t::find(const request_t& request) const
     {
-        for (const auto& resp : get()) {
-            if (resp.request().uri().domain() == request.uri().domain()) {
-                return get().back();
+        for (const auto& hop : get()) {
+            if (uri_t::from_string(hop.url).domain() == request.uri().domain()) {
+                return get().back().location;
             }
         }
 
         return boost::none;
     }
 
+    std::ostream& operator<<(std::ostream& out, const hop_t& hop)
+    {
+        out << hop.status << " " << hop.url
+            << " -> " << hop.location
+            << " (" << hop.elapsed.count() << " ms)";
+
+        return out;
+    }
+
     std::ostream& operator<<(std::ostream& out, const redirects_t& redirects)
     {
-        for (const auto& redirect : redirects.get()) {
-            out << redirect << "\n";
+        for (const auto& hop : redirects.get()) {
+            out << hop << "\n";
         }
 
         return out;
@@ -7,20 +7,53 @@
 namespace crequests {
 
 
+    /*
+      One hop of a redirect chain: the url which was requested, the
+      status and the Location of its response and the time it took
+      from the start of the hop to the headers of the response.
+    */
+    struct hop_t {
+        hop_t();
+        hop_t(const string_t& url_,
+              const unsigned int status_,
+              const string_t& location_,
+              const milliseconds_t& elapsed_);
+
+        string_t url;
+        unsigned int status;
+        string_t location;
+        milliseconds_t elapsed;
+    };
+
+
     class redirects_t {
     public:
         redirects_t();
-        redirects_t(const vector_t<response_t>& responses);
-        redirects_t(vector_t<response_t>&& responses);
-        const vector_t<response_t>& get() const;
-        vector_t<response_t>& get();
+        redirects_t(const vector_t<hop_t>& hops);
+        redirects_t(vector_t<hop_t>&& hops);
+        const vector_t<hop_t>& get() const;
+        vector_t<hop_t>& get();
+        void add(hop_t&& hop);
+
+        /*
+          Whole intermediate responses, kept only for the requests with
+          keep_redirect_responses_t set.
+        */
+        const vector_t<response_t>& responses() const;
         void add(const response_t& response);
-        optional_t<response_t> find(const request_t& request) const;
+
+        /*
+          The final Location of the chain when it started on the domain
+          of the request.
+        */
+        optional_t<string_t> find(const request_t& request) const;
 
     private:
-        vector_t<response_t> m_data;
+        vector_t<hop_t> m_hops;
+        vector_t<response_t> m_responses;
     };
 
+    std::ostream& operator<<(std::ostream& out, const hop_t& hop);
     std::ostream& operator<<(std::ostream& out, const redirects_t& redirects);
 
 
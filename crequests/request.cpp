@@ -35,7 +35,25 @@ namespace crequests {
           m_verify_path {request.m_verify_path},
           m_verify_filename {request.m_verify_filename},
           m_certificate_file {request.m_certificate_file},
-          m_private_key_file {request.m_private_key_file}
+          m_private_key_file {request.m_private_key_file},
+          m_inline_io {request.m_inline_io},
+          m_cancel_token {request.m_cancel_token},
+          m_cancel_on_drop {request.m_cancel_on_drop},
+          m_deadline {request.m_deadline},
+          m_resolve_timeout {request.m_resolve_timeout},
+          m_connect_timeout {request.m_connect_timeout},
+          m_handshake_timeout {request.m_handshake_timeout},
+          m_first_byte_timeout {request.m_first_byte_timeout},
+          m_read_timeout {request.m_read_timeout},
+          m_total_timeout {request.m_total_timeout},
+          m_priority {request.m_priority},
+          m_read_quota {request.m_read_quota},
+          m_max_bandwidth {request.m_max_bandwidth},
+          m_hedge_delay {request.m_hedge_delay},
+          m_hedge_percentile {request.m_hedge_percentile},
+          m_retry_policy {request.m_retry_policy},
+          m_keep_redirect_responses {request.m_keep_redirect_responses},
+          m_coalesce {request.m_coalesce}
     {
 
     }
@@ -63,7 +81,25 @@ namespace crequests {
           m_verify_path {std::move(request.m_verify_path)},
           m_verify_filename {std::move(request.m_verify_filename)},
           m_certificate_file {std::move(request.m_certificate_file)},
-          m_private_key_file {std::move(request.m_private_key_file)}
+          m_private_key_file {std::move(request.m_private_key_file)},
+          m_inline_io {std::move(request.m_inline_io)},
+          m_cancel_token {std::move(request.m_cancel_token)},
+          m_cancel_on_drop {std::move(request.m_cancel_on_drop)},
+          m_deadline {std::move(request.m_deadline)},
+          m_resolve_timeout {std::move(request.m_resolve_timeout)},
+          m_connect_timeout {std::move(request.m_connect_timeout)},
+          m_handshake_timeout {std::move(request.m_handshake_timeout)},
+          m_first_byte_timeout {std::move(request.m_first_byte_timeout)},
+          m_read_timeout {std::move(request.m_read_timeout)},
+          m_total_timeout {std::move(request.m_total_timeout)},
+          m_priority {std::move(request.m_priority)},
+          m_read_quota {std::move(request.m_read_quota)},
+          m_max_bandwidth {std::move(request.m_max_bandwidth)},
+          m_hedge_delay {std::move(request.m_hedge_delay)},
+          m_hedge_percentile {std::move(request.m_hedge_percentile)},
+          m_retry_policy {std::move(request.m_retry_policy)},
+          m_keep_redirect_responses {std::move(request.m_keep_redirect_responses)},
+          m_coalesce {std::move(request.m_coalesce)}
     {
 
     }
@@ -93,6 +129,24 @@ namespace crequests {
             m_verify_filename = request.m_verify_filename;
             m_certificate_file = request.m_certificate_file;
             m_private_key_file = request.m_private_key_file;
+            m_inline_io = request.m_inline_io;
+            m_cancel_token = request.m_cancel_token;
+            m_cancel_on_drop = request.m_cancel_on_drop;
+            m_deadline = request.m_deadline;
+            m_resolve_timeout = request.m_resolve_timeout;
+            m_connect_timeout = request.m_connect_timeout;
+            m_handshake_timeout = request.m_handshake_timeout;
+            m_first_byte_timeout = request.m_first_byte_timeout;
+            m_read_timeout = request.m_read_timeout;
+            m_total_timeout = request.m_total_timeout;
+            m_priority = request.m_priority;
+            m_read_quota = request.m_read_quota;
+            m_max_bandwidth = request.m_max_bandwidth;
+            m_hedge_delay = request.m_hedge_delay;
+            m_hedge_percentile = request.m_hedge_percentile;
+            m_retry_policy = request.m_retry_policy;
+            m_keep_redirect_responses = request.m_keep_redirect_responses;
+            m_coalesce = request.m_coalesce;
         }
 
         return *this;
@@ -280,6 +334,78 @@ namespace crequests {
         m_private_key_file = private_key_file;
     }
 
+    void request_t::inline_io(const inline_io_t& inline_io) {
+        m_inline_io = inline_io;
+    }
+
+    void request_t::cancel_token(const cancel_token_t& cancel_token) {
+        m_cancel_token = cancel_token;
+    }
+
+    void request_t::cancel_on_drop(const cancel_on_drop_t& cancel_on_drop) {
+        m_cancel_on_drop = cancel_on_drop;
+    }
+
+    void request_t::deadline(const deadline_t& deadline) {
+        m_deadline = deadline;
+    }
+
+    void request_t::resolve_timeout(const resolve_timeout_t& resolve_timeout) {
+        m_resolve_timeout = resolve_timeout;
+    }
+
+    void request_t::connect_timeout(const connect_timeout_t& connect_timeout) {
+        m_connect_timeout = connect_timeout;
+    }
+
+    void request_t::handshake_timeout(const handshake_timeout_t& handshake_timeout) {
+        m_handshake_timeout = handshake_timeout;
+    }
+
+    void request_t::first_byte_timeout(const first_byte_timeout_t& first_byte_timeout) {
+        m_first_byte_timeout = first_byte_timeout;
+    }
+
+    void request_t::read_timeout(const read_timeout_t& read_timeout) {
+        m_read_timeout = read_timeout;
+    }
+
+    void request_t::total_timeout(const total_timeout_t& total_timeout) {
+        m_total_timeout = total_timeout;
+    }
+
+    void request_t::priority(const priority_t& priority) {
+        m_priority = priority;
+    }
+
+    void request_t::read_quota(const read_quota_t& read_quota) {
+        m_read_quota = read_quota;
+    }
+
+    void request_t::max_bandwidth(const max_bandwidth_t& max_bandwidth) {
+        m_max_bandwidth = max_bandwidth;
+    }
+
+    void request_t::hedge_delay(const hedge_delay_t& hedge_delay) {
+        m_hedge_delay = hedge_delay;
+    }
+
+    void request_t::hedge_percentile(const hedge_percentile_t& hedge_percentile) {
+        m_hedge_percentile = hedge_percentile;
+    }
+
+    void request_t::retry_policy(const retry_policy_t& retry_policy) {
+        m_retry_policy = retry_policy;
+    }
+
+    void request_t::keep_redirect_responses(const keep_redirect_responses_t& keep_redirect_responses) {
+        m_keep_redirect_responses = keep_redirect_responses;
+    }
+
+    void request_t::coalesce(const coalesce_t& coalesce) {
+        m_coalesce = coalesce;
+    }
+
 
     /****************************************************************************
      * Set. Rvalue reference.
@@ -374,6 +500,78 @@ namespace crequests {
         m_private_key_file = std::move(private_key_file);
     }
 
+    void request_t::inline_io(inline_io_t&& inline_io) {
+        m_inline_io = std::move(inline_io);
+    }
+
+    void request_t::cancel_token(cancel_token_t&& cancel_token) {
+        m_cancel_token = std::move(cancel_token);
+    }
+
+    void request_t::cancel_on_drop(cancel_on_drop_t&& cancel_on_drop) {
+        m_cancel_on_drop = std::move(cancel_on_drop);
+    }
+
+    void request_t::deadline(deadline_t&& deadline) {
+        m_deadline = std::move(deadline);
+    }
+
+    void request_t::resolve_timeout(resolve_timeout_t&& resolve_timeout) {
+        m_resolve_timeout = std::move(resolve_timeout);
+    }
+
+    void request_t::connect_timeout(connect_timeout_t&& connect_timeout) {
+        m_connect_timeout = std::move(connect_timeout);
+    }
+
+    void request_t::handshake_timeout(handshake_timeout_t&& handshake_timeout) {
+        m_handshake_timeout = std::move(handshake_timeout);
+    }
+
+    void request_t::first_byte_timeout(first_byte_timeout_t&& first_byte_timeout) {
+        m_first_byte_timeout = std::move(first_byte_timeout);
+    }
+
+    void request_t::read_timeout(read_timeout_t&& read_timeout) {
+        m_read_timeout = std::move(read_timeout);
+    }
+
+    void request_t::total_timeout(total_timeout_t&& total_timeout) {
+        m_total_timeout = std::move(total_timeout);
+    }
+
+    void request_t::priority(priority_t&& priority) {
+        m_priority = std::move(priority);
+    }
+
+    void request_t::read_quota(read_quota_t&& read_quota) {
+        m_read_quota = std::move(read_quota);
+    }
+
+    void request_t::max_bandwidth(max_bandwidth_t&& max_bandwidth) {
+        m_max_bandwidth = std::move(max_bandwidth);
+    }
+
+    void request_t::hedge_delay(hedge_delay_t&& hedge_delay) {
+        m_hedge_delay = std::move(hedge_delay);
+    }
+
+    void request_t::hedge_percentile(hedge_percentile_t&& hedge_percentile) {
+        m_hedge_percentile = std::move(hedge_percentile);
+    }
+
+    void request_t::retry_policy(retry_policy_t&& retry_policy) {
+        m_retry_policy = std::move(retry_policy);
+    }
+
+    void request_t::keep_redirect_responses(keep_redirect_responses_t&& keep_redirect_responses) {
+        m_keep_redirect_responses = std::move(keep_redirect_responses);
+    }
+
+    void request_t::coalesce(coalesce_t&& coalesce) {
+        m_coalesce = std::move(coalesce);
+    }
+
 
     /****************************************************************************
      * Get. Constant reference.
@@ -472,6 +670,78 @@ namespace crequests {
         return m_private_key_file;
     }
 
+    const inline_io_t& request_t::inline_io() const {
+        return m_inline_io;
+    }
+
+    const cancel_token_t& request_t::cancel_token() const {
+        return m_cancel_token;
+    }
+
+    const cancel_on_drop_t& request_t::cancel_on_drop() const {
+        return m_cancel_on_drop;
+    }
+
+    const deadline_t& request_t::deadline() const {
+        return m_deadline;
+    }
+
+    const resolve_timeout_t& request_t::resolve_timeout() const {
+        return m_resolve_timeout;
+    }
+
+    const connect_timeout_t& request_t::connect_timeout() const {
+        return m_connect_timeout;
+    }
+
+    const handshake_timeout_t& request_t::handshake_timeout() const {
+        return m_handshake_timeout;
+    }
+
+    const first_byte_timeout_t& request_t::first_byte_timeout() const {
+        return m_first_byte_timeout;
+    }
+
+    const read_timeout_t& request_t::read_timeout() const {
+        return m_read_timeout;
+    }
+
+    const total_timeout_t& request_t::total_timeout() const {
+        return m_total_timeout;
+    }
+
+    const priority_t& request_t::priority() const {
+        return m_priority;
+    }
+
+    const read_quota_t& request_t::read_quota() const {
+        return m_read_quota;
+    }
+
+    const max_bandwidth_t& request_t::max_bandwidth() const {
+        return m_max_bandwidth;
+    }
+
+    const hedge_delay_t& request_t::hedge_delay() const {
+        return m_hedge_delay;
+    }
+
+    const hedge_percentile_t& request_t::hedge_percentile() const {
+        return m_hedge_percentile;
+    }
+
+    const retry_policy_t& request_t::retry_policy() const {
+        return m_retry_policy;
+    }
+
+    const keep_redirect_responses_t& request_t::keep_redirect_responses() const {
+        return m_keep_redirect_responses;
+    }
+
+    const coalesce_t& request_t::coalesce() const {
+        return m_coalesce;
+    }
+
 
     /****************************************************************************
      * Other functions.
@@ -2,9 +2,11 @@
 #define REQUEST_H
 
 #include "auth.h"
+#include "cancel_token.h"
 #include "cookies.h"
 #include "headers.h"
 #include "macros.h"
+#include "retry.h"
 #include "ssl_auth.h"
 #include "ssl_certs.h"
 #include "types.h"
@@ -15,7 +17,9 @@ namespace crequests {
 
     declare_bool(always_verify_peer)
     declare_bool(cache_redirects)
+    declare_bool(cancel_on_drop)
     declare_bool(gzip)
+    declare_bool(inline_io)
     declare_bool(keep_alive)
     declare_bool(redirect)
     declare_bool(throw_on_error)
@@ -30,6 +34,100 @@ namespace crequests {
     declare_string(method)
 
 
+    /*
+      Timeouts of the request phases in milliseconds, 0 means no limit.
+      The total one covers the whole request with redirects and retries
+      of a stale connection and replaces timeout_t (seconds) when set.
+      The read one limits an idle time between two reads of the response.
+    */
+    declare_number(resolve_timeout, size_t)
+    declare_number(connect_timeout, size_t)
+    declare_number(handshake_timeout, size_t)
+    declare_number(first_byte_timeout, size_t)
+    declare_number(read_timeout, size_t)
+    declare_number(total_timeout, size_t)
+
+
+    /*
+      Requests with a greater priority are let through the service queue
+      and delivered into a completion queue first. Requests of the same
+      priority are ordered by the earliest deadline (see deadline_t and
+      the timeouts) and then by arrival. Negative values are for bulk work.
+    */
+    declare_number(priority, int)
+
+
+    /*
+      Fair sharing of the io thread and the network. A response body is
+      read by slices of at most read_quota bytes and other connections
+      get their turn between the slices. The max bandwidth (bytes per
+      second, 0 means no limit) throttles reads of the request.
+    */
+    declare_number(read_quota, size_t)
+    declare_number(max_bandwidth, size_t)
+
+
+    /*
+      Hedging of idempotent requests: when no response came in hedge_delay
+      milliseconds (or in the given percentile of the recent latencies of
+      the host, once there are enough of them) a second copy of the request
+      is sent on a new connection. The first good response wins and the
+      other copy is cancelled. Both are 0 (off) by default.
+    */
+    declare_number(hedge_delay, size_t)
+    declare_number(hedge_percentile, size_t)
+
+
+    /*
+      The redirect history of a response keeps the url, the status, the
+      Location and the time of every hop. The whole intermediate
+      responses are kept too only when asked for, since they are copies
+      of the request, the headers and the body of every hop.
+    */
+    declare_bool(keep_redirect_responses)
+
+
+    /*
+      Single flight of GET requests: while a request with the same
+      fingerprint (see coalescer.h) is on the way, the request waits for
+      its response instead of going to the network. Off by default.
+    */
+    declare_bool(coalesce)
+
+
+    /*
+      Point of time by which a request must be done (with all its
+      redirects), whatever its timeout is. Being absolute it can be
+      passed from an incoming call to the outgoing requests unchanged.
+      The default deadline is never reached.
+    */
+    class deadline_t {
+    public:
+        explicit deadline_t() = default;
+        explicit deadline_t(const time_point_t& arg) : val(arg) {}
+        explicit deadline_t(const milliseconds_t& from_now)
+            : val(steady_clock_t::now() + from_now) {}
+        deadline_t(const deadline_t& arg) = default;
+        deadline_t(deadline_t&& arg) = default;
+        deadline_t& operator = (const deadline_t& arg) = default;
+        deadline_t& operator = (deadline_t&& arg) = default;
+
+        bool operator==(const deadline_t& rhs) const {
+            return val == rhs.val;
+        }
+        bool operator!=(const deadline_t& rhs) const {
+            return val != rhs.val;
+        }
+
+        const time_point_t& value() const { return val; }
+        time_point_t& value() { return val; }
+        bool empty() const { return val == time_point_t::max(); }
+
+    private:
+        time_point_t val { time_point_t::max() };
+    };
+
+
     const headers_t DEFAULT_HEADERS {
         {"Accept", "*/*"},
         {"Accept-Encoding", "gzip, deflate"},
@@ -95,6 +193,24 @@ namespace crequests {
         void verify_filename(const verify_filename_t& verify_filename);
         void certificate_file(const certificate_file_t& certificate_file);
         void private_key_file(const private_key_file_t& private_key_file);
+        void inline_io(const inline_io_t& inline_io);
+        void cancel_token(const cancel_token_t& cancel_token);
+        void cancel_on_drop(const cancel_on_drop_t& cancel_on_drop);
+        void deadline(const deadline_t& deadline);
+        void resolve_timeout(const resolve_timeout_t& resolve_timeout);
+        void connect_timeout(const connect_timeout_t& connect_timeout);
+        void handshake_timeout(const handshake_timeout_t& handshake_timeout);
+        void first_byte_timeout(const first_byte_timeout_t& first_byte_timeout);
+        void read_timeout(const read_timeout_t& read_timeout);
+        void total_timeout(const total_timeout_t& total_timeout);
+        void priority(const priority_t& priority);
+        void read_quota(const read_quota_t& read_quota);
+        void max_bandwidth(const max_bandwidth_t& max_bandwidth);
+        void hedge_delay(const hedge_delay_t& hedge_delay);
+        void hedge_percentile(const hedge_percentile_t& hedge_percentile);
+        void retry_policy(const retry_policy_t& retry_policy);
+        void keep_redirect_responses(const keep_redirect_responses_t& keep_redirect_responses);
+        void coalesce(const coalesce_t& coalesce);
 
         void method(method_t&& method);
         void timeout(timeout_t&& timeout);
@@ -118,6 +234,24 @@ namespace crequests {
         void verify_filename(verify_filename_t&& verify_filename);
         void certificate_file(certificate_file_t&& certificate_file);
         void private_key_file(private_key_file_t&& private_key_file);
+        void inline_io(inline_io_t&& inline_io);
+        void cancel_token(cancel_token_t&& cancel_token);
+        void cancel_on_drop(cancel_on_drop_t&& cancel_on_drop);
+        void deadline(deadline_t&& deadline);
+        void resolve_timeout(resolve_timeout_t&& resolve_timeout);
+        void connect_timeout(connect_timeout_t&& connect_timeout);
+        void handshake_timeout(handshake_timeout_t&& handshake_timeout);
+        void first_byte_timeout(first_byte_timeout_t&& first_byte_timeout);
+        void read_timeout(read_timeout_t&& read_timeout);
+        void total_timeout(total_timeout_t&& total_timeout);
+        void priority(priority_t&& priority);
+        void read_quota(read_quota_t&& read_quota);
+        void max_bandwidth(max_bandwidth_t&& max_bandwidth);
+        void hedge_delay(hedge_delay_t&& hedge_delay);
+        void hedge_percentile(hedge_percentile_t&& hedge_percentile);
+        void retry_policy(retry_policy_t&& retry_policy);
+        void keep_redirect_responses(keep_redirect_responses_t&& keep_redirect_responses);
+        void coalesce(coalesce_t&& coalesce);
 
         const uri_t& uri() const;
         const method_t& method() const;
@@ -142,6 +276,24 @@ namespace crequests {
         const verify_filename_t& verify_filename() const;
         const certificate_file_t& certificate_file() const;
         const private_key_file_t& private_key_file() const;
+        const inline_io_t& inline_io() const;
+        const cancel_token_t& cancel_token() const;
+        const cancel_on_drop_t& cancel_on_drop() const;
+        const deadline_t& deadline() const;
+        const resolve_timeout_t& resolve_timeout() const;
+        const connect_timeout_t& connect_timeout() const;
+        const handshake_timeout_t& handshake_timeout() const;
+        const first_byte_timeout_t& first_byte_timeout() const;
+        const read_timeout_t& read_timeout() const;
+        const total_timeout_t& total_timeout() const;
+        const priority_t& priority() const;
+        const read_quota_t& read_quota() const;
+        const max_bandwidth_t& max_bandwidth() const;
+        const hedge_delay_t& hedge_delay() const;
+        const hedge_percentile_t& hedge_percentile() const;
+        const retry_policy_t& retry_policy() const;
+        const keep_redirect_responses_t& keep_redirect_responses() const;
+        const coalesce_t& coalesce() const;
 
     private:
         uri_t m_uri {};
@@ -167,6 +319,24 @@ namespace crequests {
         verify_filename_t m_verify_filename {};
         certificate_file_t m_certificate_file {};
         private_key_file_t m_private_key_file {};
+        inline_io_t m_inline_io {false};
+        cancel_token_t m_cancel_token {nullptr};
+        cancel_on_drop_t m_cancel_on_drop {false};
+        deadline_t m_deadline {};
+        resolve_timeout_t m_resolve_timeout {0};
+        connect_timeout_t m_connect_timeout {0};
+        handshake_timeout_t m_handshake_timeout {0};
+        first_byte_timeout_t m_first_byte_timeout {0};
+        read_timeout_t m_read_timeout {0};
+        total_timeout_t m_total_timeout {0};
+        priority_t m_priority {0};
+        read_quota_t m_read_quota {0};
+        max_bandwidth_t m_max_bandwidth {0};
+        hedge_delay_t m_hedge_delay {0};
+        hedge_percentile_t m_hedge_percentile {0};
+        retry_policy_t m_retry_policy {};
+        keep_redirect_responses_t m_keep_redirect_responses { false };
+        coalesce_t m_coalesce { false };
     };
 
 
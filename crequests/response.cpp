@@ -30,7 +30,13 @@ namespace crequests {
               m_redirect_count {response.m_pimpl->m_redirect_count},
               m_content {response.m_pimpl->m_content},
               m_redirects {response.m_pimpl->m_redirects},
-              m_cookies {response.m_pimpl->m_cookies}
+              m_cookies {response.m_pimpl->m_cookies},
+              m_queue_time {response.m_pimpl->m_queue_time},
+              m_network_time {response.m_pimpl->m_network_time},
+              m_hedged {response.m_pimpl->m_hedged},
+              m_retries {response.m_pimpl->m_retries},
+              m_from_cache {response.m_pimpl->m_from_cache},
+              m_coalesced {response.m_pimpl->m_coalesced}
         {
 
         }
@@ -47,7 +53,13 @@ namespace crequests {
               m_redirect_count {std::move(response.m_pimpl->m_redirect_count)},
               m_content {std::move(response.m_pimpl->m_content)},
               m_redirects {std::move(response.m_pimpl->m_redirects)},
-              m_cookies {std::move(response.m_pimpl->m_cookies)}
+              m_cookies {std::move(response.m_pimpl->m_cookies)},
+              m_queue_time {std::move(response.m_pimpl->m_queue_time)},
+              m_network_time {std::move(response.m_pimpl->m_network_time)},
+              m_hedged {std::move(response.m_pimpl->m_hedged)},
+              m_retries {std::move(response.m_pimpl->m_retries)},
+              m_from_cache {std::move(response.m_pimpl->m_from_cache)},
+              m_coalesced {std::move(response.m_pimpl->m_coalesced)}
     {
 
     }
@@ -65,6 +77,12 @@ namespace crequests {
         mutable content_t m_content {};
         redirects_t m_redirects {};
         cookies_t m_cookies {};
+        queue_time_t m_queue_time {};
+        network_time_t m_network_time {};
+        hedged_t m_hedged {};
+        retries_t m_retries {};
+        from_cache_t m_from_cache {};
+        coalesced_t m_coalesced {};
     };
 
     response_t::response_t(const request_t& request)
@@ -167,6 +185,30 @@ namespace crequests {
         m_pimpl->m_cookies = cookies;
     }
 
+    void response_t::queue_time(const queue_time_t& queue_time) {
+        m_pimpl->m_queue_time = queue_time;
+    }
+
+    void response_t::network_time(const network_time_t& network_time) {
+        m_pimpl->m_network_time = network_time;
+    }
+
+    void response_t::hedged(const hedged_t& hedged) {
+        m_pimpl->m_hedged = hedged;
+    }
+
+    void response_t::retries(const retries_t& retries) {
+        m_pimpl->m_retries = retries;
+    }
+
+    void response_t::from_cache(const from_cache_t& from_cache) {
+        m_pimpl->m_from_cache = from_cache;
+    }
+
+    void response_t::coalesced(const coalesced_t& coalesced) {
+        m_pimpl->m_coalesced = coalesced;
+    }
+
 
     /****************************************************************************
      * Set. Rvalue reference.
@@ -221,6 +263,30 @@ namespace crequests {
         m_pimpl->m_cookies = std::move(cookies);
     }
 
+    void response_t::queue_time(queue_time_t&& queue_time) {
+        m_pimpl->m_queue_time = std::move(queue_time);
+    }
+
+    void response_t::network_time(network_time_t&& network_time) {
+        m_pimpl->m_network_time = std::move(network_time);
+    }
+
+    void response_t::hedged(hedged_t&& hedged) {
+        m_pimpl->m_hedged = std::move(hedged);
+    }
+
+    void response_t::retries(retries_t&& retries) {
+        m_pimpl->m_retries = std::move(retries);
+    }
+
+    void response_t::from_cache(from_cache_t&& from_cache) {
+        m_pimpl->m_from_cache = std::move(from_cache);
+    }
+
+    void response_t::coalesced(coalesced_t&& coalesced) {
+        m_pimpl->m_coalesced = std::move(coalesced);
+    }
+
 
     /****************************************************************************
      * Get. Constant reference.
@@ -284,6 +350,30 @@ namespace crequests {
         return m_pimpl->m_cookies;
     }
 
+    const queue_time_t& response_t::queue_time() const {
+        return m_pimpl->m_queue_time;
+    }
+
+    const network_time_t& response_t::network_time() const {
+        return m_pimpl->m_network_time;
+    }
+
+    const hedged_t& response_t::hedged() const {
+        return m_pimpl->m_hedged;
+    }
+
+    const retries_t& response_t::retries() const {
+        return m_pimpl->m_retries;
+    }
+
+    const from_cache_t& response_t::from_cache() const {
+        return m_pimpl->m_from_cache;
+    }
+
+    const coalesced_t& response_t::coalesced() const {
+        return m_pimpl->m_coalesced;
+    }
+
     request_t& response_t::request() {
         return m_pimpl->m_request;
     }
@@ -332,6 +422,30 @@ namespace crequests {
         return m_pimpl->m_cookies;
     }
 
+    queue_time_t& response_t::queue_time() {
+        return m_pimpl->m_queue_time;
+    }
+
+    network_time_t& response_t::network_time() {
+        return m_pimpl->m_network_time;
+    }
+
+    hedged_t& response_t::hedged() {
+        return m_pimpl->m_hedged;
+    }
+
+    retries_t& response_t::retries() {
+        return m_pimpl->m_retries;
+    }
+
+    from_cache_t& response_t::from_cache() {
+        return m_pimpl->m_from_cache;
+    }
+
+    coalesced_t& response_t::coalesced() {
+        return m_pimpl->m_coalesced;
+    }
+
 
     /****************************************************************************
      * Other functions.
@@ -17,6 +17,36 @@ namespace crequests {
     declare_string(raw)
     declare_string(content)
 
+    /*
+      Time in milliseconds the request waited in the service queue
+      for a free connection slot and the time it spent on the network
+      after that (with redirects).
+    */
+    declare_number(queue_time, size_t)
+    declare_number(network_time, size_t)
+
+    /*
+      True if the response came from the hedged copy of the request.
+    */
+    declare_bool(hedged)
+
+    /*
+      Number of retries made by the retry policy of the request.
+    */
+    declare_number(retries, size_t)
+
+    /*
+      True if the response was taken from the http cache of the service,
+      at once or after the server told it is not modified.
+    */
+    declare_bool(from_cache)
+
+    /*
+      True if the response is the one of an identical request which was
+      on the way, shared with this request instead of sending it.
+    */
+    declare_bool(coalesced)
+
     class response_t {
     public:
         response_t(const request_t& request);
@@ -40,6 +70,12 @@ namespace crequests {
         void content(const content_t& content);
         void redirects(const redirects_t& redirects);
         void cookies(const cookies_t& cookies);
+        void queue_time(const queue_time_t& queue_time);
+        void network_time(const network_time_t& network_time);
+        void hedged(const hedged_t& hedged);
+        void retries(const retries_t& retries);
+        void from_cache(const from_cache_t& from_cache);
+        void coalesced(const coalesced_t& coalesced);
 
         void request(request_t&& request);
         void http_major(http_major_t&& http_major);
@@ -53,6 +89,12 @@ namespace crequests {
         void content(content_t&& content);
         void redirects(redirects_t&& redirects);
         void cookies(cookies_t&& cookies);
+        void queue_time(queue_time_t&& queue_time);
+        void network_time(network_time_t&& network_time);
+        void hedged(hedged_t&& hedged);
+        void retries(retries_t&& retries);
+        void from_cache(from_cache_t&& from_cache);
+        void coalesced(coalesced_t&& coalesced);
 
         const request_t& request() const;
         const http_major_t& http_major() const;
@@ -66,6 +108,12 @@ namespace crequests {
         const string_t& content() const;
         const redirects_t& redirects() const;
         const cookies_t& cookies() const;
+        const queue_time_t& queue_time() const;
+        const network_time_t& network_time() const;
+        const hedged_t& hedged() const;
+        const retries_t& retries() const;
+        const from_cache_t& from_cache() const;
+        const coalesced_t& coalesced() const;
 
         request_t& request();
         http_major_t& http_major();
@@ -79,6 +127,12 @@ namespace crequests {
         string_t& content();
         redirects_t& redirects();
         cookies_t& cookies();
+        queue_time_t& queue_time();
+        network_time_t& network_time();
+        hedged_t& hedged();
+        retries_t& retries();
+        from_cache_t& from_cache();
+        coalesced_t& coalesced();
 
     private:
         friend class response_impl_t;
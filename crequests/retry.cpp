@@ -0,0 +1,114 @@
+#include "retry.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <random>
+
+namespace crequests {
+
+
+    namespace {
+
+        const std::set<unsigned int> DEFAULT_STATUSES {502, 503, 504};
+
+        const std::set<error_code_t> DEFAULT_ERRORS {
+            error_code_t::RESOLVE_ERROR,
+            error_code_t::CONNECT_ERROR,
+            error_code_t::HANDSHAKE_ERROR,
+            error_code_t::WRITE_ERROR,
+            error_code_t::READ_STATUS_ERROR,
+            error_code_t::READ_STATUS_DATA_ERROR,
+            error_code_t::READ_HEADERS_ERROR,
+            error_code_t::READ_CONTENT_LENGTH_ERROR,
+            error_code_t::READ_CHUNK_HEADER_ERROR,
+            error_code_t::READ_CHUNK_DATA_ERROR,
+            error_code_t::READ_UNTIL_EOF_ERROR,
+            error_code_t::TIMEOUT
+        };
+
+        const std::set<string_t> DEFAULT_METHODS {
+            "GET", "HEAD", "OPTIONS", "TRACE", "PUT", "DELETE"
+        };
+
+        /*
+          Backoffs grow up to 2^MAX_SHIFT of the base one.
+        */
+        const size_t MAX_SHIFT = 30;
+
+    } /* anonymous namespace */
+
+
+    retry_policy_t::retry_policy_t()
+        : retry_policy_t(0)
+    {
+
+    }
+
+    retry_policy_t::retry_policy_t(const size_t retries_)
+        : m_retries(retries_),
+          m_base_backoff(100),
+          m_max_backoff(5000),
+          m_statuses(DEFAULT_STATUSES),
+          m_errors(DEFAULT_ERRORS),
+          m_methods(DEFAULT_METHODS)
+    {
+
+    }
+
+    retry_policy_t& retry_policy_t::backoff(const milliseconds_t& base,
+                                            const milliseconds_t& max) {
+        m_base_backoff = base;
+        m_max_backoff = max;
+        return *this;
+    }
+
+    retry_policy_t& retry_policy_t::statuses(const std::set<unsigned int>& statuses_) {
+        m_statuses = statuses_;
+        return *this;
+    }
+
+    retry_policy_t& retry_policy_t::errors(const std::set<error_code_t>& errors_) {
+        m_errors = errors_;
+        return *this;
+    }
+
+    retry_policy_t& retry_policy_t::methods(const std::set<string_t>& methods_) {
+        m_methods.clear();
+        for (const auto& method : methods_)
+            m_methods.insert(toupper(method));
+        return *this;
+    }
+
+    size_t retry_policy_t::retries() const {
+        return m_retries;
+    }
+
+    bool retry_policy_t::empty() const {
+        return m_retries == 0;
+    }
+
+    bool retry_policy_t::retries_status(const unsigned int status) const {
+        return m_statuses.count(status) > 0;
+    }
+
+    bool retry_policy_t::retries_error(const error_code_t& error) const {
+        return m_errors.count(error) > 0;
+    }
+
+    bool retry_policy_t::retries_method(const string_t& method) const {
+        return m_methods.count(toupper(method)) > 0;
+    }
+
+    milliseconds_t retry_policy_t::delay(const size_t retry) const {
+        const auto shift = std::min(retry, MAX_SHIFT);
+        const auto base = static_cast<std::uint64_t>(m_base_backoff.count());
+        const auto max = static_cast<std::uint64_t>(m_max_backoff.count());
+        const auto cap = base > (max >> shift) ? max : base << shift;
+
+        static thread_local std::mt19937_64 engine {std::random_device{}()};
+        std::uniform_int_distribution<std::uint64_t> distribution(0, cap);
+        return milliseconds_t(static_cast<milliseconds_t::rep>(distribution(engine)));
+    }
+
+
+} /* namespace crequests */
@@ -0,0 +1,70 @@
+#ifndef RETRY_H
+#define RETRY_H
+
+#include "error.h"
+#include "macros.h"
+#include "types.h"
+
+#include <set>
+
+namespace crequests {
+
+
+    /*
+      Service option: retries may add at most this percent of the
+      requests with a retry policy on top of them (20 by default).
+    */
+    declare_number(retry_budget, size_t)
+
+
+    /*
+      Request option which tells what to retry and how long to wait.
+      By default nothing is retried. With retries set, network errors
+      (resolve, connect, handshake, write and read ones, phase timeouts)
+      and 502, 503 and 504 statuses are retried. A request which has been
+      sent is retried only when its method is one of the retried methods
+      (GET, HEAD, OPTIONS, TRACE, PUT and DELETE by default), one which
+      has not got to the server (resolve, connect and handshake errors)
+      is retried with any method.
+
+      The wait before the retry N is a random one from 0 up to
+      min(max backoff, base backoff * 2^N) ("full jitter"), or the
+      Retry-After of the response if it is longer. Retries never go past
+      the total timeout or the deadline of the request.
+    */
+    class retry_policy_t {
+    public:
+        retry_policy_t();
+        explicit retry_policy_t(const size_t retries);
+
+    public:
+        retry_policy_t& backoff(const milliseconds_t& base, const milliseconds_t& max);
+        retry_policy_t& statuses(const std::set<unsigned int>& statuses);
+        retry_policy_t& errors(const std::set<error_code_t>& errors);
+        retry_policy_t& methods(const std::set<string_t>& methods);
+
+        size_t retries() const;
+        bool empty() const;
+        bool retries_status(const unsigned int status) const;
+        bool retries_error(const error_code_t& error) const;
+        bool retries_method(const string_t& method) const;
+
+        /*
+          Returns a random wait before the retry with the given
+          number (starting from 0).
+        */
+        milliseconds_t delay(const size_t retry) const;
+
+    private:
+        size_t m_retries;
+        milliseconds_t m_base_backoff;
+        milliseconds_t m_max_backoff;
+        std::set<unsigned int> m_statuses;
+        std::set<error_code_t> m_errors;
+        std::set<string_t> m_methods;
+    };
+
+
+} /* namespace crequests */
+
+#endif /* RETRY_H */
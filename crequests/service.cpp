@@ -3,8 +3,10 @@
 #include "request.h"
 #include "service.h"
 
+#include <atomic>
 #include <thread>
 #include <list>
+#include <mutex>
 
 namespace crequests {
 
@@ -13,6 +15,22 @@ namespace crequests {
 
         using thread_t = std::thread;
 
+        /*
+          Progress of a preconnect: connections which are not done yet
+          and the ones which are ready.
+        */
+        struct warm_up_t {
+            explicit warm_up_t(const size_t count)
+                : left(count),
+                  ready(0),
+                  promise()
+            {}
+
+            std::atomic<size_t> left;
+            std::atomic<size_t> ready;
+            promise_t<size_t> promise;
+        };
+
     } /* anonymous namespace */
 
 
@@ -21,14 +39,28 @@ namespace crequests {
      ************************************************************/
 
 
-    class service_t::service_data_t {
+    class service_t::service_data_t
+        : public std::enable_shared_from_this<service_data_t> {
     public:
         service_data_t(const dispose_timeout_t& dispose_timeout);
         service_data_t(dispose_timeout_t&& dispose_timeout);
+        service_data_t(ioservice_t& ioservice,
+                       const dispose_timeout_t& dispose_timeout);
         ~service_data_t();
 
     public:
         ioservice_t& get_service();
+        timer_wheel_t& get_timer_wheel();
+        limiter_t& get_limiter();
+        throttle_t& get_throttle();
+        breaker_t& get_breaker();
+        hedging_t& get_hedging();
+        budget_t& get_retry_budget();
+        pool_t& get_pool();
+        redirect_cache_t& get_redirect_cache();
+        http_cache_t& get_http_cache();
+        coalescer_t& get_coalescer();
+        bool is_external() const;
         session_t& add_session(const session_t& session);
         void set_dispose_timer();
         void on_dispose_timer(const ec_t& ec);
@@ -36,24 +68,71 @@ namespace crequests {
         void run();
 
     private:
-        ioservice_t ioservice {};
-        work_ptr_t work { std::make_shared<work_t>(ioservice) };
-        strand_t strand { ioservice };
-        timer__t dispose_timer { ioservice };
+        std::unique_ptr<ioservice_t> own_ioservice {};
+        ioservice_t& ioservice;
+        work_ptr_t work {};
+        strand_t strand;
+        timer__t dispose_timer;
+        timer_wheel_t wheel;
+        limiter_t limiter;
+        throttle_t throttle {};
+        breaker_t breaker {};
+        hedging_t hedging {};
+        budget_t retry_budget {20};
+        pool_t pool;
+        redirect_cache_t redirect_cache {};
+        http_cache_t http_cache {};
+        coalescer_t coalescer {};
+        std::mutex sessions_mutex {};
         std::list<session_t> sessions {};
+        bool dispose_timer_armed {false};
         std::unique_ptr<std::thread> thread {};
         dispose_timeout_t dispose_timeout { 1 };
     };
 
     service_t::service_data_t::service_data_t(const dispose_timeout_t& dispose_timeout_)
-        : dispose_timeout(dispose_timeout_)
+        : own_ioservice(new ioservice_t{}),
+          ioservice(*own_ioservice),
+          work(std::make_shared<work_t>(ioservice)),
+          strand(ioservice),
+          dispose_timer(ioservice),
+          wheel(ioservice),
+          limiter(wheel),
+          pool(wheel),
+          dispose_timeout(dispose_timeout_)
     {}
 
     service_t::service_data_t::service_data_t(dispose_timeout_t&& dispose_timeout_)
-        : dispose_timeout(std::move(dispose_timeout_))
+        : own_ioservice(new ioservice_t{}),
+          ioservice(*own_ioservice),
+          work(std::make_shared<work_t>(ioservice)),
+          strand(ioservice),
+          dispose_timer(ioservice),
+          wheel(ioservice),
+          limiter(wheel),
+          pool(wheel),
+          dispose_timeout(std::move(dispose_timeout_))
+    {}
+
+    service_t::service_data_t::service_data_t(ioservice_t& ioservice_,
+                                              const dispose_timeout_t& dispose_timeout_)
+        : ioservice(ioservice_),
+          strand(ioservice),
+          dispose_timer(ioservice),
+          wheel(ioservice),
+          limiter(wheel),
+          pool(wheel),
+          dispose_timeout(dispose_timeout_)
     {}
 
     service_t::service_data_t::~service_data_t() {
+        /*
+          An external io service is not ours to stop. Pending handlers of
+          the dispose timer hold only a weak reference and do nothing.
+        */
+        if (not own_ioservice)
+            return;
+
         work.reset();
         ioservice.stop();
 
@@ -62,10 +141,14 @@ namespace crequests {
     }
 
     void service_t::service_data_t::start() {
+        if (not own_ioservice)
+            return;
+
         thread.reset(new thread_t([this](){
             ioservice.run();
         }));
 
+        dispose_timer_armed = true;
         set_dispose_timer();
     }
 
@@ -77,16 +160,77 @@ namespace crequests {
         return ioservice;
     }
 
+    timer_wheel_t& service_t::service_data_t::get_timer_wheel() {
+        return wheel;
+    }
+
+    limiter_t& service_t::service_data_t::get_limiter() {
+        return limiter;
+    }
+
+    throttle_t& service_t::service_data_t::get_throttle() {
+        return throttle;
+    }
+
+    breaker_t& service_t::service_data_t::get_breaker() {
+        return breaker;
+    }
+
+    hedging_t& service_t::service_data_t::get_hedging() {
+        return hedging;
+    }
+
+    budget_t& service_t::service_data_t::get_retry_budget() {
+        return retry_budget;
+    }
+
+    pool_t& service_t::service_data_t::get_pool() {
+        return pool;
+    }
+
+    redirect_cache_t& service_t::service_data_t::get_redirect_cache() {
+        return redirect_cache;
+    }
+
+    http_cache_t& service_t::service_data_t::get_http_cache() {
+        return http_cache;
+    }
+
+    coalescer_t& service_t::service_data_t::get_coalescer() {
+        return coalescer;
+    }
+
+    bool service_t::service_data_t::is_external() const {
+        return not own_ioservice;
+    }
+
     session_t& service_t::service_data_t::add_session(const session_t& session) {
+        std::lock_guard<std::mutex> lock(sessions_mutex);
         sessions.push_back(session);
+
+        /*
+          On an external io service the dispose timer is armed only while
+          there are sessions, so the application loop can run out of work.
+        */
+        if (not dispose_timer_armed) {
+            dispose_timer_armed = true;
+            const std::weak_ptr<service_data_t> weak = shared_from_this();
+            ioservice.post(strand.wrap([weak]() {
+                if (const auto self = weak.lock())
+                    self->set_dispose_timer();
+            }));
+        }
+
         return sessions.back();
     }
 
     void service_t::service_data_t::set_dispose_timer() {
         dispose_timer.expires_from_now(
             seconds_t{ dispose_timeout.value() });
-        const auto callback = [this](const ec_t& ec) {
-            on_dispose_timer(ec);
+        const std::weak_ptr<service_data_t> weak = shared_from_this();
+        const auto callback = [weak](const ec_t& ec) {
+            if (const auto self = weak.lock())
+                self->on_dispose_timer(ec);
         };
         dispose_timer.async_wait(strand.wrap(callback));
     }
@@ -95,6 +239,8 @@ namespace crequests {
         if (ec)
             return;
 
+        std::lock_guard<std::mutex> lock(sessions_mutex);
+
         auto it = sessions.cbegin();
         while (it != sessions.cend()) {
             if (it->is_expired()) {
@@ -107,6 +253,11 @@ namespace crequests {
             }
         }
 
+        if (not own_ioservice and sessions.empty()) {
+            dispose_timer_armed = false;
+            return;
+        }
+
         set_dispose_timer();
     }
 
@@ -128,6 +279,18 @@ namespace crequests {
         data->start();
     }
 
+    service_t::service_t(ioservice_t& ioservice)
+        : service_t(ioservice, dispose_timeout_t { 1 })
+    {
+
+    }
+
+    service_t::service_t(ioservice_t& ioservice, const dispose_timeout_t& dispose_timeout)
+        : data(std::make_shared<service_data_t>(ioservice, dispose_timeout))
+    {
+        data->start();
+    }
+
     service_t::service_t(const service_t& service)
         : data{service.data}
     {
@@ -165,10 +328,180 @@ namespace crequests {
         return data->get_service();
     }
 
+    timer_wheel_t& service_t::get_timer_wheel() {
+        return data->get_timer_wheel();
+    }
+
+    limiter_t& service_t::get_limiter() {
+        return data->get_limiter();
+    }
+
+    void service_t::set_option(const max_connections_t& max_connections) {
+        data->get_limiter().set_option(max_connections);
+    }
+
+    void service_t::set_option(const max_host_connections_t& max_host_connections) {
+        data->get_limiter().set_option(max_host_connections);
+    }
+
+    void service_t::set_option(const max_queue_size_t& max_queue_size) {
+        data->get_limiter().set_option(max_queue_size);
+    }
+
+    void service_t::set_option(const max_queue_time_t& max_queue_time) {
+        data->get_limiter().set_option(max_queue_time);
+    }
+
+    throttle_t& service_t::get_throttle() {
+        return data->get_throttle();
+    }
+
+    void service_t::set_option(const adaptive_concurrency_t& adaptive_concurrency) {
+        data->get_limiter().set_option(adaptive_concurrency);
+    }
+
+    void service_t::set_option(const read_quota_t& read_quota) {
+        data->get_throttle().set_option(read_quota);
+    }
+
+    void service_t::set_option(const host_bandwidth_t& host_bandwidth) {
+        data->get_throttle().set_option(host_bandwidth);
+    }
+
+    void service_t::set_option(const service_bandwidth_t& service_bandwidth) {
+        data->get_throttle().set_option(service_bandwidth);
+    }
+
+    breaker_t& service_t::get_breaker() {
+        return data->get_breaker();
+    }
+
+    void service_t::set_option(const breaker_failures_t& breaker_failures) {
+        data->get_breaker().set_option(breaker_failures);
+    }
+
+    void service_t::set_option(const breaker_error_rate_t& breaker_error_rate) {
+        data->get_breaker().set_option(breaker_error_rate);
+    }
+
+    void service_t::set_option(const breaker_window_t& breaker_window) {
+        data->get_breaker().set_option(breaker_window);
+    }
+
+    void service_t::set_option(const breaker_open_time_t& breaker_open_time) {
+        data->get_breaker().set_option(breaker_open_time);
+    }
+
+    void service_t::set_option(const breaker_probes_t& breaker_probes) {
+        data->get_breaker().set_option(breaker_probes);
+    }
+
+    hedging_t& service_t::get_hedging() {
+        return data->get_hedging();
+    }
+
+    void service_t::set_option(const hedge_budget_t& hedge_budget) {
+        data->get_hedging().set_option(hedge_budget);
+    }
+
+    budget_t& service_t::get_retry_budget() {
+        return data->get_retry_budget();
+    }
+
+    void service_t::set_option(const retry_budget_t& retry_budget) {
+        data->get_retry_budget().percent(retry_budget.value());
+    }
+
+    pool_t& service_t::get_pool() {
+        return data->get_pool();
+    }
+
+    void service_t::set_option(const max_idle_connections_t& max_idle_connections) {
+        data->get_pool().set_option(max_idle_connections);
+    }
+
+    void service_t::set_option(const max_idle_time_t& max_idle_time) {
+        data->get_pool().set_option(max_idle_time);
+    }
+
+    redirect_cache_t& service_t::get_redirect_cache() {
+        return data->get_redirect_cache();
+    }
+
+    void service_t::set_option(const max_cached_redirects_t& max_cached_redirects) {
+        data->get_redirect_cache().set_option(max_cached_redirects);
+    }
+
+    void service_t::set_option(const permanent_redirect_ttl_t& permanent_redirect_ttl) {
+        data->get_redirect_cache().set_option(permanent_redirect_ttl);
+    }
+
+    void service_t::set_option(const temporary_redirect_ttl_t& temporary_redirect_ttl) {
+        data->get_redirect_cache().set_option(temporary_redirect_ttl);
+    }
+
+    http_cache_t& service_t::get_http_cache() {
+        return data->get_http_cache();
+    }
+
+    coalescer_t& service_t::get_coalescer() {
+        return data->get_coalescer();
+    }
+
+    void service_t::set_option(const max_cache_size_t& max_cache_size) {
+        data->get_http_cache().set_option(max_cache_size);
+    }
+
+    bool service_t::set_option(const cache_directory_t& cache_directory) {
+        return data->get_http_cache().set_option(cache_directory);
+    }
+
+    void service_t::set_option(const max_disk_cache_size_t& max_disk_cache_size) {
+        data->get_http_cache().set_option(max_disk_cache_size);
+    }
+
+    future_t<size_t> service_t::preconnect(const string_t& url, const size_t count) {
+        request_t request;
+        request.url(url_t{url});
+        return preconnect(request, count);
+    }
+
+    future_t<size_t> service_t::preconnect(const request_t& request, const size_t count) {
+        const auto warm_up = std::make_shared<warm_up_t>(count);
+        const future_t<size_t> future = warm_up->promise.get_future();
+        if (count == 0) {
+            warm_up->promise.set_value(0);
+            return future;
+        }
+
+        auto prepared = request;
+        prepared.prepare();
+
+        const auto completion = [warm_up](response_t&& response) {
+            if (not response.error())
+                warm_up->ready++;
+            if (--warm_up->left == 0)
+                warm_up->promise.set_value(warm_up->ready);
+        };
+
+        for (size_t i = 0; i < count; ++i)
+            connection_t{*this, prepared, completion}.preconnect();
+
+        return future;
+    }
+
+    bool service_t::is_external() const {
+        return data->is_external();
+    }
+
     session_t& service_t::new_session() {
         return data->add_session(session_t(*this));
     }
 
+    batch_t service_t::send_batch(const vector_t<request_t>& requests) {
+        return batch_t{*this, requests};
+    }
+
     void service_t::run() {
         data->run();
     }
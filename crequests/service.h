@@ -1,9 +1,21 @@
 #ifndef SERVICE_H
 #define SERVICE_H
 
+#include "batch.h"
 #include "boost_asio_fwd.h"
+#include "breaker.h"
+#include "budget.h"
+#include "coalescer.h"
+#include "hedging.h"
+#include "http_cache.h"
+#include "limiter.h"
 #include "macros.h"
+#include "pool.h"
+#include "redirect_cache.h"
+#include "retry.h"
 #include "session.h"
+#include "throttle.h"
+#include "timer_wheel.h"
 #include "types.h"
 
 namespace crequests {
@@ -14,6 +26,18 @@ namespace crequests {
     public:
         service_t();
         service_t(const dispose_timeout_t& dispose_timeout);
+
+        /*
+          The service is created on an io service owned by the application.
+          No internal thread is started: connection handlers, timers and
+          completion handlers run on the threads which run the given io
+          service. The application has to run it and keep it alive longer
+          than the service and its requests. Synchronous requests must not
+          be sent from those threads (use the asynchronous api or inline_io_t).
+        */
+        explicit service_t(ioservice_t& ioservice);
+        service_t(ioservice_t& ioservice, const dispose_timeout_t& dispose_timeout);
+
         service_t(const service_t& service);
         service_t(service_t&& service);
         service_t& operator=(const service_t& service);
@@ -22,17 +46,108 @@ namespace crequests {
 
     public:
         ioservice_t& get_service();
+        timer_wheel_t& get_timer_wheel();
+        limiter_t& get_limiter();
+        throttle_t& get_throttle();
+        breaker_t& get_breaker();
+        hedging_t& get_hedging();
+        budget_t& get_retry_budget();
+        pool_t& get_pool();
+        redirect_cache_t& get_redirect_cache();
+        http_cache_t& get_http_cache();
+        coalescer_t& get_coalescer();
+        bool is_external() const;
         void run();
 
+        /*
+          Concurrency limits of the service (see limiter.h). Can be changed
+          at any time, raising a limit lets the queued requests through.
+        */
+        void set_option(const max_connections_t& max_connections);
+        void set_option(const max_host_connections_t& max_host_connections);
+        void set_option(const max_queue_size_t& max_queue_size);
+        void set_option(const max_queue_time_t& max_queue_time);
+        void set_option(const adaptive_concurrency_t& adaptive_concurrency);
+
+        /*
+          Default read quota of the connections and bandwidth limits
+          (see throttle.h).
+        */
+        void set_option(const read_quota_t& read_quota);
+        void set_option(const host_bandwidth_t& host_bandwidth);
+        void set_option(const service_bandwidth_t& service_bandwidth);
+
+        /*
+          Circuit breaker rules of the hosts (see breaker.h).
+        */
+        void set_option(const breaker_failures_t& breaker_failures);
+        void set_option(const breaker_error_rate_t& breaker_error_rate);
+        void set_option(const breaker_window_t& breaker_window);
+        void set_option(const breaker_open_time_t& breaker_open_time);
+        void set_option(const breaker_probes_t& breaker_probes);
+        void set_option(const hedge_budget_t& hedge_budget);
+
+        /*
+          Share of the retries in the requests with a retry policy
+          (see retry.h).
+        */
+        void set_option(const retry_budget_t& retry_budget);
+
+        /*
+          Limits of the pool of idle connections (see pool.h).
+        */
+        void set_option(const max_idle_connections_t& max_idle_connections);
+        void set_option(const max_idle_time_t& max_idle_time);
+
+        /*
+          Limits of the cache of redirects (see redirect_cache.h).
+        */
+        void set_option(const max_cached_redirects_t& max_cached_redirects);
+        void set_option(const permanent_redirect_ttl_t& permanent_redirect_ttl);
+        void set_option(const temporary_redirect_ttl_t& temporary_redirect_ttl);
+
+        /*
+          Size of the http cache, it is off by default (see http_cache.h).
+        */
+        void set_option(const max_cache_size_t& max_cache_size);
+
+        /*
+          Directory and size of the disk tier of the http cache, it is
+          off by default (see disk_cache.h). Returns false when the
+          directory can not be used.
+        */
+        bool set_option(const cache_directory_t& cache_directory);
+        void set_option(const max_disk_cache_size_t& max_disk_cache_size);
+
+        /*
+          Sets up the given number of connections (resolve, connect and
+          TLS handshake) to the origin of the url or of the request and
+          parks them in the pool, so the first requests do not pay for
+          the setup. The future tells how many connections are ready.
+        */
+        future_t<size_t> preconnect(const string_t& url, const size_t count);
+        future_t<size_t> preconnect(const request_t& request, const size_t count);
+
         template <class... Args>
         session_t& new_session(Args&&... args) {
+            /*
+              The options are applied in place: the set_option members of
+              the service hide the free set_option() helpers here.
+            */
             auto& session = new_session();
-            set_option(session, std::forward<Args>(args)...);
+            using expand_t = int[];
+            (void)expand_t{0, (session.set_option(std::forward<Args>(args)), 0)...};
             return session;
         }
 
         session_t& new_session();
 
+        /*
+          Sends all requests at once. Every request is prepared as a
+          separate one and does not share cookies with the others.
+        */
+        batch_t send_batch(const vector_t<request_t>& requests);
+
     private:
         class service_data_t;
         shared_ptr_t<class service_data_t> data;
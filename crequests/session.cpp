@@ -1,7 +1,10 @@
+#include "boost_asio.h"
 #include "connection.h"
 #include "service.h"
 #include "session.h"
 
+#include <future>
+
 namespace crequests {
 
 
@@ -16,6 +19,17 @@ namespace crequests {
                 last_request.uri().protocol() == request.uri().protocol();
         }
 
+        /*
+          The io service of the calling thread for inline synchronous requests.
+          Connections share the ownership, so it lives while they are alive
+          even if the thread is already finished.
+        */
+        const ioservice_ptr_t& thread_service() {
+            static thread_local const ioservice_ptr_t ioservice =
+                std::make_shared<ioservice_t>();
+            return ioservice;
+        }
+
     } /* anonymous namespace */
 
 
@@ -35,6 +49,9 @@ namespace crequests {
 
     public:
         asyncresponse_t Send();
+        void Send(const completion_handler_t& completion);
+        response_t SendSync();
+        future_t<size_t> preconnect(const size_t count);
 
         void set_option(const string_t& url);
         void set_option(const url_t& url);
@@ -66,6 +83,24 @@ namespace crequests {
         void set_option(const verify_filename_t& verify_filename);
         void set_option(const certificate_file_t& certificate_file);
         void set_option(const private_key_file_t& private_key_file);
+        void set_option(const inline_io_t& inline_io);
+        void set_option(const cancel_token_t& cancel_token);
+        void set_option(const cancel_on_drop_t& cancel_on_drop);
+        void set_option(const deadline_t& deadline);
+        void set_option(const resolve_timeout_t& resolve_timeout);
+        void set_option(const connect_timeout_t& connect_timeout);
+        void set_option(const handshake_timeout_t& handshake_timeout);
+        void set_option(const first_byte_timeout_t& first_byte_timeout);
+        void set_option(const read_timeout_t& read_timeout);
+        void set_option(const total_timeout_t& total_timeout);
+        void set_option(const priority_t& priority);
+        void set_option(const read_quota_t& read_quota);
+        void set_option(const max_bandwidth_t& max_bandwidth);
+        void set_option(const hedge_delay_t& hedge_delay);
+        void set_option(const hedge_percentile_t& hedge_percentile);
+        void set_option(const retry_policy_t& retry_policy);
+        void set_option(const keep_redirect_responses_t& keep_redirect_responses);
+        void set_option(const coalesce_t& coalesce);
 
         void set_option(string_t&& url);
         void set_option(url_t&& url);
@@ -97,10 +132,32 @@ namespace crequests {
         void set_option(verify_filename_t&& verify_filename);
         void set_option(certificate_file_t&& certificate_file);
         void set_option(private_key_file_t&& private_key_file);
+        void set_option(inline_io_t&& inline_io);
+        void set_option(cancel_token_t&& cancel_token);
+        void set_option(cancel_on_drop_t&& cancel_on_drop);
+        void set_option(deadline_t&& deadline);
+        void set_option(resolve_timeout_t&& resolve_timeout);
+        void set_option(connect_timeout_t&& connect_timeout);
+        void set_option(handshake_timeout_t&& handshake_timeout);
+        void set_option(first_byte_timeout_t&& first_byte_timeout);
+        void set_option(read_timeout_t&& read_timeout);
+        void set_option(total_timeout_t&& total_timeout);
+        void set_option(priority_t&& priority);
+        void set_option(read_quota_t&& read_quota);
+        void set_option(max_bandwidth_t&& max_bandwidth);
+        void set_option(hedge_delay_t&& hedge_delay);
+        void set_option(hedge_percentile_t&& hedge_percentile);
+        void set_option(retry_policy_t&& retry_policy);
+        void set_option(keep_redirect_responses_t&& keep_redirect_responses);
+        void set_option(coalesce_t&& coalesce);
 
         bool is_expired() const;
         void skip_redirects(const response_t& response);
 
+    private:
+        void start_connection(const ioservice_ptr_t& ioservice,
+                              const completion_handler_t& completion);
+
     private:
         service_t& service;
         request_t request {};
@@ -248,6 +305,78 @@ namespace crequests {
         request.private_key_file(private_key_file);
     }
 
+    void session_impl_t::set_option(const inline_io_t& inline_io) {
+        request.inline_io(inline_io);
+    }
+
+    void session_impl_t::set_option(const cancel_token_t& cancel_token) {
+        request.cancel_token(cancel_token);
+    }
+
+    void session_impl_t::set_option(const cancel_on_drop_t& cancel_on_drop) {
+        request.cancel_on_drop(cancel_on_drop);
+    }
+
+    void session_impl_t::set_option(const deadline_t& deadline) {
+        request.deadline(deadline);
+    }
+
+    void session_impl_t::set_option(const resolve_timeout_t& resolve_timeout) {
+        request.resolve_timeout(resolve_timeout);
+    }
+
+    void session_impl_t::set_option(const connect_timeout_t& connect_timeout) {
+        request.connect_timeout(connect_timeout);
+    }
+
+    void session_impl_t::set_option(const handshake_timeout_t& handshake_timeout) {
+        request.handshake_timeout(handshake_timeout);
+    }
+
+    void session_impl_t::set_option(const first_byte_timeout_t& first_byte_timeout) {
+        request.first_byte_timeout(first_byte_timeout);
+    }
+
+    void session_impl_t::set_option(const read_timeout_t& read_timeout) {
+        request.read_timeout(read_timeout);
+    }
+
+    void session_impl_t::set_option(const total_timeout_t& total_timeout) {
+        request.total_timeout(total_timeout);
+    }
+
+    void session_impl_t::set_option(const priority_t& priority) {
+        request.priority(priority);
+    }
+
+    void session_impl_t::set_option(const read_quota_t& read_quota) {
+        request.read_quota(read_quota);
+    }
+
+    void session_impl_t::set_option(const max_bandwidth_t& max_bandwidth) {
+        request.max_bandwidth(max_bandwidth);
+    }
+
+    void session_impl_t::set_option(const hedge_delay_t& hedge_delay) {
+        request.hedge_delay(hedge_delay);
+    }
+
+    void session_impl_t::set_option(const hedge_percentile_t& hedge_percentile) {
+        request.hedge_percentile(hedge_percentile);
+    }
+
+    void session_impl_t::set_option(const retry_policy_t& retry_policy) {
+        request.retry_policy(retry_policy);
+    }
+
+    void session_impl_t::set_option(const keep_redirect_responses_t& keep_redirect_responses) {
+        request.keep_redirect_responses(keep_redirect_responses);
+    }
+
+    void session_impl_t::set_option(const coalesce_t& coalesce) {
+        request.coalesce(coalesce);
+    }
+
 
     /****************************************************************************
      * Set. Rvalue reference.
@@ -374,6 +503,78 @@ namespace crequests {
         request.private_key_file(std::move(private_key_file));
     }
 
+    void session_impl_t::set_option(inline_io_t&& inline_io) {
+        request.inline_io(std::move(inline_io));
+    }
+
+    void session_impl_t::set_option(cancel_token_t&& cancel_token) {
+        request.cancel_token(std::move(cancel_token));
+    }
+
+    void session_impl_t::set_option(cancel_on_drop_t&& cancel_on_drop) {
+        request.cancel_on_drop(std::move(cancel_on_drop));
+    }
+
+    void session_impl_t::set_option(deadline_t&& deadline) {
+        request.deadline(std::move(deadline));
+    }
+
+    void session_impl_t::set_option(resolve_timeout_t&& resolve_timeout) {
+        request.resolve_timeout(std::move(resolve_timeout));
+    }
+
+    void session_impl_t::set_option(connect_timeout_t&& connect_timeout) {
+        request.connect_timeout(std::move(connect_timeout));
+    }
+
+    void session_impl_t::set_option(handshake_timeout_t&& handshake_timeout) {
+        request.handshake_timeout(std::move(handshake_timeout));
+    }
+
+    void session_impl_t::set_option(first_byte_timeout_t&& first_byte_timeout) {
+        request.first_byte_timeout(std::move(first_byte_timeout));
+    }
+
+    void session_impl_t::set_option(read_timeout_t&& read_timeout) {
+        request.read_timeout(std::move(read_timeout));
+    }
+
+    void session_impl_t::set_option(total_timeout_t&& total_timeout) {
+        request.total_timeout(std::move(total_timeout));
+    }
+
+    void session_impl_t::set_option(priority_t&& priority) {
+        request.priority(std::move(priority));
+    }
+
+    void session_impl_t::set_option(read_quota_t&& read_quota) {
+        request.read_quota(std::move(read_quota));
+    }
+
+    void session_impl_t::set_option(max_bandwidth_t&& max_bandwidth) {
+        request.max_bandwidth(std::move(max_bandwidth));
+    }
+
+    void session_impl_t::set_option(hedge_delay_t&& hedge_delay) {
+        request.hedge_delay(std::move(hedge_delay));
+    }
+
+    void session_impl_t::set_option(hedge_percentile_t&& hedge_percentile) {
+        request.hedge_percentile(std::move(hedge_percentile));
+    }
+
+    void session_impl_t::set_option(retry_policy_t&& retry_policy) {
+        request.retry_policy(std::move(retry_policy));
+    }
+
+    void session_impl_t::set_option(keep_redirect_responses_t&& keep_redirect_responses) {
+        request.keep_redirect_responses(std::move(keep_redirect_responses));
+    }
+
+    void session_impl_t::set_option(coalesce_t&& coalesce) {
+        request.coalesce(std::move(coalesce));
+    }
+
 
     /****************************************************************************
      * Other functions.
@@ -381,37 +582,118 @@ namespace crequests {
 
 
     asyncresponse_t session_impl_t::Send() {
-        if (connection and request.cache_redirects())
+        start_connection(nullptr, nullptr);
+
+        if (request.cancel_on_drop()) {
+            const auto started = *connection;
+            return asyncresponse_t{connection->get(), [started]() {
+                started.cancel();
+            }};
+        }
+
+        return asyncresponse_t{connection->get()};
+    }
+
+    void session_impl_t::Send(const completion_handler_t& completion) {
+        start_connection(nullptr, completion);
+    }
+
+    response_t session_impl_t::SendSync() {
+        if (not request.inline_io())
+            return Send().get();
+
+        /*
+          The calling thread drives the connection itself, so there is
+          no hop to the service thread and back. The connection may wait
+          for a limiter grant, a throttle delay or a coalesced flight,
+          which come from the service thread as handlers posted here, so
+          the io service is kept running until the response is ready.
+          The work left after that (closing or parking the socket) is
+          done before returning.
+        */
+        const auto& ioservice = thread_service();
+        start_connection(ioservice, nullptr);
+        ioservice->reset();
+
+        const auto future = connection->get();
+        {
+            const work_t work{*ioservice};
+            while (future.wait_for(milliseconds_t{0}) != std::future_status::ready)
+                ioservice->run_one();
+        }
+        ioservice->run();
+
+        return future.get();
+    }
+
+    future_t<size_t> session_impl_t::preconnect(const size_t count) {
+        return service.preconnect(request, count);
+    }
+
+    void session_impl_t::start_connection(const ioservice_ptr_t& ioservice,
+                                          const completion_handler_t& completion) {
+        /*
+          A detached connection has no future response, so there is
+          nothing to take redirects or cookies from. Its socket is handed
+          over only when it is already done, since there is no response
+          to wait for.
+        */
+        const bool has_previous = connection and not connection->is_detached();
+
+        if (has_previous and request.cache_redirects())
             skip_redirects(connection->get().get());
         else
             request.prepare();
 
-        if (not connection or
-            not can_reuse_connection(request, connection->get().get().request()))
+        /*
+          A socket can be reused only by the io service it was opened on.
+        */
+        const bool same_service =
+            connection and
+            &connection->get_service() ==
+                (ioservice ? ioservice.get() : &service.get_service());
+
+        bool reuse = false;
+        if (same_service and has_previous)
+            reuse = can_reuse_connection(request, connection->get().get().request());
+        else if (same_service)
+            reuse = connection->can_hand_over(request);
+
+        connection_t* next = nullptr;
+
+        if (not reuse)
         {
-            connection = new connection_t(service, request);
+            if (ioservice)
+                next = new connection_t(service, ioservice, request, completion);
+            else
+                next = new connection_t(service, request, completion);
         }
         else
         {
-            auto cookies = request.cookies();
-            cookies.update(connection->get().get().cookies());
-            request.cookies(cookies);
-            connection = new connection_t(service, request, *connection);
+            if (has_previous) {
+                auto cookies = request.cookies();
+                cookies.update(connection->get().get().cookies());
+                request.cookies(cookies);
+            }
+            next = new connection_t(service, request, *connection, completion);
         }
 
-        connection->start();
+        /*
+          The previous handle is released, otherwise the connection
+          and its socket would live as long as the process.
+        */
+        if (connection)
+            delete connection;
+        connection = next;
 
-        return asyncresponse_t{connection->get()};
+        connection->start();
     }
 
     void session_impl_t::skip_redirects(const response_t& response) {
-        const auto resp = response.redirects().find(request);
-        if (resp) {
-            request.uri(resp->request().uri());
-            request.auth(resp->request().auth());
-            request.cookies(resp->request().cookies());
-            request.prepare();
-        }
+        const auto location = response.redirects().find(request);
+        if (location)
+            request.uri(uri_t::from_string(*location));
+        request.prepare();
     }
 
     bool session_impl_t::is_expired() const {
@@ -590,6 +872,78 @@ namespace crequests {
         pimpl->set_option(private_key_file);
     }
 
+    void session_t::set_option(const inline_io_t& inline_io) {
+        pimpl->set_option(inline_io);
+    }
+
+    void session_t::set_option(const cancel_token_t& cancel_token) {
+        pimpl->set_option(cancel_token);
+    }
+
+    void session_t::set_option(const cancel_on_drop_t& cancel_on_drop) {
+        pimpl->set_option(cancel_on_drop);
+    }
+
+    void session_t::set_option(const deadline_t& deadline) {
+        pimpl->set_option(deadline);
+    }
+
+    void session_t::set_option(const resolve_timeout_t& resolve_timeout) {
+        pimpl->set_option(resolve_timeout);
+    }
+
+    void session_t::set_option(const connect_timeout_t& connect_timeout) {
+        pimpl->set_option(connect_timeout);
+    }
+
+    void session_t::set_option(const handshake_timeout_t& handshake_timeout) {
+        pimpl->set_option(handshake_timeout);
+    }
+
+    void session_t::set_option(const first_byte_timeout_t& first_byte_timeout) {
+        pimpl->set_option(first_byte_timeout);
+    }
+
+    void session_t::set_option(const read_timeout_t& read_timeout) {
+        pimpl->set_option(read_timeout);
+    }
+
+    void session_t::set_option(const total_timeout_t& total_timeout) {
+        pimpl->set_option(total_timeout);
+    }
+
+    void session_t::set_option(const priority_t& priority) {
+        pimpl->set_option(priority);
+    }
+
+    void session_t::set_option(const read_quota_t& read_quota) {
+        pimpl->set_option(read_quota);
+    }
+
+    void session_t::set_option(const max_bandwidth_t& max_bandwidth) {
+        pimpl->set_option(max_bandwidth);
+    }
+
+    void session_t::set_option(const hedge_delay_t& hedge_delay) {
+        pimpl->set_option(hedge_delay);
+    }
+
+    void session_t::set_option(const hedge_percentile_t& hedge_percentile) {
+        pimpl->set_option(hedge_percentile);
+    }
+
+    void session_t::set_option(const retry_policy_t& retry_policy) {
+        pimpl->set_option(retry_policy);
+    }
+
+    void session_t::set_option(const keep_redirect_responses_t& keep_redirect_responses) {
+        pimpl->set_option(keep_redirect_responses);
+    }
+
+    void session_t::set_option(const coalesce_t& coalesce) {
+        pimpl->set_option(coalesce);
+    }
+
 
     /****************************************************************************
      * Set. Rvalue reference.
@@ -716,6 +1070,78 @@ namespace crequests {
         pimpl->set_option(std::move(private_key_file));
     }
 
+    void session_t::set_option(inline_io_t&& inline_io) {
+        pimpl->set_option(std::move(inline_io));
+    }
+
+    void session_t::set_option(cancel_token_t&& cancel_token) {
+        pimpl->set_option(std::move(cancel_token));
+    }
+
+    void session_t::set_option(cancel_on_drop_t&& cancel_on_drop) {
+        pimpl->set_option(std::move(cancel_on_drop));
+    }
+
+    void session_t::set_option(deadline_t&& deadline) {
+        pimpl->set_option(std::move(deadline));
+    }
+
+    void session_t::set_option(resolve_timeout_t&& resolve_timeout) {
+        pimpl->set_option(std::move(resolve_timeout));
+    }
+
+    void session_t::set_option(connect_timeout_t&& connect_timeout) {
+        pimpl->set_option(std::move(connect_timeout));
+    }
+
+    void session_t::set_option(handshake_timeout_t&& handshake_timeout) {
+        pimpl->set_option(std::move(handshake_timeout));
+    }
+
+    void session_t::set_option(first_byte_timeout_t&& first_byte_timeout) {
+        pimpl->set_option(std::move(first_byte_timeout));
+    }
+
+    void session_t::set_option(read_timeout_t&& read_timeout) {
+        pimpl->set_option(std::move(read_timeout));
+    }
+
+    void session_t::set_option(total_timeout_t&& total_timeout) {
+        pimpl->set_option(std::move(total_timeout));
+    }
+
+    void session_t::set_option(priority_t&& priority) {
+        pimpl->set_option(std::move(priority));
+    }
+
+    void session_t::set_option(read_quota_t&& read_quota) {
+        pimpl->set_option(std::move(read_quota));
+    }
+
+    void session_t::set_option(max_bandwidth_t&& max_bandwidth) {
+        pimpl->set_option(std::move(max_bandwidth));
+    }
+
+    void session_t::set_option(hedge_delay_t&& hedge_delay) {
+        pimpl->set_option(std::move(hedge_delay));
+    }
+
+    void session_t::set_option(hedge_percentile_t&& hedge_percentile) {
+        pimpl->set_option(std::move(hedge_percentile));
+    }
+
+    void session_t::set_option(retry_policy_t&& retry_policy) {
+        pimpl->set_option(std::move(retry_policy));
+    }
+
+    void session_t::set_option(keep_redirect_responses_t&& keep_redirect_responses) {
+        pimpl->set_option(std::move(keep_redirect_responses));
+    }
+
+    void session_t::set_option(coalesce_t&& coalesce) {
+        pimpl->set_option(std::move(coalesce));
+    }
+
 
     /****************************************************************************
      * Http methods.
@@ -756,6 +1182,78 @@ namespace crequests {
         return pimpl->Send();
     }
 
+    void session_t::AsyncGet(const completion_queue_t& queue, const tag_t& tag) const {
+        pimpl->set_option(method_t {"GET"});
+        AsyncSend(queue, tag);
+    }
+
+    void session_t::AsyncPost(const completion_queue_t& queue, const tag_t& tag) const {
+        pimpl->set_option(method_t {"POST"});
+        AsyncSend(queue, tag);
+    }
+
+    void session_t::AsyncPut(const completion_queue_t& queue, const tag_t& tag) const {
+        pimpl->set_option(method_t {"PUT"});
+        AsyncSend(queue, tag);
+    }
+
+    void session_t::AsyncPatch(const completion_queue_t& queue, const tag_t& tag) const {
+        pimpl->set_option(method_t {"PATCH"});
+        AsyncSend(queue, tag);
+    }
+
+    void session_t::AsyncDelete(const completion_queue_t& queue, const tag_t& tag) const {
+        pimpl->set_option(method_t {"DELETE"});
+        AsyncSend(queue, tag);
+    }
+
+    void session_t::AsyncHead(const completion_queue_t& queue, const tag_t& tag) const {
+        pimpl->set_option(method_t {"HEAD"});
+        AsyncSend(queue, tag);
+    }
+
+    void session_t::AsyncSend(const completion_queue_t& queue, const tag_t& tag) const {
+        pimpl->Send(queue.bind(tag));
+    }
+
+    void session_t::AsyncGet(const completion_handler_t& completion) const {
+        pimpl->set_option(method_t {"GET"});
+        AsyncSend(completion);
+    }
+
+    void session_t::AsyncPost(const completion_handler_t& completion) const {
+        pimpl->set_option(method_t {"POST"});
+        AsyncSend(completion);
+    }
+
+    void session_t::AsyncPut(const completion_handler_t& completion) const {
+        pimpl->set_option(method_t {"PUT"});
+        AsyncSend(completion);
+    }
+
+    void session_t::AsyncPatch(const completion_handler_t& completion) const {
+        pimpl->set_option(method_t {"PATCH"});
+        AsyncSend(completion);
+    }
+
+    void session_t::AsyncDelete(const completion_handler_t& completion) const {
+        pimpl->set_option(method_t {"DELETE"});
+        AsyncSend(completion);
+    }
+
+    void session_t::AsyncHead(const completion_handler_t& completion) const {
+        pimpl->set_option(method_t {"HEAD"});
+        AsyncSend(completion);
+    }
+
+    void session_t::AsyncSend(const completion_handler_t& completion) const {
+        pimpl->Send(completion);
+    }
+
+    future_t<size_t> session_t::preconnect(const size_t count) const {
+        return pimpl->preconnect(count);
+    }
+
     response_t session_t::Get() const {
         pimpl->set_option(method_t {"GET"});
         return Send();
@@ -787,7 +1285,7 @@ namespace crequests {
     }
 
     response_t session_t::Send() const {
-        return pimpl->Send().get();
+        return pimpl->SendSync();
     }
 
 
@@ -3,6 +3,7 @@
 
 #include "asyncresponse.h"
 #include "auth.h"
+#include "completion_queue.h"
 #include "request.h"
 #include "response.h"
 #include "utils.h"
@@ -27,6 +28,30 @@ namespace crequests {
         asyncresponse_t AsyncHead() const;
         asyncresponse_t AsyncSend() const;
 
+        /*
+          These functions deliver the response with the given tag into
+          the completion queue instead of a future.
+        */
+        void AsyncGet(const completion_queue_t& queue, const tag_t& tag) const;
+        void AsyncPost(const completion_queue_t& queue, const tag_t& tag) const;
+        void AsyncPut(const completion_queue_t& queue, const tag_t& tag) const;
+        void AsyncPatch(const completion_queue_t& queue, const tag_t& tag) const;
+        void AsyncDelete(const completion_queue_t& queue, const tag_t& tag) const;
+        void AsyncHead(const completion_queue_t& queue, const tag_t& tag) const;
+        void AsyncSend(const completion_queue_t& queue, const tag_t& tag) const;
+
+        /*
+          Fire and forget versions. The response is moved into the completion
+          handler on the service thread and no future is ever allocated.
+        */
+        void AsyncGet(const completion_handler_t& completion) const;
+        void AsyncPost(const completion_handler_t& completion) const;
+        void AsyncPut(const completion_handler_t& completion) const;
+        void AsyncPatch(const completion_handler_t& completion) const;
+        void AsyncDelete(const completion_handler_t& completion) const;
+        void AsyncHead(const completion_handler_t& completion) const;
+        void AsyncSend(const completion_handler_t& completion) const;
+
         response_t Get() const;
         response_t Post() const;
         response_t Put() const;
@@ -35,6 +60,12 @@ namespace crequests {
         response_t Head() const;
         response_t Send() const;
 
+        /*
+          Sets up connections to the origin of the session ahead of its
+          requests (see service_t::preconnect()).
+        */
+        future_t<size_t> preconnect(const size_t count) const;
+
         void set_option(const string_t& url);
         void set_option(const url_t& url);
         void set_option(const protocol_t& protocol);
@@ -65,6 +96,24 @@ namespace crequests {
         void set_option(const verify_filename_t& verify_filename);
         void set_option(const certificate_file_t& certificate_file);
         void set_option(const private_key_file_t& private_key_file);
+        void set_option(const inline_io_t& inline_io);
+        void set_option(const cancel_token_t& cancel_token);
+        void set_option(const cancel_on_drop_t& cancel_on_drop);
+        void set_option(const deadline_t& deadline);
+        void set_option(const resolve_timeout_t& resolve_timeout);
+        void set_option(const connect_timeout_t& connect_timeout);
+        void set_option(const handshake_timeout_t& handshake_timeout);
+        void set_option(const first_byte_timeout_t& first_byte_timeout);
+        void set_option(const read_timeout_t& read_timeout);
+        void set_option(const total_timeout_t& total_timeout);
+        void set_option(const priority_t& priority);
+        void set_option(const read_quota_t& read_quota);
+        void set_option(const max_bandwidth_t& max_bandwidth);
+        void set_option(const hedge_delay_t& hedge_delay);
+        void set_option(const hedge_percentile_t& hedge_percentile);
+        void set_option(const retry_policy_t& retry_policy);
+        void set_option(const keep_redirect_responses_t& keep_redirect_responses);
+        void set_option(const coalesce_t& coalesce);
 
         void set_option(string_t&& url);
         void set_option(url_t&& url);
@@ -96,6 +145,24 @@ namespace crequests {
         void set_option(verify_filename_t&& verify_filename);
         void set_option(certificate_file_t&& certificate_file);
         void set_option(private_key_file_t&& private_key_file);
+        void set_option(inline_io_t&& inline_io);
+        void set_option(cancel_token_t&& cancel_token);
+        void set_option(cancel_on_drop_t&& cancel_on_drop);
+        void set_option(deadline_t&& deadline);
+        void set_option(resolve_timeout_t&& resolve_timeout);
+        void set_option(connect_timeout_t&& connect_timeout);
+        void set_option(handshake_timeout_t&& handshake_timeout);
+        void set_option(first_byte_timeout_t&& first_byte_timeout);
+        void set_option(read_timeout_t&& read_timeout);
+        void set_option(total_timeout_t&& total_timeout);
+        void set_option(priority_t&& priority);
+        void set_option(read_quota_t&& read_quota);
+        void set_option(max_bandwidth_t&& max_bandwidth);
+        void set_option(hedge_delay_t&& hedge_delay);
+        void set_option(hedge_percentile_t&& hedge_percentile);
+        void set_option(retry_policy_t&& retry_policy);
+        void set_option(keep_redirect_responses_t&& keep_redirect_responses);
+        void set_option(coalesce_t&& coalesce);
 
         bool is_expired() const;
 
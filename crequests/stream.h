@@ -189,6 +189,26 @@ namespace crequests {
         stream_t(const stream_t& stream) = default;
         stream_t& operator = (const stream_t& stream) = default;
 
+        /*
+          The sockets are handed over, so the moved from stream does not
+          close them when it is destroyed.
+        */
+        stream_t& operator = (stream_t&& stream) {
+            if (this != &stream) {
+                close();
+                ssl_socket = stream.ssl_socket;
+                tcp_socket = stream.tcp_socket;
+                type = stream.type;
+                cert = stream.cert;
+                key = stream.key;
+                certs = stream.certs;
+                stream.ssl_socket = nullptr;
+                stream.tcp_socket = nullptr;
+            }
+
+            return *this;
+        }
+
         ~stream_t() {
             close();
         }
@@ -311,6 +331,34 @@ namespace crequests {
             return option.value();
         }
 
+        /*
+          Checks without blocking that an idle socket is still usable:
+          it is not closed by the peer and has no data nobody asked for
+          (an alert or a late response).
+        */
+        bool is_alive() {
+            tcp_socket_t* socket = nullptr;
+            if (tcp_socket and tcp_socket->is_open())
+                socket = tcp_socket.get();
+            else if (ssl_socket and ssl_socket->lowest_layer().is_open())
+                socket = &ssl_socket->next_layer();
+            else
+                return false;
+
+            char byte = 0;
+            ec_t ec;
+            socket->non_blocking(true, ec);
+            if (ec)
+                return false;
+            socket->receive(boost::asio::buffer(&byte, 1),
+                            tcp_socket_t::message_peek,
+                            ec);
+            ec_t ignored;
+            socket->non_blocking(false, ignored);
+
+            return ec == boost::asio::error::would_block;
+        }
+
         bool is_open() {
             if (tcp_socket and tcp_socket->is_open())
                 return true;
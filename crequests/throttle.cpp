@@ -0,0 +1,195 @@
+#include "throttle.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+
+namespace crequests {
+
+
+    namespace {
+
+        /*
+          Idle buckets of hosts are dropped when there are more of them.
+        */
+        const size_t MAX_IDLE_HOSTS = 256;
+
+    } /* anonymous namespace */
+
+
+    /************************************************************
+     * token_bucket_t section.
+     ************************************************************/
+
+
+    token_bucket_t::token_bucket_t()
+        : token_bucket_t(0)
+    {
+
+    }
+
+    token_bucket_t::token_bucket_t(const size_t rate_)
+        : m_rate(static_cast<double>(rate_)),
+          tokens(m_rate),
+          last(steady_clock_t::now())
+    {
+
+    }
+
+    void token_bucket_t::rate(const size_t rate_) {
+        m_rate = static_cast<double>(rate_);
+        tokens = std::min(tokens, m_rate);
+    }
+
+    size_t token_bucket_t::rate() const {
+        return static_cast<size_t>(m_rate);
+    }
+
+    milliseconds_t token_bucket_t::consume(const size_t bytes, const time_point_t& now) {
+        if (m_rate <= 0)
+            return milliseconds_t(0);
+
+        const auto elapsed = std::chrono::duration<double>(now - last).count();
+        if (elapsed > 0) {
+            tokens = std::min(m_rate, tokens + elapsed * m_rate);
+            last = now;
+        }
+
+        tokens -= static_cast<double>(bytes);
+        if (tokens >= 0)
+            return milliseconds_t(0);
+
+        return milliseconds_t(static_cast<milliseconds_t::rep>(
+            std::ceil(-tokens * 1000 / m_rate)));
+    }
+
+    bool token_bucket_t::idle(const time_point_t& now) const {
+        const auto elapsed = std::chrono::duration<double>(now - last).count();
+        return tokens + elapsed * m_rate >= m_rate;
+    }
+
+
+    /************************************************************
+     * throttle_impl_t section.
+     ************************************************************/
+
+
+    class throttle_impl_t {
+    public:
+        void read_quota(const size_t value);
+        void host_bandwidth(const size_t value);
+        void service_bandwidth(const size_t value);
+        size_t read_quota() const;
+        bool enabled() const;
+        milliseconds_t consume(const string_t& host, const size_t bytes);
+
+    private:
+        void update_enabled();
+
+    private:
+        mutable std::mutex mutex {};
+        std::atomic<size_t> m_read_quota {0};
+        std::atomic<bool> m_enabled {false};
+        size_t m_host_bandwidth {0};
+        token_bucket_t service_bucket {};
+        std::unordered_map<string_t, token_bucket_t> hosts {};
+    };
+
+    void throttle_impl_t::read_quota(const size_t value) {
+        m_read_quota = value;
+    }
+
+    void throttle_impl_t::host_bandwidth(const size_t value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        m_host_bandwidth = value;
+        for (auto& host : hosts)
+            host.second.rate(value);
+        update_enabled();
+    }
+
+    void throttle_impl_t::service_bandwidth(const size_t value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        service_bucket.rate(value);
+        update_enabled();
+    }
+
+    void throttle_impl_t::update_enabled() {
+        m_enabled = m_host_bandwidth > 0 or service_bucket.rate() > 0;
+    }
+
+    size_t throttle_impl_t::read_quota() const {
+        return m_read_quota;
+    }
+
+    bool throttle_impl_t::enabled() const {
+        return m_enabled;
+    }
+
+    milliseconds_t throttle_impl_t::consume(const string_t& host, const size_t bytes) {
+        const auto now = steady_clock_t::now();
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto delay = service_bucket.consume(bytes, now);
+        if (m_host_bandwidth == 0)
+            return delay;
+
+        if (hosts.size() > MAX_IDLE_HOSTS) {
+            for (auto it = hosts.begin(); it != hosts.end(); ) {
+                if (it->second.idle(now))
+                    it = hosts.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        auto it = hosts.find(host);
+        if (it == hosts.end())
+            it = hosts.emplace(host, token_bucket_t{m_host_bandwidth}).first;
+
+        return std::max(delay, it->second.consume(bytes, now));
+    }
+
+
+    /************************************************************
+     * throttle_t section.
+     ************************************************************/
+
+
+    throttle_t::throttle_t()
+        : pimpl{std::make_shared<throttle_impl_t>()}
+    {
+
+    }
+
+    throttle_t::~throttle_t() {
+
+    }
+
+    void throttle_t::set_option(const read_quota_t& read_quota) {
+        pimpl->read_quota(read_quota.value());
+    }
+
+    void throttle_t::set_option(const host_bandwidth_t& host_bandwidth) {
+        pimpl->host_bandwidth(host_bandwidth.value());
+    }
+
+    void throttle_t::set_option(const service_bandwidth_t& service_bandwidth) {
+        pimpl->service_bandwidth(service_bandwidth.value());
+    }
+
+    size_t throttle_t::read_quota() const {
+        return pimpl->read_quota();
+    }
+
+    bool throttle_t::enabled() const {
+        return pimpl->enabled();
+    }
+
+    milliseconds_t throttle_t::consume(const string_t& host, const size_t bytes) {
+        return pimpl->consume(host, bytes);
+    }
+
+
+} /* namespace crequests */
@@ -0,0 +1,84 @@
+#ifndef THROTTLE_H
+#define THROTTLE_H
+
+#include "macros.h"
+#include "request.h"
+#include "types.h"
+
+namespace crequests {
+
+
+    /*
+      Service options of the bandwidth shaping in bytes per second:
+      for every host and for the whole service. 0 means no limit.
+    */
+    declare_number(host_bandwidth, size_t)
+    declare_number(service_bandwidth, size_t)
+
+
+    /*
+      Token bucket which refills at the given rate and holds up to one
+      second of it. Consuming more than it holds puts it in debt, and
+      the returned time is how long the consumer should wait to repay it.
+      A rate of 0 means no limit. Not thread safe.
+    */
+    class token_bucket_t {
+    public:
+        token_bucket_t();
+        explicit token_bucket_t(const size_t rate);
+
+    public:
+        void rate(const size_t rate);
+        size_t rate() const;
+        milliseconds_t consume(const size_t bytes, const time_point_t& now);
+
+        /*
+          Returns true if the bucket is full, so it can be dropped.
+        */
+        bool idle(const time_point_t& now) const;
+
+    private:
+        double m_rate;
+        double tokens;
+        time_point_t last;
+    };
+
+
+    /*
+      Read quota and bandwidth limits shared by all connections of
+      a service. Can be used from any thread.
+    */
+    class throttle_t {
+    public:
+        throttle_t();
+        throttle_t(const throttle_t& throttle) = delete;
+        throttle_t& operator=(const throttle_t& throttle) = delete;
+        ~throttle_t();
+
+    public:
+        void set_option(const read_quota_t& read_quota);
+        void set_option(const host_bandwidth_t& host_bandwidth);
+        void set_option(const service_bandwidth_t& service_bandwidth);
+
+        size_t read_quota() const;
+
+        /*
+          Returns false when no bandwidth limit is set for the service.
+        */
+        bool enabled() const;
+
+        /*
+          Counts the bytes read from the host and returns how long the
+          connection should wait before the next read.
+        */
+        milliseconds_t consume(const string_t& host, const size_t bytes);
+
+    private:
+        friend class throttle_impl_t;
+        shared_ptr_t<class throttle_impl_t> pimpl;
+    };
+
+
+} /* namespace crequests */
+
+#endif /* THROTTLE_H */
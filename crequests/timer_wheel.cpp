@@ -0,0 +1,419 @@
+#include "boost_asio.h"
+#include "timer_wheel.h"
+
+#include <limits>
+#include <mutex>
+
+namespace crequests {
+
+
+    namespace {
+
+        /*
+          Four levels of 64 slots cover 2^24 ms (about 4.6 hours)
+          ahead, farther timers wait in the overflow list.
+        */
+        const size_t LEVEL_BITS = 6;
+        const size_t SLOTS = 64;
+        const size_t LEVELS = 4;
+        const size_t WHEEL_BITS = LEVEL_BITS * LEVELS;
+        const size_t OVERFLOW_SLOT = LEVELS * SLOTS;
+
+        const std::uint32_t NIL = std::numeric_limits<std::uint32_t>::max();
+        const std::uint64_t NEVER = std::numeric_limits<std::uint64_t>::max();
+
+        size_t lowest_bit(const std::uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<size_t>(__builtin_ctzll(mask));
+#else
+            size_t n = 0;
+            while (not (mask & (std::uint64_t{1} << n)))
+                n++;
+            return n;
+#endif
+        }
+
+        size_t highest_bit(const std::uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+            return static_cast<size_t>(63 - __builtin_clzll(mask));
+#else
+            size_t n = 63;
+            while (not (mask & (std::uint64_t{1} << n)))
+                n--;
+            return n;
+#endif
+        }
+
+        std::uint64_t low_mask(const size_t bits) {
+            return (std::uint64_t{1} << bits) - 1;
+        }
+
+    } /* anonymous namespace */
+
+
+    /************************************************************
+     * timer_wheel_impl_t section.
+     ************************************************************/
+
+
+    class timer_wheel_impl_t
+        : public std::enable_shared_from_this<timer_wheel_impl_t> {
+    public:
+        explicit timer_wheel_impl_t(ioservice_t& ioservice);
+
+    public:
+        timer_id_t schedule(const time_point_t& when,
+                            timer_wheel_t::callback_t&& callback);
+        bool cancel(const timer_id_t id);
+        size_t size() const;
+
+    private:
+        struct node_t {
+            std::uint64_t expiry {0};
+            std::uint32_t generation {0};
+            std::uint32_t prev {NIL};
+            std::uint32_t next {NIL};
+            std::uint32_t slot {NIL};
+            timer_wheel_t::callback_t callback {};
+        };
+
+        using callbacks_t = vector_t<timer_wheel_t::callback_t>;
+
+    private:
+        std::uint64_t to_tick(const time_point_t& when) const;
+        std::uint64_t now_tick() const;
+        std::uint32_t allocate();
+        void release(const std::uint32_t index);
+        void link(const std::uint32_t index, const size_t slot);
+        void unlink(const std::uint32_t index);
+        void place(const std::uint32_t index, callbacks_t& fired);
+        void cascade(const size_t slot, callbacks_t& fired);
+        std::uint64_t next_event() const;
+        void advance(const std::uint64_t now, callbacks_t& fired);
+        void post_reschedule();
+        void reschedule();
+        void on_timer(const ec_t& ec);
+
+    private:
+        mutable std::mutex mutex {};
+        strand_t strand;
+        timer__t timer;
+        const time_point_t epoch;
+        std::uint64_t current {0};
+        std::uint64_t wake_tick {NEVER};
+        vector_t<node_t> nodes {};
+        std::uint32_t free_head {NIL};
+        vector_t<std::uint32_t> heads;
+        std::uint64_t occupied[LEVELS];
+        size_t count {0};
+    };
+
+    timer_wheel_impl_t::timer_wheel_impl_t(ioservice_t& ioservice)
+        : strand(ioservice),
+          timer(ioservice),
+          epoch(steady_clock_t::now()),
+          heads(OVERFLOW_SLOT + 1, NIL),
+          occupied()
+    {
+
+    }
+
+    std::uint64_t timer_wheel_impl_t::to_tick(const time_point_t& when) const {
+        if (when <= epoch)
+            return 0;
+
+        const auto elapsed = when - epoch;
+        const auto ms = std::chrono::duration_cast<milliseconds_t>(elapsed);
+        return static_cast<std::uint64_t>(ms.count()) + (ms < elapsed ? 1 : 0);
+    }
+
+    std::uint64_t timer_wheel_impl_t::now_tick() const {
+        const auto elapsed = steady_clock_t::now() - epoch;
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<milliseconds_t>(elapsed).count());
+    }
+
+    std::uint32_t timer_wheel_impl_t::allocate() {
+        if (free_head == NIL) {
+            nodes.emplace_back();
+            return static_cast<std::uint32_t>(nodes.size() - 1);
+        }
+
+        const auto index = free_head;
+        free_head = nodes[index].next;
+        nodes[index].next = NIL;
+        return index;
+    }
+
+    void timer_wheel_impl_t::release(const std::uint32_t index) {
+        auto& node = nodes[index];
+        node.generation++;
+        node.slot = NIL;
+        node.prev = NIL;
+        node.next = free_head;
+        free_head = index;
+    }
+
+    void timer_wheel_impl_t::link(const std::uint32_t index, const size_t slot) {
+        auto& node = nodes[index];
+        node.slot = static_cast<std::uint32_t>(slot);
+        node.prev = NIL;
+        node.next = heads[slot];
+        if (node.next != NIL)
+            nodes[node.next].prev = index;
+        heads[slot] = index;
+
+        if (slot < OVERFLOW_SLOT)
+            occupied[slot / SLOTS] |= std::uint64_t{1} << (slot % SLOTS);
+    }
+
+    void timer_wheel_impl_t::unlink(const std::uint32_t index) {
+        auto& node = nodes[index];
+        const size_t slot = node.slot;
+
+        if (node.prev != NIL)
+            nodes[node.prev].next = node.next;
+        else
+            heads[slot] = node.next;
+        if (node.next != NIL)
+            nodes[node.next].prev = node.prev;
+
+        node.slot = NIL;
+        node.prev = NIL;
+        node.next = NIL;
+
+        if (slot < OVERFLOW_SLOT and heads[slot] == NIL)
+            occupied[slot / SLOTS] &= ~(std::uint64_t{1} << (slot % SLOTS));
+    }
+
+    /*
+      A timer is put on the level of the highest bit in which its expiry
+      differs from the current tick. So every timer of a level has the same
+      higher bits as the current tick and a greater digit of its own level.
+    */
+    void timer_wheel_impl_t::place(const std::uint32_t index, callbacks_t& fired) {
+        auto& node = nodes[index];
+        if (node.expiry <= current) {
+            fired.push_back(std::move(node.callback));
+            node.callback = nullptr;
+            release(index);
+            count--;
+            return;
+        }
+
+        const size_t level = highest_bit(node.expiry ^ current) / LEVEL_BITS;
+        if (level >= LEVELS) {
+            link(index, OVERFLOW_SLOT);
+            return;
+        }
+
+        const size_t digit = (node.expiry >> (level * LEVEL_BITS)) & (SLOTS - 1);
+        link(index, level * SLOTS + digit);
+    }
+
+    void timer_wheel_impl_t::cascade(const size_t slot, callbacks_t& fired) {
+        auto index = heads[slot];
+        heads[slot] = NIL;
+        if (slot < OVERFLOW_SLOT)
+            occupied[slot / SLOTS] &= ~(std::uint64_t{1} << (slot % SLOTS));
+
+        while (index != NIL) {
+            const auto next = nodes[index].next;
+            nodes[index].slot = NIL;
+            nodes[index].prev = NIL;
+            nodes[index].next = NIL;
+            place(index, fired);
+            index = next;
+        }
+    }
+
+    /*
+      The nearest tick at which some slot has to be fired or cascaded.
+      Slots of a lower level always come before the ones of a higher level.
+    */
+    std::uint64_t timer_wheel_impl_t::next_event() const {
+        for (size_t level = 0; level < LEVELS; ++level) {
+            const size_t shift = level * LEVEL_BITS;
+            const size_t digit = (current >> shift) & (SLOTS - 1);
+            const auto above = digit == SLOTS - 1
+                ? 0
+                : occupied[level] & (~std::uint64_t{0} << (digit + 1));
+            if (not above)
+                continue;
+
+            const auto block = current & ~low_mask(shift + LEVEL_BITS);
+            return block | (static_cast<std::uint64_t>(lowest_bit(above)) << shift);
+        }
+
+        if (heads[OVERFLOW_SLOT] != NIL)
+            return (current | low_mask(WHEEL_BITS)) + 1;
+
+        return NEVER;
+    }
+
+    void timer_wheel_impl_t::advance(const std::uint64_t now, callbacks_t& fired) {
+        while (true) {
+            const auto tick = next_event();
+            if (tick > now) {
+                current = std::max(current, now);
+                return;
+            }
+
+            current = tick;
+
+            if ((tick & low_mask(WHEEL_BITS)) == 0)
+                cascade(OVERFLOW_SLOT, fired);
+
+            for (size_t level = LEVELS; level-- > 0; ) {
+                const size_t shift = level * LEVEL_BITS;
+                if (tick & low_mask(shift))
+                    continue;
+                cascade(level * SLOTS + ((tick >> shift) & (SLOTS - 1)), fired);
+            }
+        }
+    }
+
+    timer_id_t timer_wheel_impl_t::schedule(const time_point_t& when,
+                                            timer_wheel_t::callback_t&& callback) {
+        const auto expiry = to_tick(when);
+        timer_id_t id = 0;
+        bool wake = false;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto index = allocate();
+            auto& node = nodes[index];
+            node.expiry = std::max(expiry, current + 1);
+            node.callback = std::move(callback);
+            id = (static_cast<timer_id_t>(node.generation) << 32) | (index + 1);
+
+            callbacks_t fired;
+            place(index, fired);
+            count++;
+
+            if (node.expiry < wake_tick) {
+                wake_tick = node.expiry;
+                wake = true;
+            }
+        }
+
+        /*
+          The asio timer is rearmed only when the new timer is the nearest
+          one. A cancelled nearest timer just leads to an idle wake up.
+        */
+        if (wake)
+            post_reschedule();
+
+        return id;
+    }
+
+    bool timer_wheel_impl_t::cancel(const timer_id_t id) {
+        timer_wheel_t::callback_t callback;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const auto index = static_cast<std::uint32_t>((id & 0xffffffff) - 1);
+            const auto generation = static_cast<std::uint32_t>(id >> 32);
+            if (index >= nodes.size() or
+                nodes[index].generation != generation or
+                nodes[index].slot == NIL)
+                return false;
+
+            unlink(index);
+            callback = std::move(nodes[index].callback);
+            nodes[index].callback = nullptr;
+            release(index);
+            count--;
+        }
+
+        /*
+          The callback owns its connection, so it is destroyed out of
+          the lock in case the connection cancels its other timers.
+        */
+        return true;
+    }
+
+    size_t timer_wheel_impl_t::size() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return count;
+    }
+
+    void timer_wheel_impl_t::post_reschedule() {
+        const auto self = shared_from_this();
+        strand.post([self]() {
+            self->reschedule();
+        });
+    }
+
+    void timer_wheel_impl_t::reschedule() {
+        callbacks_t fired;
+        std::uint64_t tick = NEVER;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            advance(now_tick(), fired);
+            tick = next_event();
+            wake_tick = tick;
+        }
+
+        for (const auto& callback : fired)
+            callback();
+
+        if (tick == NEVER) {
+            timer.cancel();
+            return;
+        }
+
+        timer.expires_at(epoch + milliseconds_t(tick));
+        const auto self = shared_from_this();
+        timer.async_wait(strand.wrap([self](const ec_t& ec) {
+            self->on_timer(ec);
+        }));
+    }
+
+    void timer_wheel_impl_t::on_timer(const ec_t& ec) {
+        if (not ec)
+            reschedule();
+    }
+
+
+    /************************************************************
+     * timer_wheel_t section.
+     ************************************************************/
+
+
+    timer_wheel_t::timer_wheel_t(ioservice_t& ioservice)
+        : pimpl{std::make_shared<timer_wheel_impl_t>(ioservice)}
+    {
+
+    }
+
+    timer_wheel_t::~timer_wheel_t() {
+
+    }
+
+    timer_id_t timer_wheel_t::schedule(const time_point_t& when,
+                                       callback_t&& callback) {
+        return pimpl->schedule(when, std::move(callback));
+    }
+
+    timer_id_t timer_wheel_t::schedule(const milliseconds_t& after,
+                                       callback_t&& callback) {
+        return pimpl->schedule(steady_clock_t::now() + after, std::move(callback));
+    }
+
+    bool timer_wheel_t::cancel(timer_id_t& id) {
+        if (id == 0)
+            return false;
+
+        const bool cancelled = pimpl->cancel(id);
+        id = 0;
+        return cancelled;
+    }
+
+    size_t timer_wheel_t::size() const {
+        return pimpl->size();
+    }
+
+
+} /* namespace crequests */
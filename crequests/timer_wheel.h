@@ -0,0 +1,63 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "boost_asio_fwd.h"
+#include "types.h"
+
+#include <cstdint>
+#include <functional>
+
+namespace crequests {
+
+
+    using timer_id_t = std::uint64_t;
+
+
+    /*
+      Hierarchical timing wheel with a millisecond tick. All timers of
+      the service connections are registered here, and the wheel itself
+      keeps a single asio timer armed for the nearest expiry, so arming
+      and cancelling a timer is O(1) and does not allocate once the
+      wheel is warmed up.
+
+      Callbacks are called on the threads which run the io service and
+      must not block. schedule() and cancel() can be called from any thread.
+    */
+    class timer_wheel_t {
+    public:
+        using callback_t = std::function<void()>;
+
+    public:
+        explicit timer_wheel_t(ioservice_t& ioservice);
+        timer_wheel_t(const timer_wheel_t& wheel) = delete;
+        timer_wheel_t& operator=(const timer_wheel_t& wheel) = delete;
+        ~timer_wheel_t();
+
+    public:
+        /*
+          Registers the callback to be called at the given time (not
+          earlier, and up to a tick later). The returned id is never 0.
+        */
+        timer_id_t schedule(const time_point_t& when, callback_t&& callback);
+        timer_id_t schedule(const milliseconds_t& after, callback_t&& callback);
+
+        /*
+          Removes the timer if it is not fired yet and sets the id to 0.
+          Returns false if there was nothing to cancel.
+        */
+        bool cancel(timer_id_t& id);
+
+        /*
+          Number of timers which are not fired or cancelled yet.
+        */
+        size_t size() const;
+
+    private:
+        friend class timer_wheel_impl_t;
+        shared_ptr_t<class timer_wheel_impl_t> pimpl;
+    };
+
+
+} /* namespace crequests */
+
+#endif /* TIMER_WHEEL_H */
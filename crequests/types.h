@@ -18,6 +18,9 @@ namespace crequests {
     using vector_t = std::vector<T>;
     template <class T> using optional_t = boost::optional<T>;
     using seconds_t = std::chrono::seconds;
+    using milliseconds_t = std::chrono::milliseconds;
+    using steady_clock_t = std::chrono::steady_clock;
+    using time_point_t = steady_clock_t::time_point;
     template <class... Args>
     using shared_ptr_t = std::shared_ptr<Args...>;
     template <class T>
@@ -47,6 +50,7 @@ namespace crequests {
     class service_t;
     
     using final_callback_t = std::function<void(const response_t& response)>;
+    using completion_handler_t = std::function<void(response_t&& response)>;
     class error_t;
     using body_callback_t = std::function<void(const char* at,
                                                const size_t length,
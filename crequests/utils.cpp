@@ -1,7 +1,9 @@
 #include "utils.h"
 #include "boost_asio.h"
+#include "headers.h"
 
 #include <iomanip>
+#include <cstdlib>
 #include <ctime>
 #include <iostream>
 #include <sstream>
@@ -200,5 +202,67 @@ namespace crequests {
         return std::chrono::system_clock::to_time_t(time_point);
     }
 
+    bool is_idempotent_method(const string_t& method) {
+        const auto name = toupper(method);
+        return
+            name == "GET" or
+            name == "HEAD" or
+            name == "OPTIONS" or
+            name == "TRACE" or
+            name == "PUT" or
+            name == "DELETE";
+    }
+
+    void parse_keep_alive(const string_t& value, size_t& timeout, size_t& max) {
+        for (const auto& parameter : split(value, ',')) {
+            const auto ind = parameter.find('=');
+            if (ind == string_t::npos)
+                continue;
+
+            const auto name = tolower(trim(parameter.substr(0, ind)));
+            const auto number = trim(parameter.substr(ind + 1));
+            if (number.empty() or
+                number.size() > 9 or
+                number.find_first_not_of("0123456789") != string_t::npos)
+                continue;
+
+            if (name == "timeout")
+                timeout = std::stoul(number);
+            else if (name == "max")
+                max = std::stoul(number);
+        }
+    }
+
+    directives_t cache_control(const headers_t& fields) {
+        directives_t rv;
+        const auto range = fields.equal_range("Cache-Control");
+        for (auto it = range.first; it != range.second; ++it) {
+            for (const auto& item : split(it->second, ',')) {
+                const auto directive = trim(item);
+                if (directive.empty())
+                    continue;
+
+                const auto ind = directive.find('=');
+                auto value = ind == string_t::npos ? string_t{} : trim(directive.substr(ind + 1));
+                if (value.size() >= 2 and value.front() == '"' and value.back() == '"')
+                    value = value.substr(1, value.size() - 2);
+                rv[tolower(trim(directive.substr(0, ind)))] = value;
+            }
+        }
+        return rv;
+    }
+
+    bool parse_seconds(const string_t& value, seconds_t& seconds) {
+        if (value.empty() or value.find_first_not_of("0123456789") != string_t::npos)
+            return false;
+        seconds = seconds_t(std::strtoll(value.c_str(), nullptr, 10));
+        return true;
+    }
+
+    bool parse_seconds(const directives_t& directives, const string_t& name, seconds_t& seconds) {
+        const auto it = directives.find(name);
+        return it != directives.end() and parse_seconds(it->second, seconds);
+    }
+
 
 } /* namespace crequests */
@@ -5,6 +5,13 @@
 
 namespace crequests {
 
+    class headers_t;
+
+    /*
+      Directives of the Cache-Control headers by their names.
+    */
+    using directives_t = std::map<string_t, string_t>;
+
     bool is_url_encoded(const string_t& value);
     string_t urlencode(const string_t& value);
     string_t urldecode(const string_t& value);
@@ -22,6 +29,30 @@ namespace crequests {
     std::time_t now_gmt();
     std::time_t max_time();
 
+    /*
+      Methods which can be sent twice with the same effect (RFC 7231 4.2.2).
+    */
+    bool is_idempotent_method(const string_t& method);
+
+    /*
+      Parses the "timeout=N, max=M" hint of the Keep-Alive header. The
+      values which are missing or malformed are left as they are.
+    */
+    void parse_keep_alive(const string_t& value, size_t& timeout, size_t& max);
+
+    /*
+      The directives of all Cache-Control headers with the names in
+      lower case and the quotes of the values stripped.
+    */
+    directives_t cache_control(const headers_t& fields);
+
+    /*
+      Parses the delta seconds of a header or of the named directive.
+      Returns false when there is none or it is malformed.
+    */
+    bool parse_seconds(const string_t& value, seconds_t& seconds);
+    bool parse_seconds(const directives_t& directives, const string_t& name, seconds_t& seconds);
+
 } /* namespace crequests */
 
 #endif /* UTILS_H */
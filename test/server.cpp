@@ -5,6 +5,9 @@
 #include "../crequests/headers.h"
 #include "../crequests/request.h"
 
+#include <algorithm>
+#include <sstream>
+
 namespace crequests {
 
     namespace {
@@ -597,8 +600,14 @@ namespace crequests {
     }
 
     void server_t::stop() {
-        acceptor.close();
-        io_service.stop();
+        /*
+          The acceptor is closed on the server thread, an accept handler
+          may be running there right now.
+        */
+        io_service.post([this]() {
+            acceptor.close();
+            io_service.stop();
+        });
     }
 
     void server_t::do_accept() {
@@ -619,4 +628,133 @@ namespace crequests {
             stream->socket<ssl_socket_t::lowest_layer_type>(), callback);
     }
 
+
+    string_t scripted_server_t::received_t::field(const string_t& name) const {
+        const auto found = head.find("\r\n" + name + ": ");
+        if (found == string_t::npos)
+            return "";
+        const auto begin = found + name.size() + 4;
+        return head.substr(begin, head.find("\r\n", begin) - begin);
+    }
+
+    scripted_server_t::scripted_server_t(const unsigned short port, const handler_t& handler)
+        : acceptor{ioservice, {boost::asio::ip::address::from_string("127.0.0.1"), port}},
+          m_handler{handler},
+          thread{[this]() { run(); }}
+    {
+
+    }
+
+    /*
+      The blocked accept is woken up by a connection closed at once,
+      the blocked reads by shutting the connections down.
+    */
+    scripted_server_t::~scripted_server_t() {
+        stopping = true;
+        {
+            tcp_socket_t socket{ioservice};
+            ec_t ec;
+            socket.connect(acceptor.local_endpoint(), ec);
+        }
+        thread.join();
+
+        for (const auto& socket : sockets) {
+            ec_t ec;
+            socket->shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+        }
+        for (auto& worker : workers)
+            worker->join();
+    }
+
+    void scripted_server_t::write(tcp_socket_t& socket, const string_t& data) {
+        ec_t ec;
+        boost::asio::write(socket, boost::asio::buffer(data), ec);
+    }
+
+    size_t scripted_server_t::accepted() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return m_accepted_at.size();
+    }
+
+    vector_t<time_point_t> scripted_server_t::accepted_at() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return m_accepted_at;
+    }
+
+    size_t scripted_server_t::requests() const {
+        return m_requests;
+    }
+
+    size_t scripted_server_t::closed_by_client() const {
+        return m_closed_by_client;
+    }
+
+    size_t scripted_server_t::hits(const string_t& key) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto it = m_hits.find(key);
+        return it == m_hits.end() ? 0 : it->second;
+    }
+
+    void scripted_server_t::run() {
+        while (true) {
+            const auto socket = std::make_shared<tcp_socket_t>(ioservice);
+            ec_t ec;
+            acceptor.accept(*socket, ec);
+            if (ec or stopping)
+                return;
+
+            size_t connection;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                connection = m_accepted_at.size();
+                m_accepted_at.push_back(steady_clock_t::now());
+            }
+            sockets.push_back(socket);
+            workers.emplace_back(new std::thread{[this, connection, socket]() {
+                serve(connection, *socket);
+            }});
+        }
+    }
+
+    void scripted_server_t::serve(const size_t connection, tcp_socket_t& socket) {
+        streambuf_t buf;
+        while (true) {
+            ec_t ec;
+            const auto header_size = boost::asio::read_until(socket, buf, "\r\n\r\n", ec);
+            if (ec) {
+                if (ec == boost::asio::error::eof)
+                    m_closed_by_client++;
+                return;
+            }
+
+            received_t request {connection, "", "", "", ""};
+            request.head.assign(boost::asio::buffers_begin(buf.data()),
+                                boost::asio::buffers_begin(buf.data()) + header_size);
+            buf.consume(header_size);
+
+            std::istringstream stream(request.head);
+            stream >> request.method >> request.path;
+
+            const auto length = request.field("Content-Length");
+            const size_t content_length = length.empty() ? 0 : std::stoul(length);
+            if (buf.size() < content_length)
+                boost::asio::read(socket, buf, boost::asio::transfer_exactly(content_length - buf.size()), ec);
+            request.body.assign(boost::asio::buffers_begin(buf.data()),
+                                boost::asio::buffers_begin(buf.data()) + std::min(content_length, buf.size()));
+            buf.consume(content_length);
+
+            m_requests++;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                m_hits[request.path]++;
+                m_hits[request.method + " " + request.path]++;
+            }
+
+            if (not m_handler(request, socket)) {
+                socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, ec);
+                return;
+            }
+        }
+    }
+
 } /* namespace crequests */
@@ -2,9 +2,16 @@
 #define SERVER_H
 
 #include <boost/asio.hpp>
-#include "../crequests/boost_asio_fwd.h"
+#include "../crequests/boost_asio.h"
 #include "../crequests/types.h"
 
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 namespace crequests {
 
     class server_t {
@@ -24,7 +31,76 @@ namespace crequests {
         boost::asio::ip::tcp::acceptor acceptor;
         bool is_ssl;
     };
-    
+
+    /*
+      Plain server for the tests which need an exact control of the
+      replies and of the connections. Every accepted connection is
+      served by a thread of its own: the requests are read one by one
+      (with the body of the Content-Length) and given to the handler,
+      which writes the reply itself and tells whether the connection is
+      kept for the next request. A handler which writes nothing and
+      keeps the connection leaves the client without an answer.
+    */
+    class scripted_server_t {
+    public:
+        struct received_t {
+            size_t connection;    /* number of the connection, from 0 */
+            string_t method;
+            string_t path;
+            string_t head;        /* request line and fields */
+            string_t body;
+
+            /*
+              The value of the field, empty when the head has none.
+            */
+            string_t field(const string_t& name) const;
+        };
+
+        using handler_t = std::function<bool(const received_t& request, tcp_socket_t& socket)>;
+
+    public:
+        scripted_server_t(const unsigned short port, const handler_t& handler);
+        scripted_server_t(const scripted_server_t&) = delete;
+        scripted_server_t& operator=(const scripted_server_t&) = delete;
+        ~scripted_server_t();
+
+    public:
+        /*
+          Writes the whole data, the errors are ignored since the client
+          may be gone already.
+        */
+        static void write(tcp_socket_t& socket, const string_t& data);
+
+        size_t accepted() const;
+        vector_t<time_point_t> accepted_at() const;
+        size_t requests() const;
+        size_t closed_by_client() const;
+
+        /*
+          The requests of the path ("/path") or of the method and the
+          path ("GET /path").
+        */
+        size_t hits(const string_t& key) const;
+
+    private:
+        void run();
+        void serve(const size_t connection, tcp_socket_t& socket);
+
+    private:
+        ioservice_t ioservice {};
+        boost::asio::ip::tcp::acceptor acceptor;
+        const handler_t m_handler;
+        mutable std::mutex mutex {};
+        vector_t<time_point_t> m_accepted_at {};
+        std::map<string_t, size_t> m_hits {};
+        std::atomic<size_t> m_requests {0};
+        std::atomic<size_t> m_closed_by_client {0};
+        std::atomic<bool> stopping {false};
+        vector_t<shared_ptr_t<tcp_socket_t> > sockets {};
+        vector_t<std::unique_ptr<std::thread> > workers {};
+        std::thread thread;
+    };
+
 } /* namespace crequests */
 
 #endif /* SERVER_H */
@@ -0,0 +1,48 @@
+#include "adaptive_limit.h"
+#include "gtest/gtest.h"
+
+using namespace testing;
+using namespace crequests;
+
+TEST(AdaptiveLimit, GrowsWhenFlat) {
+    adaptive_limit_t limit;
+    const auto initial = limit.limit();
+
+    for (size_t i = 0; i < 10; ++i)
+        limit.sample(milliseconds_t{10}, limit.limit(), false, 0);
+
+    EXPECT_EQ(limit.limit(), initial + 10);
+    EXPECT_GE(limit.min_latency(), 10);
+
+    /*
+      An idle host does not prove that more requests are fine.
+    */
+    limit.sample(milliseconds_t{10}, 1, false, 0);
+    EXPECT_EQ(limit.limit(), initial + 10);
+}
+
+TEST(AdaptiveLimit, ShrinksOnDropsAndLatency) {
+    adaptive_limit_t limit;
+    for (size_t i = 0; i < 32; ++i)
+        limit.sample(milliseconds_t{10}, limit.limit(), false, 0);
+    const auto grown = limit.limit();
+
+    limit.sample(milliseconds_t{10}, grown, true, 0);
+    EXPECT_EQ(limit.limit(), static_cast<size_t>(grown * 0.75));
+
+    const auto dropped = limit.limit();
+    for (size_t i = 0; i < 5; ++i)
+        limit.sample(milliseconds_t{100}, dropped, false, 0);
+    EXPECT_LT(limit.limit(), dropped);
+
+    for (size_t i = 0; i < 100; ++i)
+        limit.sample(milliseconds_t{1000}, 1, true, 0);
+    EXPECT_EQ(limit.limit(), 1);
+}
+
+TEST(AdaptiveLimit, Bounded) {
+    adaptive_limit_t limit;
+    for (size_t i = 0; i < 100; ++i)
+        limit.sample(milliseconds_t{1}, limit.limit(), false, 20);
+    EXPECT_EQ(limit.limit(), 20);
+}
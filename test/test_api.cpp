@@ -1,4 +1,5 @@
 #include "api.h"
+#include "boost_asio.h"
 #include "server.h"
 #include "gtest/gtest.h"
 
@@ -348,3 +349,77 @@ TEST(Api, SessionAsyncGetTwoRequests) {
     server.stop();
     thread.join();
 }
+
+TEST(Api, AsyncCompletionHandler) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    std::promise<response_t> promise;
+    const auto completion = [&promise](response_t&& response) {
+        promise.set_value(std::move(response));
+    };
+    AsyncGet(service, completion_handler_t{completion}, "http://127.0.0.1:8080/get");
+
+    const auto response = promise.get_future().get();
+
+    EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(response.status_code().value(), 200);
+    EXPECT_EQ(response.raw().value(),
+              "domain: 127.0.0.1\n"
+              "path: /get\n"
+              "query: ");
+
+    server.stop();
+    thread.join();
+}
+
+TEST(Api, InlineIo) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    auto& session = service.new_session("127.0.0.1:8080/get?a=1", inline_io_t{true});
+
+    auto response = session.Get();
+
+    EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(response.raw().value(),
+              "domain: 127.0.0.1\n"
+              "path: /get\n"
+              "query: a=1");
+
+    response = Get(service, "127.0.0.1:8080/delay/2", timeout_t{1}, inline_io_t{true});
+
+    EXPECT_EQ(response.error().code_to_string(), "TIMEOUT");
+
+    server.stop();
+    thread.join();
+}
+
+TEST(Api, ExternalIoService) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    ioservice_t ioservice;
+    service_t service{ioservice};
+    EXPECT_TRUE(service.is_external());
+
+    response_t response{request_t{}};
+    std::thread::id completion_thread;
+    const auto completion = [&](response_t&& result) {
+        completion_thread = std::this_thread::get_id();
+        response = std::move(result);
+        ioservice.stop();
+    };
+    AsyncGet(service, completion_handler_t{completion}, "http://127.0.0.1:8080/get");
+
+    ioservice.run();
+
+    EXPECT_TRUE(completion_thread == std::this_thread::get_id());
+    EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(response.status_code().value(), 200);
+
+    server.stop();
+    thread.join();
+}
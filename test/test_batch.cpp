@@ -0,0 +1,98 @@
+#include "api.h"
+#include "server.h"
+#include "gtest/gtest.h"
+
+#include <set>
+#include <thread>
+
+using namespace testing;
+using namespace crequests;
+
+namespace {
+
+    request_t make_request(const string_t& url) {
+        request_t request;
+        request.uri(uri_t::from_string(url));
+        return request;
+    }
+
+} /* anonymous namespace */
+
+TEST(Batch, WaitAll) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    const auto batch = service.send_batch({
+        make_request("http://127.0.0.1:8080/get?a=0"),
+        make_request("http://127.0.0.1:8080/get?a=1"),
+        make_request("http://127.0.0.1:8080/get?a=2")
+    });
+    EXPECT_EQ(batch.size(), 3);
+
+    const auto responses = batch.wait_all();
+    ASSERT_EQ(responses.size(), 3);
+    EXPECT_EQ(batch.done(), 3);
+
+    for (size_t i = 0; i < responses.size(); ++i) {
+        EXPECT_EQ(responses[i].error().code_to_string(), "SUCCESS");
+        EXPECT_EQ(responses[i].raw().value(),
+                  "domain: 127.0.0.1\n"
+                  "path: /get\n"
+                  "query: a=" + std::to_string(i));
+    }
+
+    server.stop();
+    thread.join();
+}
+
+TEST(Batch, AsCompleted) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    vector_t<request_t> requests;
+    for (size_t i = 0; i < 5; ++i)
+        requests.push_back(make_request("http://127.0.0.1:8080/get"));
+    const auto batch = service.send_batch(requests);
+
+    std::set<size_t> tags;
+    for (const auto& completion : batch.as_completed()) {
+        EXPECT_EQ(completion.response().status_code().value(), 200);
+        tags.insert(completion.tag().value());
+    }
+
+    EXPECT_EQ(tags, (std::set<size_t>{0, 1, 2, 3, 4}));
+    EXPECT_FALSE(batch.wait_any());
+
+    server.stop();
+    thread.join();
+}
+
+TEST(Batch, CancelRemaining) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    const auto batch = service.send_batch({
+        make_request("http://127.0.0.1:8080/get"),
+        make_request("http://127.0.0.1:8080/delay/3")
+    });
+
+    const auto first = batch.wait_any();
+    ASSERT_TRUE(first);
+    EXPECT_EQ(first->tag(), tag_t{0});
+    EXPECT_EQ(first->response().error().code_to_string(), "SUCCESS");
+
+    const auto started = steady_clock_t::now();
+    batch.cancel();
+
+    const auto second = batch.wait_any();
+    ASSERT_TRUE(second);
+    EXPECT_EQ(second->tag(), tag_t{1});
+    EXPECT_EQ(second->response().error().code_to_string(), "CANCELLED");
+    EXPECT_LT(steady_clock_t::now() - started, seconds_t{1});
+
+    server.stop();
+    thread.join();
+}
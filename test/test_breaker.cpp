@@ -0,0 +1,117 @@
+#include "api.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using namespace testing;
+using namespace crequests;
+
+TEST(Breaker, ConsecutiveFailures) {
+    breaker_t breaker;
+    EXPECT_FALSE(breaker.enabled());
+
+    breaker.set_option(breaker_failures_t{2});
+    breaker.set_option(breaker_open_time_t{50});
+    EXPECT_TRUE(breaker.enabled());
+
+    breaker_t::ticket_t closed = 0;
+    EXPECT_TRUE(breaker.allow("a:80", closed));
+    breaker.report("a:80", closed, breaker_t::outcome_t::FAILURE);
+    breaker.report("a:80", closed, breaker_t::outcome_t::SUCCESS);
+    breaker.report("a:80", closed, breaker_t::outcome_t::FAILURE);
+    EXPECT_EQ(breaker.state("a:80"), breaker_t::state_t::CLOSED);
+
+    breaker.report("a:80", closed, breaker_t::outcome_t::FAILURE);
+    EXPECT_EQ(breaker.state("a:80"), breaker_t::state_t::OPEN);
+
+    breaker_t::ticket_t ticket = 0;
+    EXPECT_FALSE(breaker.allow("a:80", ticket));
+    EXPECT_TRUE(breaker.allow("b:80", ticket));
+
+    std::this_thread::sleep_for(milliseconds_t{60});
+
+    /*
+      Only one probe goes through, its failure opens the circuit again.
+    */
+    EXPECT_TRUE(breaker.allow("a:80", ticket));
+    EXPECT_EQ(breaker.state("a:80"), breaker_t::state_t::HALF_OPEN);
+    EXPECT_FALSE(breaker.allow("a:80", ticket));
+    breaker.report("a:80", ticket, breaker_t::outcome_t::FAILURE);
+    EXPECT_EQ(breaker.state("a:80"), breaker_t::state_t::OPEN);
+
+    std::this_thread::sleep_for(milliseconds_t{60});
+
+    EXPECT_TRUE(breaker.allow("a:80", ticket));
+    breaker.report("a:80", ticket, breaker_t::outcome_t::NEUTRAL);
+    EXPECT_TRUE(breaker.allow("a:80", ticket));
+    breaker.report("a:80", ticket, breaker_t::outcome_t::SUCCESS);
+    EXPECT_EQ(breaker.state("a:80"), breaker_t::state_t::CLOSED);
+}
+
+TEST(Breaker, StaleReports) {
+    breaker_t breaker;
+    breaker.set_option(breaker_failures_t{1});
+    breaker.set_option(breaker_open_time_t{50});
+
+    breaker_t::ticket_t closed = 0;
+    breaker_t::ticket_t slow = 0;
+    EXPECT_TRUE(breaker.allow("a:80", closed));
+    EXPECT_TRUE(breaker.allow("a:80", slow));
+    breaker.report("a:80", closed, breaker_t::outcome_t::FAILURE);
+    EXPECT_EQ(breaker.state("a:80"), breaker_t::state_t::OPEN);
+
+    std::this_thread::sleep_for(milliseconds_t{60});
+
+    /*
+      The request of the closed circuit is not the probe: it neither
+      closes the circuit nor frees the probe.
+    */
+    breaker_t::ticket_t probe = 0;
+    EXPECT_TRUE(breaker.allow("a:80", probe));
+    breaker.report("a:80", slow, breaker_t::outcome_t::SUCCESS);
+    EXPECT_EQ(breaker.state("a:80"), breaker_t::state_t::HALF_OPEN);
+    breaker_t::ticket_t ticket = 0;
+    EXPECT_FALSE(breaker.allow("a:80", ticket));
+
+    /*
+      A probe of the earlier half open round is not counted in the next one.
+    */
+    breaker.report("a:80", probe, breaker_t::outcome_t::FAILURE);
+    EXPECT_EQ(breaker.state("a:80"), breaker_t::state_t::OPEN);
+    std::this_thread::sleep_for(milliseconds_t{60});
+
+    EXPECT_TRUE(breaker.allow("a:80", ticket));
+    breaker.report("a:80", probe, breaker_t::outcome_t::SUCCESS);
+    EXPECT_EQ(breaker.state("a:80"), breaker_t::state_t::HALF_OPEN);
+    breaker.report("a:80", ticket, breaker_t::outcome_t::SUCCESS);
+    EXPECT_EQ(breaker.state("a:80"), breaker_t::state_t::CLOSED);
+}
+
+TEST(Breaker, ErrorRate) {
+    breaker_t breaker;
+    breaker.set_option(breaker_error_rate_t{50});
+    breaker.set_option(breaker_window_t{4});
+
+    breaker.report("a:80", 0, breaker_t::outcome_t::FAILURE);
+    breaker.report("a:80", 0, breaker_t::outcome_t::SUCCESS);
+    breaker.report("a:80", 0, breaker_t::outcome_t::FAILURE);
+    EXPECT_EQ(breaker.state("a:80"), breaker_t::state_t::CLOSED);
+
+    breaker.report("a:80", 0, breaker_t::outcome_t::SUCCESS);
+    EXPECT_EQ(breaker.state("a:80"), breaker_t::state_t::OPEN);
+}
+
+TEST(Breaker, FailsFast) {
+    service_t service;
+    service.set_option(breaker_failures_t{1});
+
+    /*
+      Nobody listens on the port, so the first request fails to connect.
+    */
+    auto response = Get(service, "http://127.0.0.1:8081/");
+    EXPECT_EQ(response.error().code_to_string(), "CONNECT_ERROR");
+
+    response = Get(service, "http://127.0.0.1:8081/");
+    EXPECT_EQ(response.error().code_to_string(), "CIRCUIT_OPEN");
+    EXPECT_EQ(service.get_breaker().state("127.0.0.1:8081"), breaker_t::state_t::OPEN);
+}
@@ -0,0 +1,101 @@
+#include "api.h"
+#include "server.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using namespace testing;
+using namespace crequests;
+
+TEST(CancelToken, Subscribe) {
+    cancel_token_t token;
+    size_t called = 0;
+
+    const auto id = token.subscribe([&called](){ called++; });
+    EXPECT_NE(id, 0);
+    EXPECT_FALSE(token.is_cancelled());
+
+    token.cancel();
+    token.cancel();
+    EXPECT_TRUE(token.is_cancelled());
+    EXPECT_EQ(called, 1);
+
+    EXPECT_EQ(token.subscribe([&called](){ called++; }), 0);
+    EXPECT_EQ(called, 2);
+}
+
+TEST(CancelToken, Unsubscribe) {
+    cancel_token_t token;
+    size_t called = 0;
+
+    token.unsubscribe(token.subscribe([&called](){ called++; }));
+    token.cancel();
+
+    EXPECT_EQ(called, 0);
+}
+
+TEST(CancelToken, Empty) {
+    const cancel_token_t token {nullptr};
+    EXPECT_TRUE(token.empty());
+
+    token.cancel();
+    EXPECT_FALSE(token.is_cancelled());
+    EXPECT_EQ(token.subscribe([](){}), 0);
+}
+
+TEST(CancelToken, CancelRequest) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    cancel_token_t token;
+    const auto response = AsyncGet(service, "http://127.0.0.1:8080/delay/3", token);
+
+    const auto started = steady_clock_t::now();
+    token.cancel();
+
+    EXPECT_EQ(response.get().error().code_to_string(), "CANCELLED");
+    EXPECT_LT(steady_clock_t::now() - started, seconds_t{1});
+
+    server.stop();
+    thread.join();
+}
+
+TEST(CancelToken, CancelOnDrop) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    std::promise<response_t> promise;
+    const auto final_callback = [&promise](const response_t& response) {
+        promise.set_value(response);
+    };
+
+    AsyncGet(service, "http://127.0.0.1:8080/delay/3",
+             final_callback_t{final_callback}, cancel_on_drop_t{true});
+
+    const auto started = steady_clock_t::now();
+    const auto response = promise.get_future().get();
+
+    EXPECT_EQ(response.error().code_to_string(), "CANCELLED");
+    EXPECT_LT(steady_clock_t::now() - started, seconds_t{1});
+
+    server.stop();
+    thread.join();
+}
+
+TEST(CancelToken, Deadline) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    const auto started = steady_clock_t::now();
+    const auto response = Get(service, "http://127.0.0.1:8080/delay/3",
+                              deadline_t{milliseconds_t{200}});
+
+    EXPECT_EQ(response.error().code_to_string(), "TIMEOUT");
+    EXPECT_LT(steady_clock_t::now() - started, seconds_t{1});
+
+    server.stop();
+    thread.join();
+}
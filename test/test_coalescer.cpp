@@ -0,0 +1,163 @@
+#include "api.h"
+#include "boost_asio.h"
+#include "server.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using namespace testing;
+using namespace crequests;
+
+namespace {
+
+    /*
+      Answers with the path after a delay, so the requests sent at once
+      overlap.
+    */
+    bool slow(const scripted_server_t::received_t& request, tcp_socket_t& socket) {
+        std::this_thread::sleep_for(milliseconds_t{300});
+        scripted_server_t::write(socket,
+            "HTTP/1.1 200 OK\r\nConnection: close\r\n"
+            "Content-Length: " + std::to_string(request.path.size()) + "\r\n\r\n" + request.path);
+        return false;
+    }
+
+    const string_t URL = "http://127.0.0.1:8090";
+
+    request_t make_request(const string_t& url, const headers_t& fields) {
+        request_t request;
+        request.url(url);
+        request.headers(fields);
+        request.prepare();
+        return request;
+    }
+
+} /* anonymous namespace */
+
+TEST(Coalescer, Fingerprint) {
+    const auto request = make_request(URL + "/a", {{"X-A", "1"}, {"X-B", "2"}});
+    const auto fingerprint = coalescer_t::fingerprint(request);
+    EXPECT_FALSE(fingerprint.empty());
+    EXPECT_EQ(fingerprint, coalescer_t::fingerprint(make_request(URL + "/a", {{"x-b", "2"}, {"x-a", "1"}})));
+    EXPECT_NE(fingerprint, coalescer_t::fingerprint(make_request(URL + "/b", {{"X-A", "1"}, {"X-B", "2"}})));
+    EXPECT_NE(fingerprint, coalescer_t::fingerprint(make_request(URL + "/a", {{"X-A", "1"}, {"X-B", "3"}})));
+
+    cookies_t cookies;
+    cookies.add(cookie_t{"127.0.0.1", "/", "id=1"});
+    auto with_cookies = request;
+    with_cookies.cookies(cookies);
+    EXPECT_NE(fingerprint, coalescer_t::fingerprint(with_cookies));
+
+    auto verified = request;
+    verified.always_verify_peer(always_verify_peer_t{true});
+    EXPECT_NE(fingerprint, coalescer_t::fingerprint(verified));
+
+    auto trusted = request;
+    trusted.verify_filename(verify_filename_t{"ca.pem"});
+    EXPECT_NE(fingerprint, coalescer_t::fingerprint(trusted));
+
+    auto authenticated = request;
+    authenticated.ssl_auth(ssl_auth_t{certificate_t{"cert"}, privatekey_t{"key"}});
+    EXPECT_NE(fingerprint, coalescer_t::fingerprint(authenticated));
+
+    auto post = request;
+    post.method(method_t{"POST"});
+    EXPECT_TRUE(coalescer_t::fingerprint(post).empty());
+}
+
+TEST(Coalescer, OffByDefault) {
+    scripted_server_t server{8090, slow};
+    service_t service;
+
+    vector_t<asyncresponse_t> responses;
+    for (size_t i = 0; i < 3; ++i)
+        responses.push_back(AsyncGet(service, URL + "/off"));
+    for (const auto& response : responses)
+        EXPECT_FALSE(response.get().coalesced().value());
+    EXPECT_EQ(server.requests(), 3);
+}
+
+TEST(Coalescer, ConcurrentGets) {
+    scripted_server_t server{8090, slow};
+    service_t service;
+
+    vector_t<asyncresponse_t> responses;
+    for (size_t i = 0; i < 8; ++i)
+        responses.push_back(AsyncGet(service, URL + "/same", coalesce_t{true}));
+
+    string_t streamed;
+    const auto callback = [&streamed](const char* at, const size_t length, const crequests::error_t&) {
+        streamed.append(at, length);
+    };
+    const auto streaming = AsyncGet(service, URL + "/same", coalesce_t{true}, body_callback_t{callback});
+
+    size_t coalesced = 0;
+    for (const auto& async : responses) {
+        const auto response = async.get();
+        EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+        EXPECT_EQ(response.status_code().value(), 200);
+        EXPECT_EQ(response.raw().value(), "/same");
+        coalesced += response.coalesced().value();
+    }
+    EXPECT_TRUE(streaming.get().coalesced().value());
+    EXPECT_EQ(streamed, "/same");
+    EXPECT_EQ(coalesced, 7);
+    EXPECT_EQ(server.requests(), 1);
+    EXPECT_EQ(service.get_coalescer().size(), 0);
+
+    /*
+      The flight is over, so the next request is sent.
+    */
+    EXPECT_FALSE(Get(service, URL + "/same", coalesce_t{true}).coalesced().value());
+    EXPECT_EQ(server.requests(), 2);
+}
+
+TEST(Coalescer, LeaderCancelled) {
+    scripted_server_t server{8090, slow};
+    service_t service;
+
+    cancel_token_t token;
+    const auto leader = AsyncGet(service, URL + "/cancel", coalesce_t{true}, token);
+    std::this_thread::sleep_for(milliseconds_t{100});
+
+    vector_t<asyncresponse_t> responses;
+    for (size_t i = 0; i < 3; ++i)
+        responses.push_back(AsyncGet(service, URL + "/cancel", coalesce_t{true}));
+    std::this_thread::sleep_for(milliseconds_t{100});
+
+    token.cancel();
+    EXPECT_EQ(leader.get().error().code_to_string(), "CANCELLED");
+
+    /*
+      The waiters begin a flight of their own.
+    */
+    size_t coalesced = 0;
+    for (const auto& async : responses) {
+        const auto response = async.get();
+        EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+        EXPECT_EQ(response.raw().value(), "/cancel");
+        coalesced += response.coalesced().value();
+    }
+    EXPECT_EQ(coalesced, 2);
+    EXPECT_EQ(server.requests(), 2);
+}
+
+TEST(Coalescer, InlineWaiter) {
+    scripted_server_t server{8090, slow};
+    service_t service;
+
+    /*
+      The flight is led on the service thread, its result is posted to
+      the io service of the inline request.
+    */
+    const auto leader = AsyncGet(service, URL + "/inline", coalesce_t{true});
+    std::this_thread::sleep_for(milliseconds_t{100});
+
+    const auto response = Get(service, URL + "/inline", coalesce_t{true},
+                              timeout_t{5}, inline_io_t{true});
+    EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(response.raw().value(), "/inline");
+    EXPECT_TRUE(response.coalesced().value());
+    EXPECT_EQ(leader.get().error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(server.requests(), 1);
+}
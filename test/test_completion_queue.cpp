@@ -0,0 +1,103 @@
+#include "api.h"
+#include "server.h"
+#include "gtest/gtest.h"
+
+#include <set>
+#include <thread>
+
+using namespace testing;
+using namespace crequests;
+
+TEST(CompletionQueue, PushAndPoll) {
+    completion_queue_t queue;
+    EXPECT_TRUE(queue.empty());
+
+    queue.push(tag_t{1}, response_t{request_t{}});
+    queue.push(tag_t{2}, response_t{request_t{}});
+    queue.push(tag_t{3}, response_t{request_t{}});
+    EXPECT_EQ(queue.size(), 3);
+
+    auto completions = queue.poll(2);
+    ASSERT_EQ(completions.size(), 2);
+    EXPECT_EQ(completions[0].tag(), tag_t{1});
+    EXPECT_EQ(completions[1].tag(), tag_t{2});
+
+    completions = queue.poll();
+    ASSERT_EQ(completions.size(), 1);
+    EXPECT_EQ(completions[0].tag(), tag_t{3});
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(CompletionQueue, PriorityOrder) {
+    completion_queue_t queue;
+
+    const auto push = [&queue](const size_t tag, const int priority) {
+        request_t request;
+        request.priority(priority_t{priority});
+        queue.push(tag_t{tag}, response_t{request});
+    };
+
+    push(1, 0);
+    push(2, -1);
+    push(3, 1);
+    push(4, 0);
+
+    const auto completions = queue.poll();
+    ASSERT_EQ(completions.size(), 4);
+    EXPECT_EQ(completions[0].tag(), tag_t{3});
+    EXPECT_EQ(completions[1].tag(), tag_t{1});
+    EXPECT_EQ(completions[2].tag(), tag_t{4});
+    EXPECT_EQ(completions[3].tag(), tag_t{2});
+}
+
+TEST(CompletionQueue, BindCountsPending) {
+    completion_queue_t queue;
+
+    const auto handler = queue.bind(tag_t{7});
+    EXPECT_EQ(queue.pending(), 1);
+
+    handler(response_t{request_t{}});
+    EXPECT_EQ(queue.pending(), 0);
+
+    const auto completions = queue.wait_for(1, steady_clock_t::now());
+    ASSERT_EQ(completions.size(), 1);
+    EXPECT_EQ(completions[0].tag(), tag_t{7});
+}
+
+TEST(CompletionQueue, WaitForDeadline) {
+    completion_queue_t queue;
+    queue.bind(tag_t{1});
+
+    const auto started = steady_clock_t::now();
+    const auto completions = queue.wait_for(1, started + milliseconds_t{50});
+
+    EXPECT_TRUE(completions.empty());
+    EXPECT_GE(steady_clock_t::now() - started, milliseconds_t{50});
+}
+
+TEST(CompletionQueue, AsyncRequests) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    completion_queue_t queue;
+
+    for (size_t i = 0; i < 5; ++i)
+        AsyncGet(service, queue, tag_t{i}, "http://127.0.0.1:8080/");
+
+    std::set<size_t> tags;
+    const auto deadline = steady_clock_t::now() + seconds_t{5};
+    while (tags.size() < 5 and steady_clock_t::now() < deadline) {
+        for (const auto& completion : queue.wait_for(5, deadline)) {
+            EXPECT_EQ(completion.response().error().code_to_string(), "SUCCESS");
+            EXPECT_EQ(completion.response().status_code().value(), 200);
+            tags.insert(completion.tag().value());
+        }
+    }
+
+    EXPECT_EQ(tags, (std::set<size_t>{0, 1, 2, 3, 4}));
+    EXPECT_EQ(queue.pending(), 0);
+
+    server.stop();
+    thread.join();
+}
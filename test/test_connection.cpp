@@ -264,3 +264,118 @@ TEST(ConnectionBad, ErrorThroughBodyCallback) {
     server.stop();
     thread.join();
 }
+
+TEST(ConnectionBad, FirstByteTimeout) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    const auto started = steady_clock_t::now();
+    const auto response = Get(service, "127.0.0.1:8080/delay/2",
+                              first_byte_timeout_t{100});
+
+    EXPECT_EQ(response.error().code(), error_code_t::TIMEOUT);
+    EXPECT_EQ(response.error().message(), "first byte timeout");
+    EXPECT_LT(steady_clock_t::now() - started, seconds_t{1});
+
+    server.stop();
+    thread.join();
+}
+
+TEST(ConnectionBad, TotalTimeout) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    const auto started = steady_clock_t::now();
+    const auto response = Get(service, "127.0.0.1:8080/delay/2",
+                              total_timeout_t{150});
+
+    EXPECT_EQ(response.error().code(), error_code_t::TIMEOUT);
+    EXPECT_EQ(response.error().message(), "timeout");
+    EXPECT_LT(steady_clock_t::now() - started, seconds_t{1});
+
+    server.stop();
+    thread.join();
+}
+
+TEST(ConnectionGood, PhaseTimeouts) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    const auto response = Get(service, "127.0.0.1:8080/get",
+                              resolve_timeout_t{1000},
+                              connect_timeout_t{1000},
+                              first_byte_timeout_t{1000},
+                              read_timeout_t{1000},
+                              total_timeout_t{2000});
+
+    EXPECT_EQ(response.error().code(), error_code_t::SUCCESS);
+    EXPECT_EQ(response.status_code().value(), 200);
+
+    server.stop();
+    thread.join();
+}
+
+TEST(ConnectionGood, ReadQuota) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    auto response = Get(service, "127.0.0.1:8080/get_big_content_length",
+                        read_quota_t{100});
+    EXPECT_EQ(response.error().code(), error_code_t::SUCCESS);
+    EXPECT_EQ(response.raw().value().size(), 10000);
+    EXPECT_EQ(response.raw().value().back(), 'z');
+
+    response = Get(service, "127.0.0.1:8080/get_big_chunks", read_quota_t{100});
+    EXPECT_EQ(response.error().code(), error_code_t::SUCCESS);
+    EXPECT_EQ(response.raw().value(), string_t(1500, 's'));
+
+    service.set_option(read_quota_t{100});
+    response = Get(service, "127.0.0.1:8080/get_big_until_eof");
+    EXPECT_EQ(response.error().code(), error_code_t::SUCCESS);
+    EXPECT_EQ(response.raw().value().size(), 10000);
+
+    server.stop();
+    thread.join();
+}
+
+TEST(ConnectionGood, MaxBandwidth) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    /*
+      The first second of the rate is free, the rest 6000 bytes
+      are read at 4000 bytes per second.
+    */
+    service_t service;
+    auto started = steady_clock_t::now();
+    auto response = Get(service, "127.0.0.1:8080/get_big_content_length",
+                        read_quota_t{1000}, max_bandwidth_t{4000});
+    EXPECT_EQ(response.error().code(), error_code_t::SUCCESS);
+    EXPECT_EQ(response.raw().value().size(), 10000);
+    EXPECT_GE(steady_clock_t::now() - started, milliseconds_t{1000});
+
+    service.set_option(host_bandwidth_t{4000});
+    started = steady_clock_t::now();
+    response = Get(service, "127.0.0.1:8080/get_big_content_length",
+                   read_quota_t{1000});
+    EXPECT_EQ(response.error().code(), error_code_t::SUCCESS);
+    EXPECT_EQ(response.raw().value().size(), 10000);
+    EXPECT_GE(steady_clock_t::now() - started, milliseconds_t{1000});
+
+    /*
+      The delays of an inline request come from the service thread too.
+    */
+    started = steady_clock_t::now();
+    response = Get(service, "127.0.0.1:8080/get_big_content_length",
+                   read_quota_t{1000}, timeout_t{5}, inline_io_t{true});
+    EXPECT_EQ(response.error().code(), error_code_t::SUCCESS);
+    EXPECT_EQ(response.raw().value().size(), 10000);
+    EXPECT_GE(steady_clock_t::now() - started, milliseconds_t{1000});
+
+    server.stop();
+    thread.join();
+}
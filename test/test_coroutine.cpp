@@ -0,0 +1,56 @@
+#include "coroutine.h"
+#include "server.h"
+#include "gtest/gtest.h"
+
+#ifdef CREQUESTS_HAS_COROUTINES
+
+#include <exception>
+#include <future>
+#include <thread>
+
+using namespace testing;
+using namespace crequests;
+
+namespace {
+
+    /*
+      The smallest coroutine type which runs at once and is not awaited
+      by anybody, the same as the one of the README.
+    */
+    struct task_t {
+        struct promise_type {
+            task_t get_return_object() { return {}; }
+            std::suspend_never initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    task_t handler(service_t& service, std::promise<unsigned int>& status) {
+        const auto response = co_await async_get(service, "http://127.0.0.1:8080/get");
+
+        auto& session = service.new_session("http://127.0.0.1:8080/get", timeout_t{10});
+        const auto next = co_await async_get(session);
+
+        status.set_value(response.status_code().value() + next.status_code().value());
+    }
+
+} /* anonymous namespace */
+
+TEST(Coroutine, AwaitRequests) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    {
+        service_t service;
+        std::promise<unsigned int> status;
+        handler(service, status);
+        EXPECT_EQ(status.get_future().get(), 400);
+    }
+
+    server.stop();
+    thread.join();
+}
+
+#endif /* CREQUESTS_HAS_COROUTINES */
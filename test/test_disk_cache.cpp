@@ -0,0 +1,285 @@
+#include "api.h"
+#include "boost_asio.h"
+#include "server.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+
+#include <unistd.h>
+
+using namespace testing;
+using namespace crequests;
+
+namespace {
+
+    /*
+      Answers one request per connection: /fresh is fresh for a minute,
+      /etag has to be revalidated and answers 304 to its ETag. Counts
+      the requests.
+    */
+    class disk_server_t {
+    public:
+        size_t hits() const {
+            return server.requests();
+        }
+
+        size_t not_modified() const {
+            return m_not_modified;
+        }
+
+    private:
+        bool serve(const scripted_server_t::received_t& request, tcp_socket_t& socket) {
+            string_t fields = "Cache-Control: max-age=60\r\n";
+            if (request.path == "/etag") {
+                if (request.field("If-None-Match") == "\"v1\"") {
+                    m_not_modified++;
+                    scripted_server_t::write(socket,
+                        "HTTP/1.1 304 Not Modified\r\nConnection: close\r\n"
+                        "Cache-Control: max-age=60\r\nETag: \"v1\"\r\n\r\n");
+                    return false;
+                }
+                fields = "Cache-Control: no-cache\r\nETag: \"v1\"\r\n";
+            }
+
+            scripted_server_t::write(socket,
+                "HTTP/1.1 200 OK\r\nConnection: close\r\n" + fields +
+                "Content-Length: " + std::to_string(request.path.size()) + "\r\n\r\n" + request.path);
+            return false;
+        }
+
+    private:
+        std::atomic<size_t> m_not_modified {0};
+        scripted_server_t server {8089, [this](const scripted_server_t::received_t& request, tcp_socket_t& socket) {
+            return serve(request, socket);
+        }};
+    };
+
+    /*
+      A fresh directory which is removed with the object.
+    */
+    class temp_directory_t {
+    public:
+        temp_directory_t()
+            : m_path{"/tmp/crequests_disk_cache_" + std::to_string(::getpid())}
+        {
+            remove();
+        }
+
+        ~temp_directory_t() {
+            remove();
+        }
+
+        const string_t& path() const {
+            return m_path;
+        }
+
+    private:
+        void remove() {
+            EXPECT_EQ(std::system(("rm -rf " + m_path).c_str()), 0);
+        }
+
+    private:
+        string_t m_path;
+    };
+
+    const string_t URL = "http://127.0.0.1:8089";
+
+    string_t to_string(const shared_body_t& body) {
+        return string_t(body.data(), body.size());
+    }
+
+} /* anonymous namespace */
+
+TEST(DiskCache, PutAndGet) {
+    temp_directory_t directory;
+    disk_cache_t cache;
+    EXPECT_FALSE(cache.enabled());
+    EXPECT_TRUE(cache.set_option(cache_directory_t{directory.path()}));
+    EXPECT_TRUE(cache.enabled());
+
+    EXPECT_TRUE(cache.put("a", "meta a", "body a", 6));
+    EXPECT_TRUE(cache.put("b", "meta b", "body b", 6));
+    EXPECT_TRUE(cache.put("a", "meta a2", "body a2", 7));
+    EXPECT_EQ(cache.count(), 2);
+
+    string_t meta;
+    shared_body_t body;
+    EXPECT_TRUE(cache.get("a", meta, body));
+    EXPECT_EQ(meta, "meta a2");
+    EXPECT_EQ(to_string(body), "body a2");
+    EXPECT_FALSE(cache.get("c", meta, body));
+
+    cache.erase("a");
+    EXPECT_FALSE(cache.get("a", meta, body));
+    EXPECT_EQ(cache.count(), 1);
+
+    /*
+      A body read before stays readable after it is dropped.
+    */
+    EXPECT_TRUE(cache.get("b", meta, body));
+    cache.clear();
+    EXPECT_EQ(cache.count(), 0);
+    EXPECT_EQ(to_string(body), "body b");
+}
+
+TEST(DiskCache, Reopen) {
+    temp_directory_t directory;
+    {
+        disk_cache_t cache;
+        EXPECT_TRUE(cache.set_option(cache_directory_t{directory.path()}));
+        EXPECT_TRUE(cache.put("a", "meta", "body", 4));
+
+        /*
+          The directory is locked by the first store.
+        */
+        disk_cache_t other;
+        EXPECT_FALSE(other.set_option(cache_directory_t{directory.path()}));
+        EXPECT_FALSE(other.enabled());
+    }
+
+    disk_cache_t cache;
+    EXPECT_TRUE(cache.set_option(cache_directory_t{directory.path()}));
+    string_t meta;
+    shared_body_t body;
+    EXPECT_TRUE(cache.get("a", meta, body));
+    EXPECT_EQ(to_string(body), "body");
+}
+
+TEST(DiskCache, Corruption) {
+    temp_directory_t directory;
+    {
+        disk_cache_t cache;
+        EXPECT_TRUE(cache.set_option(cache_directory_t{directory.path()}));
+        EXPECT_TRUE(cache.put("a", "meta", "body", 4));
+        EXPECT_TRUE(cache.put("b", "meta", "body", 4));
+    }
+
+    /*
+      The first record is overwritten and the second one is cut off.
+    */
+    {
+        std::fstream segment(directory.path() + "/segment.0",
+                             std::ios::in | std::ios::out | std::ios::binary);
+        segment.seekp(0);
+        segment.write("garbage", 7);
+    }
+    EXPECT_EQ(::truncate((directory.path() + "/segment.0").c_str(), 50), 0);
+
+    string_t meta;
+    shared_body_t body;
+    {
+        disk_cache_t cache;
+        EXPECT_TRUE(cache.set_option(cache_directory_t{directory.path()}));
+        EXPECT_FALSE(cache.get("a", meta, body));
+        EXPECT_FALSE(cache.get("b", meta, body));
+        EXPECT_EQ(cache.count(), 0);
+        EXPECT_TRUE(cache.put("c", "meta", "body", 4));
+    }
+
+    /*
+      An index which is not an index is made anew.
+    */
+    {
+        std::ofstream index(directory.path() + "/index", std::ios::binary | std::ios::trunc);
+        index << "not an index";
+    }
+
+    disk_cache_t cache;
+    EXPECT_TRUE(cache.set_option(cache_directory_t{directory.path()}));
+    EXPECT_EQ(cache.count(), 0);
+    EXPECT_FALSE(cache.get("c", meta, body));
+    EXPECT_TRUE(cache.put("c", "meta", "body", 4));
+    EXPECT_TRUE(cache.get("c", meta, body));
+}
+
+TEST(DiskCache, BodyCorruption) {
+    temp_directory_t directory;
+    string_t meta;
+    shared_body_t body;
+    {
+        disk_cache_t cache;
+        EXPECT_TRUE(cache.set_option(cache_directory_t{directory.path()}));
+        EXPECT_TRUE(cache.put("a", "meta", "body", 4));
+        EXPECT_TRUE(cache.get("a", meta, body));
+
+        /*
+          The last byte of the segment is the last byte of the body. A
+          record is checked once while the store is open, so the change
+          is seen only after it is opened again.
+        */
+        std::fstream segment(directory.path() + "/segment.0",
+                             std::ios::in | std::ios::out | std::ios::binary);
+        segment.seekp(-1, std::ios::end);
+        segment.write("X", 1);
+        segment.close();
+        EXPECT_TRUE(cache.get("a", meta, body));
+    }
+
+    disk_cache_t cache;
+    EXPECT_TRUE(cache.set_option(cache_directory_t{directory.path()}));
+    EXPECT_FALSE(cache.get("a", meta, body));
+    EXPECT_EQ(cache.count(), 0);
+}
+
+TEST(DiskCache, Eviction) {
+    temp_directory_t directory;
+    disk_cache_t cache;
+    cache.set_option(max_disk_cache_size_t{3 << 20});
+    EXPECT_TRUE(cache.set_option(cache_directory_t{directory.path()}));
+
+    const string_t large(300 << 10, 'x');
+    for (size_t i = 0; i < 20; ++i)
+        EXPECT_TRUE(cache.put(std::to_string(i), "meta", large.data(), large.size()));
+    EXPECT_LE(cache.size(), 3 << 20);
+
+    string_t meta;
+    shared_body_t body;
+    EXPECT_FALSE(cache.get("0", meta, body));
+    EXPECT_TRUE(cache.get("19", meta, body));
+    EXPECT_EQ(body.size(), large.size());
+
+    /*
+      A record larger than the store is not kept.
+    */
+    const string_t huge(4 << 20, 'x');
+    EXPECT_FALSE(cache.put("huge", "meta", huge.data(), huge.size()));
+}
+
+TEST(DiskCache, Service) {
+    disk_server_t server;
+    temp_directory_t directory;
+    {
+        service_t service;
+        EXPECT_TRUE(service.set_option(cache_directory_t{directory.path()}));
+        EXPECT_FALSE(Get(service, URL + "/fresh").from_cache().value());
+        EXPECT_EQ(Get(service, URL + "/etag").raw().value(), "/etag");
+        EXPECT_EQ(service.get_http_cache().count(), 0);
+        EXPECT_EQ(service.get_http_cache().get_disk_cache().count(), 2);
+    }
+
+    service_t service;
+    EXPECT_TRUE(service.set_option(cache_directory_t{directory.path()}));
+
+    const auto fresh = Get(service, URL + "/fresh");
+    EXPECT_TRUE(fresh.from_cache().value());
+    EXPECT_EQ(fresh.raw().value(), "/fresh");
+    EXPECT_EQ(server.hits(), 2);
+
+    const auto revalidated = Get(service, URL + "/etag");
+    EXPECT_TRUE(revalidated.from_cache().value());
+    EXPECT_EQ(revalidated.raw().value(), "/etag");
+    EXPECT_EQ(server.not_modified(), 1);
+
+    /*
+      The body callback is given the body of the cache.
+    */
+    string_t streamed;
+    const auto callback = [&streamed](const char* at, const size_t length, const crequests::error_t&) {
+        streamed.append(at, length);
+    };
+    EXPECT_TRUE(Get(service, URL + "/fresh", body_callback_t{callback}).from_cache().value());
+    EXPECT_EQ(streamed, "/fresh");
+    EXPECT_EQ(server.hits(), 3);
+}
@@ -0,0 +1,115 @@
+#include "api.h"
+#include "boost_asio.h"
+#include "server.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using namespace testing;
+using namespace crequests;
+
+namespace {
+
+    /*
+      The first connection is never answered, the next ones get a short
+      good response. When the first one fails, it is closed after a
+      while instead and the next ones are answered after a while too.
+    */
+    scripted_server_t::handler_t stalling(const bool fail_first = false) {
+        return [fail_first](const scripted_server_t::received_t& request, tcp_socket_t& socket) -> bool {
+            if (fail_first)
+                std::this_thread::sleep_for(milliseconds_t{request.connection == 0 ? 100 : 200});
+            if (request.connection == 0)
+                return not fail_first;
+
+            scripted_server_t::write(socket, "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok");
+            return true;
+        };
+    }
+
+} /* anonymous namespace */
+
+TEST(Hedging, SecondCopyWins) {
+    scripted_server_t server{8082, stalling()};
+
+    service_t service;
+    const auto started = steady_clock_t::now();
+    const auto response = Get(service, "http://127.0.0.1:8082/",
+                              hedge_delay_t{50}, total_timeout_t{2000});
+
+    EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(response.raw().value(), "ok");
+    EXPECT_TRUE(response.hedged().value());
+    EXPECT_EQ(response.request().hedge_delay().value(), 50);
+    EXPECT_LT(steady_clock_t::now() - started, milliseconds_t{1000});
+    EXPECT_EQ(server.accepted(), 2);
+}
+
+TEST(Hedging, OriginalFails) {
+    scripted_server_t server{8082, stalling(true)};
+
+    service_t service;
+    const auto response = Get(service, "http://127.0.0.1:8082/",
+                              hedge_delay_t{50}, total_timeout_t{2000});
+
+    EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(response.raw().value(), "ok");
+    EXPECT_TRUE(response.hedged().value());
+    EXPECT_EQ(server.accepted(), 2);
+}
+
+TEST(Hedging, OriginalFailsTimeout) {
+    scripted_server_t server{8082, stalling(true)};
+
+    service_t service;
+    const auto response = Get(service, "http://127.0.0.1:8082/",
+                              hedge_delay_t{50}, total_timeout_t{200});
+
+    EXPECT_EQ(response.error().code_to_string(), "TIMEOUT");
+    EXPECT_FALSE(response.hedged().value());
+}
+
+TEST(Hedging, NoBudget) {
+    scripted_server_t server{8082, stalling()};
+
+    service_t service;
+    service.set_option(hedge_budget_t{0});
+    const auto response = Get(service, "http://127.0.0.1:8082/",
+                              hedge_delay_t{50}, total_timeout_t{300});
+
+    EXPECT_EQ(response.error().code_to_string(), "TIMEOUT");
+    EXPECT_FALSE(response.hedged().value());
+    EXPECT_EQ(server.accepted(), 1);
+}
+
+TEST(Hedging, NotIdempotent) {
+    scripted_server_t server{8082, stalling()};
+
+    service_t service;
+    const auto response = Post(service, "http://127.0.0.1:8082/",
+                               hedge_delay_t{50}, total_timeout_t{300});
+
+    EXPECT_EQ(response.error().code_to_string(), "TIMEOUT");
+    EXPECT_EQ(server.accepted(), 1);
+}
+
+TEST(Hedging, Percentile) {
+    hedging_t hedging;
+    EXPECT_FALSE(hedging.percentile("a:80", 90));
+
+    for (size_t i = 1; i <= 100; ++i)
+        hedging.record("a:80", milliseconds_t{i});
+
+    EXPECT_EQ(*hedging.percentile("a:80", 90), milliseconds_t{91});
+    EXPECT_EQ(*hedging.percentile("a:80", 100), milliseconds_t{100});
+
+    hedging.set_option(hedge_budget_t{50});
+    size_t copies = 0;
+    for (size_t i = 0; i < 100; ++i) {
+        hedging.deposit();
+        if (hedging.withdraw())
+            copies++;
+    }
+    EXPECT_LE(copies, 60);
+    EXPECT_GE(copies, 40);
+}
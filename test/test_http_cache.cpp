@@ -0,0 +1,187 @@
+#include "api.h"
+#include "boost_asio.h"
+#include "server.h"
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+
+using namespace testing;
+using namespace crequests;
+
+namespace {
+
+    /*
+      Answers one request per connection by the path: /fresh is fresh
+      for a minute, /etag has to be revalidated and answers 304 to its
+      ETag (making itself fresh then), /etag/slow does the same but
+      answers the 304 after a while, /vary varies by X-Lang, /private
+      is private and /big/N has a body of a thousand bytes. Counts the
+      requests of every path.
+    */
+    class cache_server_t {
+    public:
+        size_t hits(const string_t& key) const {
+            return server.hits(key);
+        }
+
+        size_t not_modified() const {
+            return m_not_modified;
+        }
+
+    private:
+        bool serve(const scripted_server_t::received_t& request, tcp_socket_t& socket) {
+            const auto& path = request.path;
+            string_t fields = "Cache-Control: max-age=60\r\n";
+            string_t body = path;
+            if (path == "/etag" or path == "/etag/slow") {
+                if (request.field("If-None-Match") == "\"v1\"") {
+                    if (path == "/etag/slow")
+                        std::this_thread::sleep_for(milliseconds_t{300});
+                    m_not_modified++;
+                    scripted_server_t::write(socket,
+                        "HTTP/1.1 304 Not Modified\r\nConnection: close\r\n"
+                        "Cache-Control: max-age=60\r\nETag: \"v1\"\r\n\r\n");
+                    return false;
+                }
+                fields = "Cache-Control: no-cache\r\nETag: \"v1\"\r\n";
+            }
+            else if (path == "/vary") {
+                fields += "Vary: X-Lang\r\n";
+                body = request.field("X-Lang");
+            }
+            else if (path == "/private")
+                fields = "Cache-Control: private, max-age=60\r\n";
+            else if (path.find("/big/") == 0)
+                body = string_t(1000, 'x');
+
+            scripted_server_t::write(socket,
+                "HTTP/1.1 200 OK\r\nConnection: close\r\n" + fields +
+                "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body);
+            return false;
+        }
+
+    private:
+        std::atomic<size_t> m_not_modified {0};
+        scripted_server_t server {8088, [this](const scripted_server_t::received_t& request, tcp_socket_t& socket) {
+            return serve(request, socket);
+        }};
+    };
+
+    const string_t URL = "http://127.0.0.1:8088";
+
+} /* anonymous namespace */
+
+TEST(HttpCache, OffByDefault) {
+    cache_server_t server;
+    service_t service;
+
+    Get(service, URL + "/fresh");
+    Get(service, URL + "/fresh");
+    EXPECT_EQ(server.hits("GET /fresh"), 2);
+    EXPECT_EQ(service.get_http_cache().count(), 0);
+}
+
+TEST(HttpCache, FreshResponse) {
+    cache_server_t server;
+    service_t service;
+    service.set_option(max_cache_size_t{1 << 20});
+
+    const auto first = Get(service, URL + "/fresh");
+    EXPECT_FALSE(first.from_cache().value());
+
+    const auto second = Get(service, URL + "/fresh");
+    EXPECT_EQ(second.error().code_to_string(), "SUCCESS");
+    EXPECT_TRUE(second.from_cache().value());
+    EXPECT_EQ(second.status_code().value(), 200);
+    EXPECT_EQ(second.raw().value(), "/fresh");
+    EXPECT_EQ(second.headers().at("Age"), "0");
+    EXPECT_EQ(server.hits("GET /fresh"), 1);
+
+    /*
+      The request may ask for the response of the server.
+    */
+    const auto forced = Get(service, URL + "/fresh", headers_t{{"Cache-Control", "no-cache"}});
+    EXPECT_FALSE(forced.from_cache().value());
+    EXPECT_EQ(server.hits("GET /fresh"), 2);
+}
+
+TEST(HttpCache, Revalidation) {
+    cache_server_t server;
+    service_t service;
+    service.set_option(max_cache_size_t{1 << 20});
+
+    EXPECT_EQ(Get(service, URL + "/etag").raw().value(), "/etag");
+
+    const auto revalidated = Get(service, URL + "/etag");
+    EXPECT_EQ(server.not_modified(), 1);
+    EXPECT_TRUE(revalidated.from_cache().value());
+    EXPECT_EQ(revalidated.status_code().value(), 200);
+    EXPECT_EQ(revalidated.raw().value(), "/etag");
+
+    /*
+      The 304 made the response fresh for a minute.
+    */
+    const auto fresh = Get(service, URL + "/etag");
+    EXPECT_TRUE(fresh.from_cache().value());
+    EXPECT_EQ(server.hits("GET /etag"), 2);
+}
+
+TEST(HttpCache, DroppedWhileRevalidating) {
+    cache_server_t server;
+    service_t service;
+    service.set_option(max_cache_size_t{1 << 20});
+
+    EXPECT_EQ(Get(service, URL + "/etag/slow").raw().value(), "/etag/slow");
+
+    /*
+      The 304 is answered by the response the revalidation was sent for.
+    */
+    const auto revalidated = AsyncGet(service, URL + "/etag/slow");
+    std::this_thread::sleep_for(milliseconds_t{100});
+    service.get_http_cache().clear();
+
+    const auto response = revalidated.get();
+    EXPECT_EQ(server.not_modified(), 1);
+    EXPECT_TRUE(response.from_cache().value());
+    EXPECT_EQ(response.status_code().value(), 200);
+    EXPECT_EQ(response.raw().value(), "/etag/slow");
+    EXPECT_EQ(service.get_http_cache().count(), 1);
+}
+
+TEST(HttpCache, VaryPrivateAndUnsafeMethods) {
+    cache_server_t server;
+    service_t service;
+    service.set_option(max_cache_size_t{1 << 20});
+
+    for (size_t i = 0; i < 2; ++i) {
+        EXPECT_EQ(Get(service, URL + "/vary", headers_t{{"X-Lang", "en"}}).raw().value(), "en");
+        EXPECT_EQ(Get(service, URL + "/vary", headers_t{{"X-Lang", "ru"}}).raw().value(), "ru");
+    }
+    EXPECT_EQ(server.hits("GET /vary"), 2);
+
+    Get(service, URL + "/private");
+    Get(service, URL + "/private");
+    EXPECT_EQ(server.hits("GET /private"), 2);
+
+    Get(service, URL + "/fresh");
+    Post(service, URL + "/fresh", data_t{"x"}, gzip_t{false});
+    Get(service, URL + "/fresh");
+    EXPECT_EQ(server.hits("GET /fresh"), 2);
+}
+
+TEST(HttpCache, BoundedBySize) {
+    cache_server_t server;
+    service_t service;
+    service.set_option(max_cache_size_t{1500});
+
+    Get(service, URL + "/big/1");
+    Get(service, URL + "/big/2");
+    EXPECT_EQ(service.get_http_cache().count(), 1);
+    EXPECT_LE(service.get_http_cache().size(), 1500);
+
+    Get(service, URL + "/big/2");
+    Get(service, URL + "/big/1");
+    EXPECT_EQ(server.hits("GET /big/1"), 2);
+    EXPECT_EQ(server.hits("GET /big/2"), 1);
+}
@@ -0,0 +1,117 @@
+#include "api.h"
+#include "boost_asio.h"
+#include "server.h"
+#include "utils.h"
+#include "gtest/gtest.h"
+
+#include <future>
+#include <thread>
+
+using namespace testing;
+using namespace crequests;
+
+namespace {
+
+    /*
+      Serves requests on every connection until the client closes it.
+      Every response carries the given Keep-Alive header, and the
+      connection is dropped silently after a response if asked to.
+    */
+    scripted_server_t::handler_t keep_alive(const string_t& value, const bool drop) {
+        const string_t reply =
+            "HTTP/1.1 200 OK\r\n"
+            "Keep-Alive: " + value + "\r\n"
+            "Content-Length: 2\r\n\r\nok";
+        return [reply, drop](const scripted_server_t::received_t&, tcp_socket_t& socket) -> bool {
+            scripted_server_t::write(socket, reply);
+            return not drop;
+        };
+    }
+
+} /* anonymous namespace */
+
+TEST(KeepAlive, ParseHint) {
+    size_t timeout = 0;
+    size_t max = 100;
+    parse_keep_alive("timeout=5, max=1000", timeout, max);
+    EXPECT_EQ(timeout, 5);
+    EXPECT_EQ(max, 1000);
+
+    parse_keep_alive(" Timeout = 7 ,foo, max=-1", timeout, max);
+    EXPECT_EQ(timeout, 7);
+    EXPECT_EQ(max, 1000);
+}
+
+TEST(KeepAlive, ReusesSocket) {
+    scripted_server_t server{8085, keep_alive("timeout=5, max=100", false)};
+    {
+        service_t service;
+        auto& session = service.new_session("http://127.0.0.1:8085/", keep_alive_t{true});
+
+        for (size_t i = 0; i < 3; ++i)
+            EXPECT_EQ(session.Get().error().code_to_string(), "SUCCESS");
+        EXPECT_EQ(server.accepted(), 1);
+    }
+}
+
+TEST(KeepAlive, DroppedSocketIsNotWrittenTo) {
+    scripted_server_t server{8085, keep_alive("timeout=5", true)};
+    {
+        service_t service;
+        auto& session = service.new_session("http://127.0.0.1:8085/", keep_alive_t{true});
+
+        EXPECT_EQ(session.Get().error().code_to_string(), "SUCCESS");
+        std::this_thread::sleep_for(milliseconds_t{100});
+        EXPECT_EQ(session.Get().error().code_to_string(), "SUCCESS");
+        EXPECT_EQ(server.accepted(), 2);
+        EXPECT_EQ(server.requests(), 2);
+    }
+}
+
+TEST(KeepAlive, MaxRequests) {
+    scripted_server_t server{8085, keep_alive("timeout=5, max=0", false)};
+    {
+        service_t service;
+        auto& session = service.new_session("http://127.0.0.1:8085/", keep_alive_t{true});
+
+        EXPECT_EQ(session.Get().error().code_to_string(), "SUCCESS");
+        EXPECT_EQ(session.Get().error().code_to_string(), "SUCCESS");
+        std::this_thread::sleep_for(milliseconds_t{100});
+        EXPECT_EQ(server.accepted(), 2);
+        EXPECT_EQ(server.requests(), 2);
+        EXPECT_EQ(server.closed_by_client(), 2);
+    }
+}
+
+TEST(KeepAlive, IdleSocketIsClosed) {
+    scripted_server_t server{8085, keep_alive("timeout=1", false)};
+    {
+        service_t service;
+        auto& session = service.new_session("http://127.0.0.1:8085/", keep_alive_t{true});
+
+        EXPECT_EQ(session.Get().error().code_to_string(), "SUCCESS");
+        std::this_thread::sleep_for(milliseconds_t{800});
+        EXPECT_EQ(server.closed_by_client(), 1);
+
+        EXPECT_EQ(session.Get().error().code_to_string(), "SUCCESS");
+        EXPECT_EQ(server.accepted(), 2);
+    }
+}
+
+TEST(KeepAlive, SocketOfDetachedRequest) {
+    scripted_server_t server{8085, keep_alive("timeout=5, max=100", false)};
+    {
+        service_t service;
+        auto& session = service.new_session("http://127.0.0.1:8085/", keep_alive_t{true});
+
+        std::promise<string_t> done;
+        session.AsyncGet([&done](response_t&& response) {
+            done.set_value(response.error().code_to_string());
+        });
+        EXPECT_EQ(done.get_future().get(), "SUCCESS");
+
+        EXPECT_EQ(session.Get().error().code_to_string(), "SUCCESS");
+        EXPECT_EQ(server.accepted(), 1);
+        EXPECT_EQ(server.requests(), 2);
+    }
+}
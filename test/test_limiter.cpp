@@ -0,0 +1,210 @@
+#include "api.h"
+#include "boost_asio.h"
+#include "server.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using namespace testing;
+using namespace crequests;
+
+TEST(Limiter, GrantsInOrder) {
+    ioservice_t ioservice;
+    timer_wheel_t wheel{ioservice};
+    limiter_t limiter{wheel};
+    EXPECT_FALSE(limiter.enabled());
+
+    limiter.set_option(max_connections_t{2});
+    limiter.set_option(max_host_connections_t{1});
+    EXPECT_TRUE(limiter.enabled());
+
+    vector_t<string_t> granted;
+    const auto acquire = [&](const string_t& host) {
+        limiter_t::ticket_t ticket = 0;
+        return limiter.acquire(host, 0, time_point_t::max(), [&granted, host](const bool ok) {
+            if (ok)
+                granted.push_back(host);
+        }, ticket);
+    };
+
+    EXPECT_EQ(acquire("a"), limiter_t::admission_t::GRANTED);
+    EXPECT_EQ(acquire("a"), limiter_t::admission_t::QUEUED);
+
+    /*
+      The only slot of the host "a" is taken, so "b" is let through
+      by the global limit without waiting for the first waiter.
+    */
+    EXPECT_EQ(acquire("b"), limiter_t::admission_t::GRANTED);
+    EXPECT_EQ(acquire("c"), limiter_t::admission_t::QUEUED);
+    EXPECT_EQ(limiter.active(), 2);
+    EXPECT_EQ(limiter.queued(), 2);
+
+    limiter.set_option(max_connections_t{3});
+    EXPECT_EQ(granted, (vector_t<string_t>{"c"}));
+
+    limiter.release("a");
+    EXPECT_EQ(granted, (vector_t<string_t>{"c", "a"}));
+    EXPECT_EQ(limiter.active(), 3);
+    EXPECT_EQ(limiter.queued(), 0);
+}
+
+TEST(Limiter, CancelAndRejection) {
+    ioservice_t ioservice;
+    timer_wheel_t wheel{ioservice};
+    limiter_t limiter{wheel};
+    limiter.set_option(max_connections_t{1});
+    limiter.set_option(max_queue_size_t{1});
+
+    size_t calls = 0;
+    limiter_t::ticket_t ticket = 0;
+    const auto callback = [&calls](const bool) { calls++; };
+
+    EXPECT_EQ(limiter.acquire("a", 0, time_point_t::max(), callback, ticket), limiter_t::admission_t::GRANTED);
+    EXPECT_EQ(limiter.acquire("a", 0, time_point_t::max(), callback, ticket), limiter_t::admission_t::QUEUED);
+    limiter_t::ticket_t other = 0;
+    EXPECT_EQ(limiter.acquire("a", 0, time_point_t::max(), callback, other), limiter_t::admission_t::REJECTED);
+
+    EXPECT_TRUE(limiter.cancel(ticket));
+    EXPECT_FALSE(limiter.cancel(ticket));
+    limiter.release("a");
+    EXPECT_EQ(calls, 0);
+    EXPECT_EQ(limiter.active(), 0);
+}
+
+TEST(Limiter, PriorityAndDeadline) {
+    ioservice_t ioservice;
+    timer_wheel_t wheel{ioservice};
+    limiter_t limiter{wheel};
+    limiter.set_option(max_connections_t{1});
+
+    vector_t<size_t> granted;
+    const auto now = steady_clock_t::now();
+    const auto acquire = [&](const size_t n, const int priority, const time_point_t& deadline) {
+        limiter_t::ticket_t ticket = 0;
+        return limiter.acquire("a", priority, deadline, [&granted, n](const bool ok) {
+            if (ok)
+                granted.push_back(n);
+        }, ticket);
+    };
+
+    EXPECT_EQ(acquire(0, 0, now), limiter_t::admission_t::GRANTED);
+    acquire(1, -1, now);
+    acquire(2, 0, now + seconds_t{2});
+    acquire(3, 0, now + seconds_t{1});
+    acquire(4, 5, now + seconds_t{3});
+    acquire(5, 0, now + seconds_t{1});
+
+    for (size_t i = 0; i < 5; ++i)
+        limiter.release("a");
+
+    EXPECT_EQ(granted, (vector_t<size_t>{4, 3, 5, 2, 1}));
+}
+
+TEST(Limiter, QueueTime) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    service.set_option(max_connections_t{1});
+
+    auto first = AsyncGet(service, "http://127.0.0.1:8080/delay/1");
+    auto second = AsyncGet(service, "http://127.0.0.1:8080/");
+
+    const auto first_response = first.get();
+    const auto second_response = second.get();
+
+    EXPECT_EQ(first_response.error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(second_response.error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(first_response.queue_time().value(), 0);
+    EXPECT_GE(first_response.network_time().value(), 900);
+    EXPECT_GE(second_response.queue_time().value(), 900);
+    EXPECT_LT(second_response.network_time().value(), 900);
+    EXPECT_EQ(service.get_limiter().active(), 0);
+
+    server.stop();
+    thread.join();
+}
+
+TEST(Limiter, InlineQueued) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    service.set_option(max_connections_t{1});
+
+    /*
+      The grant comes from the service thread, while the caller runs
+      the io service of the inline request.
+    */
+    auto first = AsyncGet(service, "http://127.0.0.1:8080/delay/1");
+    std::this_thread::sleep_for(milliseconds_t{100});
+    const auto second = Get(service, "http://127.0.0.1:8080/", timeout_t{5}, inline_io_t{true});
+
+    EXPECT_EQ(second.error().code_to_string(), "SUCCESS");
+    EXPECT_GE(second.queue_time().value(), 800);
+    EXPECT_EQ(first.get().error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(service.get_limiter().active(), 0);
+
+    server.stop();
+    thread.join();
+}
+
+TEST(Limiter, QueueFull) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    service.set_option(max_host_connections_t{1});
+    service.set_option(max_queue_size_t{0});
+
+    auto first = AsyncGet(service, "http://127.0.0.1:8080/delay/1");
+    const auto second = Get(service, "http://127.0.0.1:8080/");
+
+    EXPECT_EQ(second.error().code_to_string(), "QUEUE_FULL");
+    EXPECT_EQ(first.get().error().code_to_string(), "SUCCESS");
+
+    server.stop();
+    thread.join();
+}
+
+TEST(Limiter, QueueTimeout) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    service.set_option(max_connections_t{1});
+    service.set_option(max_queue_time_t{100});
+
+    auto first = AsyncGet(service, "http://127.0.0.1:8080/delay/1");
+    const auto second = Get(service, "http://127.0.0.1:8080/");
+
+    EXPECT_EQ(second.error().code_to_string(), "QUEUE_TIMEOUT");
+    EXPECT_EQ(first.get().error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(service.get_limiter().queued(), 0);
+
+    server.stop();
+    thread.join();
+}
+
+TEST(Limiter, AdaptiveConcurrency) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    service.set_option(adaptive_concurrency_t{true});
+    auto& limiter = service.get_limiter();
+    const auto initial = limiter.host_limit("127.0.0.1:8080");
+
+    for (size_t i = 0; i < 3; ++i)
+        EXPECT_EQ(Get(service, "http://127.0.0.1:8080/").error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(limiter.host_limit("127.0.0.1:8080"), initial);
+    EXPECT_EQ(limiter.host_limits().count("127.0.0.1:8080"), 0);
+
+    const auto response = Get(service, "http://127.0.0.1:8080/delay/1", total_timeout_t{100});
+    EXPECT_EQ(response.error().code_to_string(), "TIMEOUT");
+    EXPECT_LT(limiter.host_limit("127.0.0.1:8080"), initial);
+    EXPECT_EQ(limiter.host_limits().count("127.0.0.1:8080"), 1);
+
+    server.stop();
+    thread.join();
+}
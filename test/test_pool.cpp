@@ -0,0 +1,118 @@
+#include "api.h"
+#include "server.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using namespace testing;
+using namespace crequests;
+
+TEST(Pool, Preconnect) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    EXPECT_EQ(service.preconnect("http://127.0.0.1:8080/", 3).get(), 3);
+    EXPECT_EQ(service.get_pool().size("http://127.0.0.1:8080"), 3);
+
+    const auto response = Get(service, "http://127.0.0.1:8080/");
+    EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(response.status_code().value(), 200);
+    EXPECT_EQ(service.get_pool().size(), 2);
+
+    /*
+      Other origins do not take the parked connections.
+    */
+    EXPECT_EQ(Get(service, "http://localhost:8080/").error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(service.get_pool().size(), 2);
+
+    server.stop();
+    thread.join();
+}
+
+TEST(Pool, PreconnectSsl) {
+    server_t server{"127.0.0.1", "4433", true};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    auto& session = service.new_session("https://127.0.0.1:4433/get_big_until_eof");
+    EXPECT_EQ(session.preconnect(1).get(), 1);
+
+    const auto response = session.Get();
+    EXPECT_EQ(response.error().code(), error_code_t::SUCCESS);
+    EXPECT_EQ(response.raw().value().size(), 10000);
+    EXPECT_EQ(service.get_pool().size(), 0);
+
+    server.stop();
+    thread.join();
+}
+
+TEST(Pool, SslSettings) {
+    server_t server{"127.0.0.1", "4433", true};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    EXPECT_EQ(service.preconnect("https://127.0.0.1:4433/", 1).get(), 1);
+
+    /*
+      The parked connection has not checked the certificate, so it does
+      not serve a request which has to. The server certificate is self
+      signed, so its own handshake fails.
+    */
+    const auto verified = Get(service, "https://127.0.0.1:4433/", always_verify_peer_t{true});
+    EXPECT_EQ(verified.error().code_to_string(), "HANDSHAKE_ERROR");
+    EXPECT_EQ(service.get_pool().size(), 1);
+
+    EXPECT_EQ(Get(service, "https://127.0.0.1:4433/").error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(service.get_pool().size(), 0);
+
+    server.stop();
+    thread.join();
+}
+
+TEST(Pool, Limits) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    service.set_option(max_idle_connections_t{1});
+    EXPECT_EQ(service.preconnect("http://127.0.0.1:8080/", 2).get(), 1);
+    EXPECT_EQ(service.get_pool().size(), 1);
+
+    service.set_option(max_idle_time_t{0});
+    EXPECT_EQ(Get(service, "http://127.0.0.1:8080/").error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(service.get_pool().size(), 0);
+
+    EXPECT_EQ(service.preconnect("http://127.0.0.1:8084/", 2).get(), 0);
+
+    server.stop();
+    thread.join();
+}
+
+TEST(Pool, Sweep) {
+    server_t server{"127.0.0.1", "8080"};
+    std::thread thread([&server](){server.run();});
+
+    service_t service;
+    service.set_option(max_idle_time_t{100});
+    EXPECT_EQ(service.preconnect("http://127.0.0.1:8080/", 2).get(), 2);
+    EXPECT_EQ(service.get_pool().size(), 2);
+
+    /*
+      Nobody takes the connections, the timer drops them.
+    */
+    std::this_thread::sleep_for(milliseconds_t{300});
+    EXPECT_EQ(service.get_pool().size(), 0);
+
+    /*
+      A new idle time rearms the timer for the parked connections.
+    */
+    service.set_option(max_idle_time_t{10000});
+    EXPECT_EQ(service.preconnect("http://127.0.0.1:8080/", 2).get(), 2);
+    service.set_option(max_idle_time_t{100});
+    std::this_thread::sleep_for(milliseconds_t{300});
+    EXPECT_EQ(service.get_pool().size(), 0);
+
+    server.stop();
+    thread.join();
+}
@@ -0,0 +1,208 @@
+#include "api.h"
+#include "boost_asio.h"
+#include "server.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using namespace testing;
+using namespace crequests;
+
+namespace {
+
+    string_t redirect(const string_t& status,
+                      const string_t& location,
+                      const string_t& extra = "") {
+        return
+            "HTTP/1.1 " + status + " Moved\r\n"
+            "Location: " + location + "\r\n" + extra +
+            "Connection: close\r\n"
+            "Content-Length: 0\r\n\r\n";
+    }
+
+    /*
+      Answers one request per connection by the path: /301, /302, /303,
+      /307 and /308 redirect to /target with that status, /chain makes
+      two permanent hops, /no-store and /max-age are a 301 and a 302
+      with these Cache-Control directives and /target tells the method
+      and the body it got.
+    */
+    bool moved(const scripted_server_t::received_t& request, tcp_socket_t& socket) {
+        const auto& path = request.path;
+        string_t reply;
+        if (path == "/chain")
+            reply = redirect("301", "/301");
+        else if (path == "/no-store")
+            reply = redirect("301", "/target", "Cache-Control: no-store\r\n");
+        else if (path == "/max-age")
+            reply = redirect("302", "/target", "Cache-Control: max-age=60\r\n");
+        else if (path == "/target") {
+            const auto content = request.method + " " + request.body;
+            reply =
+                "HTTP/1.1 200 OK\r\nConnection: close\r\n"
+                "Content-Length: " + std::to_string(content.size()) + "\r\n\r\n" + content;
+        }
+        else
+            reply = redirect(path.substr(1), "/target");
+
+        scripted_server_t::write(socket, reply);
+        return false;
+    }
+
+} /* anonymous namespace */
+
+TEST(RedirectCache, LruAndTtl) {
+    redirect_cache_t cache;
+    cache.set_option(max_cached_redirects_t{2});
+    cache.set_option(temporary_redirect_ttl_t{50});
+
+    string_t location;
+    unsigned int status = 0;
+
+    cache.put("a", "b", 301);
+    cache.put("b", "c", 308);
+    EXPECT_TRUE(cache.find("a", location, status));
+    EXPECT_EQ(location, "b");
+    EXPECT_EQ(status, 301);
+
+    /*
+      "b" is the least recently used one now.
+    */
+    cache.put("c", "d", 302);
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_FALSE(cache.find("b", location, status));
+    EXPECT_TRUE(cache.find("c", location, status));
+
+    std::this_thread::sleep_for(milliseconds_t{100});
+    EXPECT_FALSE(cache.find("c", location, status));
+    EXPECT_TRUE(cache.find("a", location, status));
+
+    /*
+      Not cacheable statuses and redirects to itself are not kept and
+      a url which is not moved any more is forgotten.
+    */
+    cache.put("x", "y", 200);
+    cache.put("y", "y", 301);
+    EXPECT_EQ(cache.size(), 1);
+    cache.put("a", "b", 200);
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(RedirectCache, PermanentRedirectIsSkipped) {
+    scripted_server_t server{8087, moved};
+    service_t service;
+
+    for (size_t i = 0; i < 3; ++i) {
+        const auto response = Get(service, "http://127.0.0.1:8087/chain");
+        EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+        EXPECT_EQ(response.raw().value(), "GET ");
+        EXPECT_EQ(response.request().uri().path().value(), "/target");
+    }
+
+    EXPECT_EQ(server.hits("/chain"), 1);
+    EXPECT_EQ(server.hits("/301"), 1);
+    EXPECT_EQ(server.hits("/target"), 3);
+    EXPECT_EQ(service.get_redirect_cache().size(), 2);
+
+    /*
+      A request may opt out of the cache.
+    */
+    Get(service, "http://127.0.0.1:8087/chain", cache_redirects_t{false});
+    EXPECT_EQ(server.hits("/chain"), 2);
+}
+
+TEST(RedirectCache, TemporaryRedirectIsNotCachedByDefault) {
+    scripted_server_t server{8087, moved};
+    service_t service;
+
+    Get(service, "http://127.0.0.1:8087/302");
+    Get(service, "http://127.0.0.1:8087/302");
+    EXPECT_EQ(server.hits("/302"), 2);
+
+    service.set_option(temporary_redirect_ttl_t{60000});
+    Get(service, "http://127.0.0.1:8087/307");
+    Get(service, "http://127.0.0.1:8087/307");
+    EXPECT_EQ(server.hits("/307"), 1);
+}
+
+TEST(RedirectCache, CacheControl) {
+    scripted_server_t server{8087, moved};
+    service_t service;
+
+    Get(service, "http://127.0.0.1:8087/no-store");
+    Get(service, "http://127.0.0.1:8087/no-store");
+    EXPECT_EQ(server.hits("/no-store"), 2);
+
+    Get(service, "http://127.0.0.1:8087/max-age");
+    Get(service, "http://127.0.0.1:8087/max-age");
+    EXPECT_EQ(server.hits("/max-age"), 1);
+
+    redirect_cache_t cache;
+    cache.put("a", "b", 301, headers_t{{"Cache-Control", "max-age=0"}});
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(RedirectCache, Methods) {
+    scripted_server_t server{8087, moved};
+    service_t service;
+    service.set_option(max_cached_redirects_t{0});
+
+    const auto post = [&service](const string_t& path) {
+        return Post(service, "http://127.0.0.1:8087" + path, data_t{"hello"}, gzip_t{false}).raw().value();
+    };
+
+    EXPECT_EQ(post("/301"), "GET ");
+    EXPECT_EQ(post("/302"), "GET ");
+    EXPECT_EQ(post("/303"), "GET ");
+    EXPECT_EQ(post("/307"), "POST hello");
+    EXPECT_EQ(post("/308"), "POST hello");
+
+    const auto put = Put(service, "http://127.0.0.1:8087/301", data_t{"hello"}, gzip_t{false});
+    EXPECT_EQ(put.raw().value(), "PUT hello");
+    EXPECT_EQ(service.get_redirect_cache().size(), 0);
+}
+
+TEST(RedirectCache, CachedPermanentRedirectKeepsMethod) {
+    scripted_server_t server{8087, moved};
+    service_t service;
+
+    Post(service, "http://127.0.0.1:8087/308", data_t{"hello"}, gzip_t{false});
+    const auto response = Post(service, "http://127.0.0.1:8087/308", data_t{"again"}, gzip_t{false});
+    EXPECT_EQ(response.raw().value(), "POST again");
+    EXPECT_EQ(server.hits("/308"), 1);
+}
+
+TEST(RedirectCache, History) {
+    scripted_server_t server{8087, moved};
+    service_t service;
+
+    const auto response = Get(service, "http://127.0.0.1:8087/chain", cache_redirects_t{false});
+    const auto& hops = response.redirects().get();
+    ASSERT_EQ(hops.size(), 2);
+    EXPECT_EQ(hops[0].url, "http://127.0.0.1:8087/chain");
+    EXPECT_EQ(hops[0].status, 301);
+    EXPECT_EQ(hops[0].location, "http://127.0.0.1:8087/301");
+    EXPECT_EQ(hops[1].url, "http://127.0.0.1:8087/301");
+    EXPECT_EQ(hops[1].location, "http://127.0.0.1:8087/target");
+    EXPECT_EQ(response.redirects().responses().size(), 0);
+
+    const auto full = Get(service, "http://127.0.0.1:8087/chain",
+                          cache_redirects_t{false}, keep_redirect_responses_t{true});
+    ASSERT_EQ(full.redirects().responses().size(), 2);
+    EXPECT_EQ(full.redirects().responses()[1].status_code().value(), 301);
+    EXPECT_EQ(full.redirects().responses()[1].headers().at("Location"), "/target");
+
+    /*
+      The cached hops are a part of the history too.
+    */
+    Get(service, "http://127.0.0.1:8087/chain");
+    const auto cached = Get(service, "http://127.0.0.1:8087/chain");
+    EXPECT_EQ(cached.redirect_count().value(), 2);
+    ASSERT_EQ(cached.redirects().get().size(), 2);
+    EXPECT_EQ(cached.redirects().get()[0].url, "http://127.0.0.1:8087/chain");
+    EXPECT_EQ(cached.redirects().get()[1].location, "http://127.0.0.1:8087/target");
+    EXPECT_EQ(server.hits("/chain"), 3);
+
+    const auto limited = Get(service, "http://127.0.0.1:8087/chain", redirect_count_t{1});
+    EXPECT_EQ(limited.error().code_to_string(), "REDIRECT_EXHAUSTED");
+}
@@ -0,0 +1,183 @@
+#include "api.h"
+#include "boost_asio.h"
+#include "server.h"
+#include "gtest/gtest.h"
+
+#include <mutex>
+#include <thread>
+
+using namespace testing;
+using namespace crequests;
+
+namespace {
+
+    string_t redirect(const string_t& location, const string_t& extra) {
+        return
+            "HTTP/1.1 302 Found\r\n"
+            "Location: " + location + "\r\n" + extra +
+            "Content-Length: 5\r\n\r\nmoved";
+    }
+
+    /*
+      Keeps every connection alive and answers by the path:
+      /relative and /absolute redirect to /target of the same origin,
+      /close does the same but closes the connection, /other redirects
+      to another origin and never sends the whole body of the redirect,
+      /slow redirects there too and sends its body in two parts, /chunked
+      redirects to /target with a chunked body, which is too large to be
+      read when it is longer than its first chunk header.
+    */
+    class redirect_server_t {
+    public:
+        size_t accepted() const {
+            return server.accepted();
+        }
+
+        vector_t<time_point_t> accepted_at() const {
+            return server.accepted_at();
+        }
+
+        time_point_t body_sent_at() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return m_body_sent_at;
+        }
+
+    private:
+        bool serve(const scripted_server_t::received_t& request, tcp_socket_t& socket) {
+            const auto& path = request.path;
+            string_t reply;
+            bool close = false;
+            if (path == "/relative")
+                reply = redirect("/target", "");
+            else if (path == "/absolute")
+                reply = redirect("http://127.0.0.1:8086/target", "");
+            else if (path == "/close") {
+                reply = redirect("/target", "Connection: close\r\n");
+                close = true;
+            }
+            else if (path == "/other")
+                reply =
+                    "HTTP/1.1 302 Found\r\n"
+                    "Location: http://localhost:8086/target\r\n"
+                    "Content-Length: 1000000\r\n\r\npartial";
+            else if (path == "/chunked")
+                reply =
+                    "HTTP/1.1 302 Found\r\n"
+                    "Location: /target\r\n"
+                    "Transfer-Encoding: chunked\r\n\r\n"
+                    "5\r\nmoved\r\n0\r\n\r\n";
+            else if (path == "/chunked_large")
+                reply =
+                    "HTTP/1.1 302 Found\r\n"
+                    "Location: /target\r\n"
+                    "Transfer-Encoding: chunked\r\n\r\n"
+                    "5\r\nmoved\r\n100000\r\npartial";
+            else if (path == "/slow") {
+                scripted_server_t::write(socket,
+                    "HTTP/1.1 302 Found\r\n"
+                    "Location: http://localhost:8086/target\r\n"
+                    "Content-Length: 10\r\n\r\nmoved");
+                std::this_thread::sleep_for(milliseconds_t{300});
+                reply = "moved";
+                std::lock_guard<std::mutex> lock(mutex);
+                m_body_sent_at = steady_clock_t::now();
+            }
+            else
+                reply = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+
+            scripted_server_t::write(socket, reply);
+            return not close;
+        }
+
+    private:
+        mutable std::mutex mutex {};
+        time_point_t m_body_sent_at {};
+        scripted_server_t server {8086, [this](const scripted_server_t::received_t& request, tcp_socket_t& socket) {
+            return serve(request, socket);
+        }};
+    };
+
+} /* anonymous namespace */
+
+TEST(RedirectConnection, SameOriginReusesSocket) {
+    redirect_server_t server;
+    {
+        service_t service;
+
+        auto response = Get(service, "http://127.0.0.1:8086/relative");
+        EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+        EXPECT_EQ(response.raw().value(), "ok");
+        EXPECT_EQ(response.redirect_count().value(), 1);
+        EXPECT_EQ(server.accepted(), 1);
+
+        response = Get(service, "http://127.0.0.1:8086/absolute");
+        EXPECT_EQ(response.raw().value(), "ok");
+        EXPECT_EQ(server.accepted(), 2);
+    }
+}
+
+TEST(RedirectConnection, ClosedSocketIsNotReused) {
+    redirect_server_t server;
+    {
+        service_t service;
+
+        const auto response = Get(service, "http://127.0.0.1:8086/close");
+        EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+        EXPECT_EQ(response.raw().value(), "ok");
+        EXPECT_EQ(server.accepted(), 2);
+    }
+}
+
+TEST(RedirectConnection, LargeChunkedBodyIsNotDrained) {
+    redirect_server_t server;
+    {
+        service_t service;
+
+        auto response = Get(service, "http://127.0.0.1:8086/chunked");
+        EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+        EXPECT_EQ(response.raw().value(), "ok");
+        EXPECT_EQ(server.accepted(), 1);
+
+        /*
+          The redirect does not wait for the rest of the body, it goes
+          on with a new connection.
+        */
+        response = Get(service, "http://127.0.0.1:8086/chunked_large", total_timeout_t{2000});
+        EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+        EXPECT_EQ(response.raw().value(), "ok");
+        EXPECT_EQ(server.accepted(), 3);
+    }
+}
+
+TEST(RedirectConnection, OtherOriginSkipsBody) {
+    redirect_server_t server;
+    {
+        service_t service;
+
+        const auto response = Get(service, "http://127.0.0.1:8086/other", total_timeout_t{2000});
+        EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+        EXPECT_EQ(response.raw().value(), "ok");
+        EXPECT_EQ(server.accepted(), 2);
+    }
+}
+
+TEST(RedirectConnection, OtherOriginIsSetUpWhileBodyIsRead) {
+    redirect_server_t server;
+    {
+        service_t service;
+
+        const auto response = Get(service, "http://127.0.0.1:8086/slow");
+        EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+        EXPECT_EQ(response.raw().value(), "ok");
+        EXPECT_EQ(response.redirect_count().value(), 1);
+
+        const auto accepted_at = server.accepted_at();
+        ASSERT_EQ(accepted_at.size(), 2);
+        EXPECT_LT(accepted_at[1], server.body_sent_at());
+
+        /*
+          The socket of the redirect is kept for its own origin.
+        */
+        EXPECT_EQ(service.get_pool().size("http://127.0.0.1:8086"), 1);
+    }
+}
@@ -13,26 +13,26 @@ TEST(Redirects, PrepareDefaultAndFindRequest) {
     request.url("google.com"_url);
     request.prepare();
 
-    redirects.add(response_t{request});
-    EXPECT_EQ(redirects.get().size(), 1);
-
-    redirects.add(response_t{request});
-    EXPECT_EQ(redirects.get().size(), 1);
-
-    request.url("youtube.com"_url);
-    request.prepare();
-    redirects.add(response_t{request});
+    redirects.add(hop_t{"http://google.com:80/", 301, "http://www.google.com/", milliseconds_t{5}});
+    redirects.add(hop_t{"http://www.google.com:80/", 302, "http://youtube.com/", milliseconds_t{7}});
     EXPECT_EQ(redirects.get().size(), 2);
+    EXPECT_EQ(redirects.responses().size(), 0);
 
-    EXPECT_NE(redirects.find(request), boost::none);
+    ASSERT_TRUE(redirects.find(request));
+    EXPECT_EQ(*redirects.find(request), string_t{"http://youtube.com/"});
 
-    request.url("google.com"_url);
+    request.url("www.google.com"_url);
     request.prepare();
 
-    EXPECT_NE(redirects.find(request), boost::none);
+    ASSERT_TRUE(redirects.find(request));
+    EXPECT_EQ(*redirects.find(request), string_t{"http://youtube.com/"});
 
     request.url("goooogle.com"_url);
     request.prepare();
 
-    EXPECT_EQ(redirects.find(request), boost::none);
+    EXPECT_FALSE(redirects.find(request));
+
+    redirects.add(response_t{request});
+    EXPECT_EQ(redirects.responses().size(), 1);
+    EXPECT_EQ(redirects.get().size(), 2);
 }
@@ -0,0 +1,129 @@
+#include "api.h"
+#include "boost_asio.h"
+#include "server.h"
+#include "gtest/gtest.h"
+
+using namespace testing;
+using namespace crequests;
+
+namespace {
+
+    /*
+      Answers every connection with the next reply of the list and
+      closes it.
+    */
+    scripted_server_t::handler_t in_turn(const vector_t<string_t>& replies) {
+        return [replies](const scripted_server_t::received_t& request, tcp_socket_t& socket) -> bool {
+            if (request.connection < replies.size())
+                scripted_server_t::write(socket, replies[request.connection]);
+            return false;
+        };
+    }
+
+    const string_t UNAVAILABLE =
+        "HTTP/1.1 503 Service Unavailable\r\nConnection: close\r\nContent-Length: 0\r\n\r\n";
+    const string_t OK =
+        "HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 2\r\n\r\nok";
+
+} /* anonymous namespace */
+
+TEST(Retry, Policy) {
+    const retry_policy_t none;
+    EXPECT_TRUE(none.empty());
+
+    auto policy = retry_policy_t{3}.backoff(milliseconds_t{10}, milliseconds_t{50});
+    EXPECT_EQ(policy.retries(), 3);
+    EXPECT_TRUE(policy.retries_status(503));
+    EXPECT_FALSE(policy.retries_status(500));
+    EXPECT_TRUE(policy.retries_error(error_code_t::CONNECT_ERROR));
+    EXPECT_FALSE(policy.retries_error(error_code_t::CANCELLED));
+    EXPECT_TRUE(policy.retries_method("get"));
+    EXPECT_FALSE(policy.retries_method("POST"));
+
+    for (size_t i = 0; i < 100; ++i) {
+        EXPECT_LE(policy.delay(0).count(), 10);
+        EXPECT_LE(policy.delay(10).count(), 50);
+    }
+
+    policy.statuses({500}).methods({"post"});
+    EXPECT_TRUE(policy.retries_status(500));
+    EXPECT_FALSE(policy.retries_status(503));
+    EXPECT_TRUE(policy.retries_method("POST"));
+    EXPECT_FALSE(policy.retries_method("GET"));
+}
+
+TEST(Retry, UnavailableThenOk) {
+    scripted_server_t server{8083, in_turn({UNAVAILABLE, UNAVAILABLE, OK})};
+
+    service_t service;
+    const auto response = Get(service, "http://127.0.0.1:8083/",
+                              retry_policy_t{3}.backoff(milliseconds_t{10}, milliseconds_t{50}));
+
+    EXPECT_EQ(response.error().code_to_string(), "SUCCESS");
+    EXPECT_EQ(response.status_code().value(), 200);
+    EXPECT_EQ(response.raw().value(), "ok");
+    EXPECT_EQ(response.retries().value(), 2);
+}
+
+TEST(Retry, Exhausted) {
+    scripted_server_t server{8083, in_turn({UNAVAILABLE, UNAVAILABLE})};
+
+    service_t service;
+    const auto response = Get(service, "http://127.0.0.1:8083/",
+                              retry_policy_t{1}.backoff(milliseconds_t{10}, milliseconds_t{50}));
+
+    EXPECT_EQ(response.status_code().value(), 503);
+    EXPECT_EQ(response.retries().value(), 1);
+}
+
+TEST(Retry, SentPostIsNotRetried) {
+    scripted_server_t server{8083, in_turn({UNAVAILABLE})};
+
+    service_t service;
+    const auto response = Post(service, "http://127.0.0.1:8083/",
+                               retry_policy_t{3}.backoff(milliseconds_t{10}, milliseconds_t{50}));
+
+    EXPECT_EQ(response.status_code().value(), 503);
+    EXPECT_EQ(response.retries().value(), 0);
+}
+
+TEST(Retry, ConnectErrorAndDeadline) {
+    service_t service;
+
+    const auto refused = Post(service, "http://127.0.0.1:8084/",
+                              retry_policy_t{2}.backoff(milliseconds_t{10}, milliseconds_t{50}));
+    EXPECT_EQ(refused.error().code_to_string(), "CONNECT_ERROR");
+    EXPECT_EQ(refused.retries().value(), 2);
+
+    /*
+      A retry which would start after the total timeout is not made.
+    */
+    const auto started = steady_clock_t::now();
+    const auto late = Get(service, "http://127.0.0.1:8084/",
+                          total_timeout_t{200},
+                          retry_policy_t{5}.backoff(seconds_t{10}, seconds_t{10}));
+    EXPECT_LT(steady_clock_t::now() - started, milliseconds_t{500});
+    EXPECT_NE(late.error().code_to_string(), "SUCCESS");
+}
+
+TEST(Retry, Budget) {
+    service_t service;
+    service.set_option(retry_budget_t{0});
+
+    const auto response = Get(service, "http://127.0.0.1:8084/",
+                              retry_policy_t{3}.backoff(milliseconds_t{10}, milliseconds_t{50}));
+    EXPECT_EQ(response.error().code_to_string(), "CONNECT_ERROR");
+    EXPECT_EQ(response.retries().value(), 0);
+}
+
+TEST(Retry, InlineIo) {
+    scripted_server_t server{8083, in_turn({UNAVAILABLE, OK})};
+
+    service_t service;
+    const auto response = Get(service, "http://127.0.0.1:8083/",
+                              inline_io_t{true},
+                              retry_policy_t{2}.backoff(milliseconds_t{10}, milliseconds_t{50}));
+
+    EXPECT_EQ(response.status_code().value(), 200);
+    EXPECT_EQ(response.retries().value(), 1);
+}
@@ -0,0 +1,41 @@
+#include "throttle.h"
+#include "gtest/gtest.h"
+
+using namespace testing;
+using namespace crequests;
+
+TEST(TokenBucket, Unlimited) {
+    token_bucket_t bucket;
+    const auto now = steady_clock_t::now();
+    EXPECT_EQ(bucket.consume(1000000, now), milliseconds_t{0});
+    EXPECT_TRUE(bucket.idle(now));
+}
+
+TEST(TokenBucket, Debt) {
+    token_bucket_t bucket{1000};
+    const auto now = steady_clock_t::now();
+
+    EXPECT_EQ(bucket.consume(1000, now), milliseconds_t{0});
+    EXPECT_EQ(bucket.consume(500, now), milliseconds_t{500});
+    EXPECT_EQ(bucket.consume(500, now), milliseconds_t{1000});
+    EXPECT_FALSE(bucket.idle(now));
+
+    EXPECT_EQ(bucket.consume(0, now + milliseconds_t{1000}), milliseconds_t{0});
+    EXPECT_TRUE(bucket.idle(now + milliseconds_t{2000}));
+}
+
+TEST(Throttle, HostsAndQuota) {
+    throttle_t throttle;
+    EXPECT_FALSE(throttle.enabled());
+    EXPECT_EQ(throttle.consume("a:80", 100000), milliseconds_t{0});
+
+    throttle.set_option(host_bandwidth_t{1000});
+    EXPECT_TRUE(throttle.enabled());
+
+    EXPECT_EQ(throttle.consume("a:80", 1000), milliseconds_t{0});
+    EXPECT_GT(throttle.consume("a:80", 1000), milliseconds_t{900});
+    EXPECT_EQ(throttle.consume("b:80", 1000), milliseconds_t{0});
+
+    throttle.set_option(read_quota_t{512});
+    EXPECT_EQ(throttle.read_quota(), 512);
+}
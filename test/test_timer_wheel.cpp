@@ -0,0 +1,88 @@
+#include "boost_asio.h"
+#include "timer_wheel.h"
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using namespace testing;
+using namespace crequests;
+
+TEST(TimerWheel, FiresInOrder) {
+    ioservice_t ioservice;
+    timer_wheel_t wheel{ioservice};
+
+    const auto started = steady_clock_t::now();
+    vector_t<std::pair<size_t, milliseconds_t> > fired;
+    const auto schedule = [&](const size_t n, const size_t ms) {
+        wheel.schedule(milliseconds_t{ms}, [&fired, &started, n]() {
+            fired.emplace_back(n, std::chrono::duration_cast<milliseconds_t>(
+                                   steady_clock_t::now() - started));
+        });
+    };
+
+    schedule(3, 300);
+    schedule(1, 5);
+    schedule(2, 70);
+    EXPECT_EQ(wheel.size(), 3);
+
+    ioservice.run();
+
+    ASSERT_EQ(fired.size(), 3);
+    EXPECT_EQ(fired[0].first, 1);
+    EXPECT_EQ(fired[1].first, 2);
+    EXPECT_EQ(fired[2].first, 3);
+    EXPECT_GE(fired[0].second, milliseconds_t{5});
+    EXPECT_GE(fired[1].second, milliseconds_t{70});
+    EXPECT_GE(fired[2].second, milliseconds_t{300});
+    EXPECT_EQ(wheel.size(), 0);
+}
+
+TEST(TimerWheel, Cancel) {
+    ioservice_t ioservice;
+    timer_wheel_t wheel{ioservice};
+
+    size_t fired = 0;
+    auto id = wheel.schedule(milliseconds_t{10}, [&fired]() { fired++; });
+    wheel.schedule(milliseconds_t{20}, [&fired]() { fired += 10; });
+
+    EXPECT_TRUE(wheel.cancel(id));
+    EXPECT_EQ(id, 0);
+    EXPECT_FALSE(wheel.cancel(id));
+
+    ioservice.run();
+
+    EXPECT_EQ(fired, 10);
+}
+
+TEST(TimerWheel, FarTimers) {
+    ioservice_t ioservice;
+    timer_wheel_t wheel{ioservice};
+
+    vector_t<timer_id_t> ids;
+    for (const size_t hours : {1, 5, 100})
+        ids.push_back(wheel.schedule(seconds_t{hours * 3600}, [](){}));
+    EXPECT_EQ(wheel.size(), 3);
+
+    for (auto& id : ids)
+        EXPECT_TRUE(wheel.cancel(id));
+    EXPECT_EQ(wheel.size(), 0);
+
+    ioservice.run();
+}
+
+TEST(TimerWheel, ScheduleFromCallback) {
+    ioservice_t ioservice;
+    timer_wheel_t wheel{ioservice};
+
+    size_t fired = 0;
+    std::function<void()> callback;
+    callback = [&]() {
+        if (++fired < 5)
+            wheel.schedule(milliseconds_t{fired}, std::function<void()>{callback});
+    };
+    wheel.schedule(milliseconds_t{1}, std::function<void()>{callback});
+
+    ioservice.run();
+
+    EXPECT_EQ(fired, 5);
+}